@@ -0,0 +1,239 @@
+#include "augmentation.h"
+#include "gather_kernels.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define AUGMENT_SSE2 1
+    #include <emmintrin.h>
+#else
+    #define AUGMENT_SSE2 0
+#endif
+
+static const size_t MIN_NOISE_TABLE = 1 << 16;
+
+// Small counter-based generator; unlike the <random> distributions its output is the same
+// with every standard library
+static inline uint64_t splitMix64(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Uniform in [0, 1)
+static inline float uniform01(uint64_t& state) {
+    return (float)(splitMix64(state) >> 40) * (1.0f / 16777216.0f);
+}
+
+// Uniform in [-range, range)
+static inline float uniformSymmetric(uint64_t& state, float range) {
+    return (uniform01(state) * 2.0f - 1.0f) * range;
+}
+
+// Per-eye parameters of one sample
+struct EyeAugment {
+    float lut[256];
+    int dx = 0;
+    int dy = 0;
+    bool blur = false;
+};
+
+// Whole plane under a 3x3 binomial blur ([1 2 1] in each direction), clamped at the
+// edges. Each row's vertical sums go to sums[1..r] with the edge sums repeated into
+// sums[0] and sums[r + 1], so the horizontal pass needs no edge cases. Both passes work
+// on 16 bit lanes; the largest sum, 16 * 255 + 8, fits.
+static void blurPlane(const uint8_t* src, int resolution, uint16_t* sums, uint8_t* dst) {
+    const int r = resolution;
+    for (int y = 0; y < r; y++) {
+        const uint8_t* up = src + (size_t)std::max(y - 1, 0) * r;
+        const uint8_t* mid = src + (size_t)y * r;
+        const uint8_t* down = src + (size_t)std::min(y + 1, r - 1) * r;
+        uint8_t* out = dst + (size_t)y * r;
+
+        int x = 0;
+#if AUGMENT_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        for (; x + 16 <= r; x += 16) {
+            __m128i u = _mm_loadu_si128(reinterpret_cast<const __m128i*>(up + x));
+            __m128i m = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mid + x));
+            __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(down + x));
+            __m128i lo = _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(u, zero), _mm_unpacklo_epi8(d, zero)),
+                                       _mm_slli_epi16(_mm_unpacklo_epi8(m, zero), 1));
+            __m128i hi = _mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(u, zero), _mm_unpackhi_epi8(d, zero)),
+                                       _mm_slli_epi16(_mm_unpackhi_epi8(m, zero), 1));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(sums + 1 + x), lo);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(sums + 1 + x + 8), hi);
+        }
+#endif
+        for (; x < r; x++) {
+            sums[1 + x] = (uint16_t)(up[x] + 2 * mid[x] + down[x]);
+        }
+        sums[0] = sums[1];
+        sums[r + 1] = sums[r];
+
+        x = 0;
+#if AUGMENT_SSE2
+        const __m128i round = _mm_set1_epi16(8);
+        for (; x + 16 <= r; x += 16) {
+            __m128i left0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + x));
+            __m128i centre0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + x + 1));
+            __m128i right0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + x + 2));
+            __m128i left1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + x + 8));
+            __m128i centre1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + x + 9));
+            __m128i right1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + x + 10));
+            __m128i lo = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(left0, right0),
+                                                      _mm_add_epi16(_mm_slli_epi16(centre0, 1), round)), 4);
+            __m128i hi = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(left1, right1),
+                                                      _mm_add_epi16(_mm_slli_epi16(centre1, 1), round)), 4);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_packus_epi16(lo, hi));
+        }
+#endif
+        for (; x < r; x++) {
+            out[x] = (uint8_t)((sums[x] + 2 * sums[x + 1] + sums[x + 2] + 8) >> 4);
+        }
+    }
+}
+
+// Table entry plus noise for the pixels a shift uncovers, which repeat the edge pixel
+static void fillEdge(float value, const float* noise, int count, float* dst) {
+    for (int x = 0; x < count; x++) {
+        dst[x] = noise != NULL ? value + noise[x] : value;
+    }
+}
+
+PlaneAugmenter::PlaneAugmenter(const AugmentOptions& options, int resolution, float scale)
+    : m_options(options)
+    , m_resolution(resolution)
+    , m_scale(scale)
+{
+    m_options.shift = std::min(std::max(m_options.shift, 0), resolution - 1);
+
+    // x^gamma is taken as exp(gamma * log x), which costs a fraction of pow per entry
+    m_levelLogs[0] = 0.0f;
+    for (int v = 1; v < 256; v++) {
+        m_levelLogs[v] = std::log(v * (1.0f / 255.0f));
+    }
+
+    if (m_options.noise > 0.0f) {
+        // Each plane reads its noise at a random offset into this table
+        const size_t planeSize = (size_t)resolution * resolution;
+        m_noise.resize(std::max(MIN_NOISE_TABLE, planeSize * 4));
+        uint64_t state = m_options.seed ^ 0x6E6F697365ULL;
+        const float sigma = m_options.noise * scale;
+        for (size_t i = 0; i < m_noise.size(); i += 2) {
+            // Box-Muller
+            const float u1 = std::max(uniform01(state), 1e-7f);
+            const float u2 = uniform01(state);
+            const float radius = std::sqrt(-2.0f * std::log(u1)) * sigma;
+            m_noise[i] = radius * std::cos(6.28318531f * u2);
+            if (i + 1 < m_noise.size()) {
+                m_noise[i + 1] = radius * std::sin(6.28318531f * u2);
+            }
+        }
+    }
+}
+
+void PlaneAugmenter::GatherAugmentPlanes(const uint8_t* const* planes, size_t planeCount, size_t eyeCount,
+                                         uint64_t stream, uint64_t sample, float* dst) const {
+    const int r = m_resolution;
+    const size_t planeSize = (size_t)r * r;
+
+    thread_local std::vector<EyeAugment> eyes;
+    thread_local std::vector<uint16_t> sums;
+    thread_local std::vector<uint8_t> blurred;
+    eyes.resize(eyeCount);
+
+    uint64_t state = m_options.seed ^ (stream * 0xD1B54A32D192ED03ULL) ^ (sample * 0x9E3779B97F4A7C15ULL);
+    splitMix64(state);
+
+    for (EyeAugment& eye : eyes) {
+        const float gain = 1.0f + uniformSymmetric(state, m_options.brightness);
+        const float gamma = std::exp(uniformSymmetric(state, std::log(1.0f + m_options.gamma)));
+        eye.lut[0] = 0.0f;
+        for (int v = 1; v < 256; v++) {
+            const float x = gamma != 1.0f ? std::exp(gamma * m_levelLogs[v]) : v * (1.0f / 255.0f);
+            eye.lut[v] = std::min(std::max(gain * x, 0.0f), 1.0f) * 255.0f * m_scale;
+        }
+        const uint64_t span = 2 * (uint64_t)m_options.shift + 1;
+        eye.dx = (int)(splitMix64(state) % span) - m_options.shift;
+        eye.dy = (int)(splitMix64(state) % span) - m_options.shift;
+        eye.blur = uniform01(state) < m_options.blur;
+    }
+
+    for (size_t i = 0; i < planeCount; i++) {
+        const EyeAugment& eye = eyes[i % eyeCount];
+        const uint8_t* src = planes[i];
+        float* out = dst + i * planeSize;
+
+        const float* noise = NULL;
+        if (!m_noise.empty()) {
+            noise = &m_noise[splitMix64(state) % (m_noise.size() - planeSize + 1)];
+        }
+
+        if (eye.blur) {
+            sums.resize(r + 2);
+            blurred.resize(planeSize);
+            blurPlane(src, r, sums.data(), blurred.data());
+            src = blurred.data();
+        }
+
+        // The shift is applied by where each row is read from: rows clamp to the plane,
+        // and the columns a shift uncovers repeat the edge pixel's value
+        const int dx = eye.dx;
+        const int width = r - std::abs(dx);
+        for (int y = 0; y < r; y++) {
+            const uint8_t* in = src + (size_t)std::min(std::max(y - eye.dy, 0), r - 1) * r;
+            const float* rowNoise = noise != NULL ? noise + (size_t)y * r : NULL;
+            float* row = out + (size_t)y * r;
+            if (dx > 0) {
+                fillEdge(eye.lut[in[0]], rowNoise, dx, row);
+                ConvertLutAddNoise(in, eye.lut, rowNoise != NULL ? rowNoise + dx : NULL, width, row + dx);
+            } else {
+                ConvertLutAddNoise(in - dx, eye.lut, rowNoise, width, row);
+                fillEdge(eye.lut[in[r - 1]], rowNoise != NULL ? rowNoise + width : NULL, -dx, row + width);
+            }
+        }
+    }
+}
+
+void RunAugmentBenchmark(const AugmentOptions& options, size_t planesPerSample, int resolution, int iterations) {
+    const size_t planeSize = (size_t)resolution * resolution;
+    const size_t storePlanes = planesPerSample * 64;
+    std::vector<uint8_t> store(storePlanes * planeSize);
+    uint64_t state = 1234;
+    for (uint8_t& v : store) {
+        v = (uint8_t)(splitMix64(state) & 0xFF);
+    }
+
+    PlaneAugmenter augmenter(options, resolution, 1.0f / 255.0f);
+    std::vector<const uint8_t*> planes(planesPerSample);
+    std::vector<float> output(planesPerSample * planeSize);
+
+    double plainSeconds = 0.0;
+    double augmentSeconds = 0.0;
+    for (int it = 0; it < iterations; it++) {
+        for (const uint8_t*& plane : planes) {
+            plane = &store[(splitMix64(state) % storePlanes) * planeSize];
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        GatherNormalizePlanes(planes.data(), planes.size(), planeSize, 1.0f / 255.0f, output.data());
+        auto middle = std::chrono::steady_clock::now();
+        augmenter.GatherAugmentPlanes(planes.data(), planes.size(), 2, 0, (uint64_t)it, output.data());
+        auto end = std::chrono::steady_clock::now();
+
+        plainSeconds += std::chrono::duration<double>(middle - start).count();
+        augmentSeconds += std::chrono::duration<double>(end - middle).count();
+    }
+
+    printf("Augmentation benchmark (%s): %zu planes of %dx%d per sample, %d samples\n",
+           KernelLevelName(GetKernelLevel()), planesPerSample, resolution, resolution, iterations);
+    printf("  plain     %8.1f us/sample\n", plainSeconds * 1e6 / iterations);
+    printf("  augmented %8.1f us/sample  (+%.1f us)\n", augmentSeconds * 1e6 / iterations,
+           (augmentSeconds - plainSeconds) * 1e6 / iterations);
+}
@@ -0,0 +1,57 @@
+// augmentation.h
+#ifndef AUGMENTATION_H
+#define AUGMENTATION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Strength of each augmentation; 0 disables that one
+struct AugmentOptions {
+    bool enabled = false;
+    uint64_t seed = 1;
+    float brightness = 0.2f;   // gain drawn from [1 - brightness, 1 + brightness]
+    float gamma = 0.25f;       // gamma drawn log-uniformly from [1 / (1 + gamma), 1 + gamma]
+    float noise = 2.0f;        // Gaussian sensor noise sigma in 8-bit levels
+    int shift = 4;             // translation of up to this many pixels in x and y
+    float blur = 0.2f;         // probability of a 3x3 binomial blur
+};
+
+/**
+ * @brief Random photometric and geometric augmentation fused into batch assembly
+ *
+ * Replaces GatherNormalizePlanes for training samples. Each output row is read from the
+ * translated (and optionally blurred) 8-bit plane and converted through a 256-entry table
+ * that folds brightness, gamma and the normalisation scale together, with noise from a
+ * precomputed table added in the same pass. The conversion uses the gather kernel level.
+ *
+ * Parameters are drawn per eye from (seed, stream, sample) only, so a sample looks the
+ * same whichever loader thread assembles it and however many there are. Every frame of a
+ * window shares its eye's brightness, gamma, shift and blur, as a change of lighting or
+ * headset fit would; the noise differs per frame. Safe to use from several threads.
+ */
+class PlaneAugmenter {
+public:
+    // scale is applied after augmentation, as in GatherNormalizePlanes
+    PlaneAugmenter(const AugmentOptions& options, int resolution, float scale);
+
+    // planes as for GatherNormalizePlanes; plane i belongs to eye i % eyeCount. stream
+    // separates epochs, sample identifies the window within one.
+    void GatherAugmentPlanes(const uint8_t* const* planes, size_t planeCount, size_t eyeCount,
+                             uint64_t stream, uint64_t sample, float* dst) const;
+
+    const AugmentOptions& GetOptions() const { return m_options; }
+
+private:
+    AugmentOptions m_options;
+    int m_resolution;
+    float m_scale;
+    std::vector<float> m_noise;  // unit Gaussian noise * sigma * scale
+    float m_levelLogs[256];      // log(v / 255), 0 for v = 0
+};
+
+// Times plain and augmented assembly of single samples on one thread and prints the
+// overhead per sample
+void RunAugmentBenchmark(const AugmentOptions& options, size_t planesPerSample, int resolution, int iterations);
+
+#endif // AUGMENTATION_H
@@ -0,0 +1,157 @@
+#include "batch_loader.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "thread_planner.h"
+
+BatchLoader::BatchLoader(size_t imageFloatsPerSample, size_t labelFloatsPerSample, size_t batchSize,
+                         size_t workerCount, size_t poolSize, SampleFiller filler)
+    : m_imageFloats(imageFloatsPerSample),
+      m_labelFloats(labelFloatsPerSample),
+      m_batchSize(std::max<size_t>(batchSize, 1)),
+      m_filler(filler) {
+    if (workerCount == 0) {
+        workerCount = std::max<size_t>(std::thread::hardware_concurrency() / 2, 1);
+    }
+    if (poolSize == 0) {
+        poolSize = workerCount + 2;
+    }
+    // One batch in training plus at least one being assembled
+    poolSize = std::max<size_t>(poolSize, 2);
+
+    for (size_t i = 0; i < poolSize; i++) {
+        std::unique_ptr<TrainingBatch> batch(new TrainingBatch());
+        batch->images.resize(m_batchSize * m_imageFloats);
+        batch->labels.resize(m_batchSize * m_labelFloats);
+        batch->slot = i;
+        m_free.push_back(batch.get());
+        m_pool.push_back(std::move(batch));
+    }
+
+    for (size_t i = 0; i < workerCount; i++) {
+        m_workers.emplace_back(&BatchLoader::workerLoop, this);
+    }
+}
+
+BatchLoader::~BatchLoader() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_workAvailable.notify_all();
+    for (std::thread& worker : m_workers) {
+        worker.join();
+    }
+}
+
+void BatchLoader::StartEpoch(const std::vector<size_t>& order) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    // Stop handing out jobs of the old epoch and wait for the ones in flight
+    m_nextJob = m_batchCount;
+    m_idle.wait(lock, [this]() { return m_inFlight == 0; });
+
+    for (auto& entry : m_ready) {
+        m_free.push_back(entry.second);
+    }
+    m_ready.clear();
+
+    m_order = order;
+    m_batchCount = (m_order.size() + m_batchSize - 1) / m_batchSize;
+    m_nextJob = 0;
+    m_nextDelivery = 0;
+
+    lock.unlock();
+    m_workAvailable.notify_all();
+}
+
+TrainingBatch* BatchLoader::Next() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_nextDelivery >= m_batchCount) {
+        return nullptr;
+    }
+
+    auto waitStart = std::chrono::steady_clock::now();
+    m_batchReady.wait(lock, [this]() { return m_ready.count(m_nextDelivery) != 0; });
+    const double waited = std::chrono::duration<double>(std::chrono::steady_clock::now() - waitStart).count();
+    m_waitSeconds += waited;
+
+    auto it = m_ready.find(m_nextDelivery);
+    TrainingBatch* batch = it->second;
+    batch->waitSeconds = waited;
+    m_ready.erase(it);
+    m_nextDelivery++;
+    return batch;
+}
+
+void BatchLoader::Release(TrainingBatch* batch) {
+    if (!batch) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_free.push_back(batch);
+    }
+    m_workAvailable.notify_one();
+}
+
+double BatchLoader::GetWaitSeconds() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_waitSeconds;
+}
+
+void BatchLoader::workerLoop() {
+    PinWorkerThread(ThreadRole::Loader);
+
+    std::vector<size_t> samples;
+    samples.reserve(m_batchSize);
+
+    while (true) {
+        TrainingBatch* batch = nullptr;
+        size_t jobIndex = 0;
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_workAvailable.wait(lock, [this]() {
+                return m_stop || (m_nextJob < m_batchCount && !m_free.empty());
+            });
+            if (m_stop) {
+                return;
+            }
+
+            jobIndex = m_nextJob++;
+            batch = m_free.back();
+            m_free.pop_back();
+            m_inFlight++;
+
+            size_t first = jobIndex * m_batchSize;
+            size_t last = std::min(first + m_batchSize, m_order.size());
+            samples.assign(m_order.begin() + first, m_order.begin() + last);
+        }
+
+        // Fill outside the lock; rejected samples are overwritten by the next one
+        batch->index = jobIndex;
+        batch->count = 0;
+        batch->dropped = 0;
+        auto fillStart = std::chrono::steady_clock::now();
+        for (size_t sample : samples) {
+            float* images = batch->images.data() + batch->count * m_imageFloats;
+            float* labels = batch->labels.data() + batch->count * m_labelFloats;
+            if (m_filler(sample, images, labels)) {
+                batch->count++;
+            } else {
+                batch->dropped++;
+            }
+        }
+        batch->fillSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - fillStart).count();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_ready[jobIndex] = batch;
+            m_inFlight--;
+        }
+        m_batchReady.notify_all();
+        m_idle.notify_all();
+    }
+}
@@ -0,0 +1,103 @@
+// batch_loader.h
+#ifndef BATCH_LOADER_H
+#define BATCH_LOADER_H
+
+#include <cstddef>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// One assembled training batch. Buffers are sized for a full batch once and reused.
+struct TrainingBatch {
+    std::vector<float> images;  // count * imageFloatsPerSample floats
+    std::vector<float> labels;  // count * labelFloatsPerSample floats
+    size_t count = 0;           // samples filled; the last batch of an epoch may be short
+    size_t index = 0;           // batch number within the epoch
+    size_t dropped = 0;         // samples the filler rejected
+    size_t slot = 0;            // fixed position in the loader's pool
+    double fillSeconds = 0.0;   // worker time spent assembling it
+    double waitSeconds = 0.0;   // time Next() blocked before handing it out
+};
+
+/**
+ * @brief Prefetching batch assembler for the trainer
+ *
+ * A fixed pool of pre-allocated batches circulates between worker threads and the
+ * training loop. Workers take the next batch number of the epoch, fill its samples
+ * through the sample filler and queue it; Next() hands batches out strictly in order,
+ * so results do not depend on the worker count. While the caller trains on batch N,
+ * the workers are already assembling N+1 and beyond.
+ */
+class BatchLoader {
+public:
+    // Fills one sample into the given image and label slots. Called concurrently from
+    // worker threads. Return false to drop the sample (e.g. non-finite labels).
+    using SampleFiller = std::function<bool(size_t sampleIndex, float* images, float* labels)>;
+
+    // workerCount and poolSize of 0 pick defaults (half the hardware threads, and
+    // workerCount + 2 batches respectively)
+    BatchLoader(size_t imageFloatsPerSample, size_t labelFloatsPerSample, size_t batchSize,
+                size_t workerCount, size_t poolSize, SampleFiller filler);
+    ~BatchLoader();
+
+    BatchLoader(const BatchLoader&) = delete;
+    BatchLoader& operator=(const BatchLoader&) = delete;
+
+    // Start assembling an epoch over the given sample order. Any batches of a previous
+    // epoch that were not consumed are discarded.
+    void StartEpoch(const std::vector<size_t>& order);
+
+    // Next batch of the epoch in order, blocking until it is ready; nullptr at the end
+    TrainingBatch* Next();
+
+    // Hand a batch from Next() back to the pool
+    void Release(TrainingBatch* batch);
+
+    size_t GetBatchCount() const { return m_batchCount; }
+    size_t GetBatchSize() const { return m_batchSize; }
+    size_t GetWorkerCount() const { return m_workers.size(); }
+    size_t GetPoolSize() const { return m_pool.size(); }
+    // Bytes of the pooled batch buffers
+    size_t GetMemoryBytes() const { return m_pool.size() * m_batchSize * (m_imageFloats + m_labelFloats) * sizeof(float); }
+
+    // Pooled batch by slot. The buffer addresses never change, so callers can bind
+    // tensors to them once up front; the contents are only valid between Next() and
+    // Release().
+    TrainingBatch& GetPoolBatch(size_t slot) { return *m_pool[slot]; }
+
+    // Total time Next() spent waiting for a batch since construction; near zero when
+    // assembly keeps up with training
+    double GetWaitSeconds() const;
+
+private:
+    void workerLoop();
+
+    const size_t m_imageFloats;
+    const size_t m_labelFloats;
+    const size_t m_batchSize;
+    SampleFiller m_filler;
+
+    std::vector<std::unique_ptr<TrainingBatch>> m_pool;
+    std::vector<std::thread> m_workers;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_workAvailable;   // workers: a job and a free batch exist
+    std::condition_variable m_batchReady;      // consumer: the next batch was queued
+    std::condition_variable m_idle;            // StartEpoch: no job is in flight
+
+    std::vector<size_t> m_order;
+    std::vector<TrainingBatch*> m_free;
+    std::map<size_t, TrainingBatch*> m_ready;
+    size_t m_batchCount = 0;
+    size_t m_nextJob = 0;
+    size_t m_nextDelivery = 0;
+    size_t m_inFlight = 0;
+    bool m_stop = false;
+    double m_waitSeconds = 0.0;
+};
+
+#endif // BATCH_LOADER_H
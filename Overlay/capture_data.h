@@ -21,7 +21,8 @@ typedef struct CaptureFrame {
     float routineSquint;
     float routineDilate; // display fully black screen, fully white screen. This should trigger dilation
     
-    // Timestamp information
+    // Timestamp information (host monotonic microseconds when the file header has
+    // CAPTURE_FLAG_HOST_US set, otherwise legacy milliseconds in mixed clock domains)
     uint64_t timestamp;
     uint64_t timestamp_left;
     uint64_t timestamp_right;
@@ -35,3 +36,18 @@ typedef struct CaptureFrame {
     #pragma pack(pop)
 #endif
 } CaptureFrame;
+
+
+// Optional header at the start of a capture file. Files without it are legacy
+// captures whose timestamps are unsynchronised milliseconds.
+#define CAPTURE_FILE_MAGIC      "BBCAPT01"
+#define CAPTURE_FILE_VERSION    1
+
+#define CAPTURE_FLAG_HOST_US    (1U << 0)  // timestamps are camera-corrected host microseconds
+#define CAPTURE_FLAG_COMPLETE   (1U << 1)  // set in place by the writer once the routine has ended
+
+typedef struct CaptureFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+} CaptureFileHeader;
\ No newline at end of file
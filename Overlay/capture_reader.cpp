@@ -8,104 +8,46 @@
 #include <limits>
 #include <string>
 #include <tuple>
+#include <cstring>
+#include <iterator>
 #include <turbojpeg.h>
 #include "capture_data.h"
 #include "capture_reader.h"
 
+typedef std::tuple<float, float, float, float, float, float, float, float, float, float, float, uint32_t> CaptureLabel;
+typedef std::pair<uint64_t, std::vector<uint8_t>> TimedImage;
+
 struct PotentialMatch {
     uint64_t label_ts;
-    std::tuple<float, float, float, float, float, float, float, float, float, float, float, uint32_t> label_data;
-    std::tuple<size_t, uint64_t, std::vector<uint8_t>> left_match;
-    std::tuple<size_t, uint64_t, std::vector<uint8_t>> right_match;
+    CaptureLabel label_data;
+    std::pair<size_t, uint64_t> left_match;   // image index, timestamp
+    std::pair<size_t, uint64_t> right_match;
     uint64_t quality;
 };
 
-std::vector<AlignedFrame> read_capture_file(const std::string& filename) {
-    // Store all frames without assuming alignment
-    std::map<uint64_t, std::vector<uint8_t>> all_eye_frames_left;  // video_timestamp_left -> image_data
-    std::map<uint64_t, std::vector<uint8_t>> all_eye_frames_right; // video_timestamp_right -> image_data
-    std::map<uint64_t, std::tuple<float, float, float, float, float, float, float, float, float, float, float, uint32_t>> all_label_frames; // timestamp -> label_data
-    
-    int raw_frames = 0;
-    
-    // Read the raw data from file
-    std::ifstream file(filename, std::ios::binary);
-    if (!file.is_open()) {
-        std::cerr << "Failed to open file: " << filename << std::endl;
-        return {};
-    }
-    
-    while (file.good()) {
-        CaptureFrame frame;
-        
-        // Read the frame metadata
-        if (!file.read(reinterpret_cast<char*>(&frame), sizeof(CaptureFrame))) {
-            if (file.eof()) {
-                std::cout << "Breaking - end of file reached" << std::endl;
-            } else {
-                std::cerr << "Error reading frame metadata" << std::endl;
-            }
-            break;
-        }
-        
-        // Read the image data
-        std::vector<uint8_t> image_left_data(frame.jpeg_data_left_length);
-        std::vector<uint8_t> image_right_data(frame.jpeg_data_right_length);
-        
-        if (!file.read(reinterpret_cast<char*>(image_left_data.data()), frame.jpeg_data_left_length) ||
-            !file.read(reinterpret_cast<char*>(image_right_data.data()), frame.jpeg_data_right_length)) {
-            std::cerr << "Error reading image data" << std::endl;
-            break;
-        }
-        
-        raw_frames++;
-        
-        // Store all frame data
-        all_eye_frames_left[frame.timestamp_left] = image_left_data;
-        all_eye_frames_right[frame.timestamp_right] = image_right_data;
-        all_label_frames[frame.timestamp] = std::make_tuple(
-            frame.routinePitch, frame.routineYaw, frame.routineDistance, 
-            frame.fovAdjustDistance, frame.routineLeftLid, frame.routineRightLid,
-            frame.routineBrowRaise, frame.routineBrowAngry, frame.routineWiden, 
-            frame.routineSquint, frame.routineDilate, frame.routineState
-        );
-        
-        /*std::cout << "Read frame: Pitch=" << frame.routinePitch
-                  << ", Yaw=" << frame.routineYaw
-                  << ", sizeRight=" << image_right_data.size()
-                  << ", sizeLeft=" << image_left_data.size()
-                  << ", timeData=" << frame.timestamp
-                  << ", timeLeft=" << frame.timestamp_left
-                  << ", timeRight=" << frame.timestamp_right << std::endl;*/
-    }
-    
-    std::cout << "Detected " << raw_frames << " raw frames" << std::endl;
-    std::cout << "Unique left eye frames: " << all_eye_frames_left.size() << std::endl;
-    std::cout << "Unique right eye frames: " << all_eye_frames_right.size() << std::endl;
-    std::cout << "Unique label frames: " << all_label_frames.size() << std::endl;
-    
-    // Convert to sorted vectors for processing
-    std::vector<std::pair<uint64_t, std::vector<uint8_t>>> left_frames;
-    for (const auto& pair : all_eye_frames_left) {
-        left_frames.push_back(pair);
-    }
-    std::sort(left_frames.begin(), left_frames.end());
-    
-    std::vector<std::pair<uint64_t, std::vector<uint8_t>>> right_frames;
-    for (const auto& pair : all_eye_frames_right) {
-        right_frames.push_back(pair);
-    }
-    std::sort(right_frames.begin(), right_frames.end());
-    
-    std::vector<std::pair<uint64_t, std::tuple<float, float, float, float, float, float, float, float, float, float, float, uint32_t>>> label_frames;
-    for (const auto& pair : all_label_frames) {
-        label_frames.push_back(pair);
-    }
-    std::sort(label_frames.begin(), label_frames.end());
-    
-    // Track which frames have been used
-    std::set<size_t> used_left_frames;
-    std::set<size_t> used_right_frames;
+// With synchronised clocks a camera frame further than this from its label is a dropped
+// frame, not a match. Legacy captures keep the unbounded nearest-neighbour search.
+static const uint64_t kSyncedAlignmentWindowUs = 25000;
+
+static CaptureLabel labelFromRecord(const CaptureFrame& frame) {
+    return std::make_tuple(
+        frame.routinePitch, frame.routineYaw, frame.routineDistance, 
+        frame.fovAdjustDistance, frame.routineLeftLid, frame.routineRightLid,
+        frame.routineBrowRaise, frame.routineBrowAngry, frame.routineWiden, 
+        frame.routineSquint, frame.routineDilate, frame.routineState
+    );
+}
+
+// Match every label to its nearest left and right image within max_deviation, best pairs
+// first, so no image is used twice. Images taken are flagged in left_used / right_used.
+// Returns the aligned frames sorted by label timestamp.
+static std::vector<AlignedFrame> alignCaptureFrames(const std::vector<std::pair<uint64_t, CaptureLabel>>& label_frames,
+                                                    const std::vector<TimedImage>& left_frames,
+                                                    const std::vector<TimedImage>& right_frames,
+                                                    uint64_t max_deviation,
+                                                    std::vector<char>& left_used, std::vector<char>& right_used) {
+    left_used.assign(left_frames.size(), 0);
+    right_used.assign(right_frames.size(), 0);
     
     // Store potential matches for each label
     std::vector<PotentialMatch> potential_matches;
@@ -114,17 +56,12 @@ std::vector<AlignedFrame> read_capture_file(const std::string& filename) {
         uint64_t label_ts = label_pair.first;
         const auto& label_data = label_pair.second;
         
-        // Find the best available left frame
+        // Find the best left frame
         size_t best_left_idx = 0;
         uint64_t best_left_ts = 0;
-        std::vector<uint8_t> best_left_img;
         uint64_t best_left_deviation = std::numeric_limits<uint64_t>::max();
         
         for (size_t left_idx = 0; left_idx < left_frames.size(); left_idx++) {
-            if (used_left_frames.find(left_idx) != used_left_frames.end()) {
-                continue;
-            }
-            
             uint64_t left_ts = left_frames[left_idx].first;
             uint64_t deviation = (left_ts > label_ts) ? (left_ts - label_ts) : (label_ts - left_ts);
             
@@ -132,21 +69,15 @@ std::vector<AlignedFrame> read_capture_file(const std::string& filename) {
                 best_left_deviation = deviation;
                 best_left_idx = left_idx;
                 best_left_ts = left_ts;
-                best_left_img = left_frames[left_idx].second;
             }
         }
         
-        // Find the best available right frame
+        // Find the best right frame
         size_t best_right_idx = 0;
         uint64_t best_right_ts = 0;
-        std::vector<uint8_t> best_right_img;
         uint64_t best_right_deviation = std::numeric_limits<uint64_t>::max();
         
         for (size_t right_idx = 0; right_idx < right_frames.size(); right_idx++) {
-            if (used_right_frames.find(right_idx) != used_right_frames.end()) {
-                continue;
-            }
-            
             uint64_t right_ts = right_frames[right_idx].first;
             uint64_t deviation = (right_ts > label_ts) ? (right_ts - label_ts) : (label_ts - right_ts);
             
@@ -154,20 +85,19 @@ std::vector<AlignedFrame> read_capture_file(const std::string& filename) {
                 best_right_deviation = deviation;
                 best_right_idx = right_idx;
                 best_right_ts = right_ts;
-                best_right_img = right_frames[right_idx].second;
             }
         }
         
         // Store this potential match with its quality metric (sum of deviations)
-        if (!best_left_img.empty() && !best_right_img.empty()) {
-            uint64_t match_quality = best_left_deviation + best_right_deviation;
-            
+        if (!left_frames.empty() && !right_frames.empty() &&
+            !left_frames[best_left_idx].second.empty() && !right_frames[best_right_idx].second.empty() &&
+            best_left_deviation <= max_deviation && best_right_deviation <= max_deviation) {
             PotentialMatch match;
             match.label_ts = label_ts;
             match.label_data = label_data;
-            match.left_match = std::make_tuple(best_left_idx, best_left_ts, best_left_img);
-            match.right_match = std::make_tuple(best_right_idx, best_right_ts, best_right_img);
-            match.quality = match_quality;
+            match.left_match = std::make_pair(best_left_idx, best_left_ts);
+            match.right_match = std::make_pair(best_right_idx, best_right_ts);
+            match.quality = best_left_deviation + best_right_deviation;
             
             potential_matches.push_back(match);
         }
@@ -187,20 +117,19 @@ std::vector<AlignedFrame> read_capture_file(const std::string& filename) {
         size_t right_idx = std::get<0>(match.right_match);
         
         // Skip if either frame has already been used
-        if (used_left_frames.find(left_idx) != used_left_frames.end() || 
-            used_right_frames.find(right_idx) != used_right_frames.end()) {
+        if (left_used[left_idx] || right_used[right_idx]) {
             continue;
         }
         
         // Mark these frames as used
-        used_left_frames.insert(left_idx);
-        used_right_frames.insert(right_idx);
+        left_used[left_idx] = 1;
+        right_used[right_idx] = 1;
         
         // Add to final frames
         AlignedFrame aligned_frame;
         aligned_frame.label_data = match.label_data;
-        aligned_frame.left_image = std::get<2>(match.left_match);
-        aligned_frame.right_image = std::get<2>(match.right_match);
+        aligned_frame.left_image = left_frames[left_idx].second;
+        aligned_frame.right_image = right_frames[right_idx].second;
         aligned_frame.label_timestamp = match.label_ts;
         
         final_frames.push_back(aligned_frame);
@@ -212,6 +141,114 @@ std::vector<AlignedFrame> read_capture_file(const std::string& filename) {
                   return a.label_timestamp < b.label_timestamp;
               });
     
+    return final_frames;
+}
+
+std::vector<AlignedFrame> read_capture_file(const std::string& filename, CaptureReadTiming* timing) {
+    auto read_start = std::chrono::steady_clock::now();
+    
+    // Store all frames without assuming alignment
+    std::map<uint64_t, std::vector<uint8_t>> all_eye_frames_left;  // video_timestamp_left -> image_data
+    std::map<uint64_t, std::vector<uint8_t>> all_eye_frames_right; // video_timestamp_right -> image_data
+    std::map<uint64_t, CaptureLabel> all_label_frames; // timestamp -> label_data
+    
+    int raw_frames = 0;
+    
+    // Read the raw data from file
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file: " << filename << std::endl;
+        return {};
+    }
+    
+    // Newer captures start with a header; legacy ones start directly with a frame
+    bool host_us_timestamps = false;
+    CaptureFileHeader file_header;
+    if (file.read(reinterpret_cast<char*>(&file_header), sizeof(file_header)) &&
+        memcmp(file_header.magic, CAPTURE_FILE_MAGIC, sizeof(file_header.magic)) == 0) {
+        host_us_timestamps = (file_header.flags & CAPTURE_FLAG_HOST_US) != 0;
+        std::cout << "Capture file version " << file_header.version
+                  << (host_us_timestamps ? " (synchronised host clock)" : "") << std::endl;
+    } else {
+        file.clear();
+        file.seekg(0);
+    }
+
+    // Everything below works in microseconds
+    const uint64_t timestamp_scale = host_us_timestamps ? 1 : 1000;
+    const uint64_t max_deviation = host_us_timestamps ? kSyncedAlignmentWindowUs
+                                                      : std::numeric_limits<uint64_t>::max();
+
+    while (file.good()) {
+        CaptureFrame frame;
+        
+        // Read the frame metadata
+        if (!file.read(reinterpret_cast<char*>(&frame), sizeof(CaptureFrame))) {
+            if (file.eof()) {
+                std::cout << "Breaking - end of file reached" << std::endl;
+            } else {
+                std::cerr << "Error reading frame metadata" << std::endl;
+            }
+            break;
+        }
+        
+        // Read the image data
+        std::vector<uint8_t> image_left_data(frame.jpeg_data_left_length);
+        std::vector<uint8_t> image_right_data(frame.jpeg_data_right_length);
+        
+        if (!file.read(reinterpret_cast<char*>(image_left_data.data()), frame.jpeg_data_left_length) ||
+            !file.read(reinterpret_cast<char*>(image_right_data.data()), frame.jpeg_data_right_length)) {
+            std::cerr << "Error reading image data" << std::endl;
+            break;
+        }
+        
+        raw_frames++;
+        
+        // Store all frame data
+        all_eye_frames_left[frame.timestamp_left * timestamp_scale] = image_left_data;
+        all_eye_frames_right[frame.timestamp_right * timestamp_scale] = image_right_data;
+        all_label_frames[frame.timestamp * timestamp_scale] = labelFromRecord(frame);
+        
+        /*std::cout << "Read frame: Pitch=" << frame.routinePitch
+                  << ", Yaw=" << frame.routineYaw
+                  << ", sizeRight=" << image_right_data.size()
+                  << ", sizeLeft=" << image_left_data.size()
+                  << ", timeData=" << frame.timestamp
+                  << ", timeLeft=" << frame.timestamp_left
+                  << ", timeRight=" << frame.timestamp_right << std::endl;*/
+    }
+    
+    std::cout << "Detected " << raw_frames << " raw frames" << std::endl;
+    std::cout << "Unique left eye frames: " << all_eye_frames_left.size() << std::endl;
+    std::cout << "Unique right eye frames: " << all_eye_frames_right.size() << std::endl;
+    std::cout << "Unique label frames: " << all_label_frames.size() << std::endl;
+    
+    // Convert to sorted vectors for processing
+    std::vector<TimedImage> left_frames;
+    for (const auto& pair : all_eye_frames_left) {
+        left_frames.push_back(pair);
+    }
+    std::sort(left_frames.begin(), left_frames.end());
+    
+    std::vector<TimedImage> right_frames;
+    for (const auto& pair : all_eye_frames_right) {
+        right_frames.push_back(pair);
+    }
+    std::sort(right_frames.begin(), right_frames.end());
+    
+    auto align_start = std::chrono::steady_clock::now();
+    
+    std::vector<std::pair<uint64_t, CaptureLabel>> label_frames;
+    for (const auto& pair : all_label_frames) {
+        label_frames.push_back(pair);
+    }
+    std::sort(label_frames.begin(), label_frames.end());
+    
+    std::vector<char> used_left_frames;
+    std::vector<char> used_right_frames;
+    std::vector<AlignedFrame> final_frames = alignCaptureFrames(label_frames, left_frames, right_frames, max_deviation,
+                                                                used_left_frames, used_right_frames);
+    
     // Calculate final statistics
     if (!final_frames.empty()) {
         uint64_t total_left_deviation = 0;
@@ -246,15 +283,172 @@ std::vector<AlignedFrame> read_capture_file(const std::string& filename) {
         double avg_right_deviation = static_cast<double>(total_right_deviation) / final_frames.size();
         
         std::cout << "Aligned " << final_frames.size() << " frames" << std::endl;
-        std::cout << "Average deviation: left: " << avg_left_deviation << "ms, right: " 
-                  << avg_right_deviation << "ms" << std::endl;
+        std::cout << "Average deviation: left: " << avg_left_deviation / 1000.0 << "ms, right: " 
+                  << avg_right_deviation / 1000.0 << "ms" << std::endl;
     } else {
         std::cout << "No frames could be aligned" << std::endl;
     }
     
+    if (timing != nullptr) {
+        auto align_end = std::chrono::steady_clock::now();
+        timing->readSeconds = std::chrono::duration<double>(align_start - read_start).count();
+        timing->alignSeconds = std::chrono::duration<double>(align_end - align_start).count();
+    }
     return final_frames;
 }
 
+bool CaptureFollower::Open(const std::string& filename) {
+    m_filename = filename;
+    m_file.open(filename, std::ios::binary);
+    m_lastGrowth = std::chrono::steady_clock::now();
+    return m_file.is_open();
+}
+
+double CaptureFollower::IdleSeconds() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_lastGrowth).count();
+}
+
+bool CaptureFollower::readHeader(bool& complete) {
+    CaptureFileHeader file_header;
+    m_file.clear();
+    m_file.seekg(0);
+    bool has_header = m_file.read(reinterpret_cast<char*>(&file_header), sizeof(file_header)) &&
+                      memcmp(file_header.magic, CAPTURE_FILE_MAGIC, sizeof(file_header.magic)) == 0;
+
+    // Flags first: once the writer marks the file complete, the size read below is final
+    if (has_header && (file_header.flags & CAPTURE_FLAG_COMPLETE)) {
+        complete = true;
+    }
+
+    m_file.clear();
+    m_file.seekg(0, std::ios::end);
+    uint64_t size = (uint64_t)m_file.tellg();
+    if (size > m_size) {
+        m_size = size;
+        m_lastGrowth = std::chrono::steady_clock::now();
+    }
+
+    if (!m_headerRead) {
+        if (m_size < sizeof(CaptureFileHeader)) {
+            return false;  // nothing written yet
+        }
+        m_hostUs = has_header && (file_header.flags & CAPTURE_FLAG_HOST_US) != 0;
+        m_offset = has_header ? sizeof(CaptureFileHeader) : 0;
+        m_headerRead = true;
+        std::cout << "Following capture " << m_filename
+                  << (m_hostUs ? " (synchronised host clock)" : " (legacy timestamps, aligned when complete)") << std::endl;
+    }
+    return true;
+}
+
+void CaptureFollower::readRecords() {
+    const uint64_t timestamp_scale = m_hostUs ? 1 : 1000;
+
+    while (m_offset + sizeof(CaptureFrame) <= m_size) {
+        CaptureFrame frame;
+        m_file.clear();
+        m_file.seekg((std::streamoff)m_offset);
+        if (!m_file.read(reinterpret_cast<char*>(&frame), sizeof(CaptureFrame))) {
+            break;
+        }
+
+        // The writer may still be in the middle of this record
+        const uint64_t end = m_offset + sizeof(CaptureFrame) + frame.jpeg_data_left_length + frame.jpeg_data_right_length;
+        if (end > m_size) {
+            break;
+        }
+
+        std::vector<uint8_t> image_left_data(frame.jpeg_data_left_length);
+        std::vector<uint8_t> image_right_data(frame.jpeg_data_right_length);
+        if (!m_file.read(reinterpret_cast<char*>(image_left_data.data()), frame.jpeg_data_left_length) ||
+            !m_file.read(reinterpret_cast<char*>(image_right_data.data()), frame.jpeg_data_right_length)) {
+            break;
+        }
+
+        m_left[frame.timestamp_left * timestamp_scale] = std::move(image_left_data);
+        m_right[frame.timestamp_right * timestamp_scale] = std::move(image_right_data);
+        m_labels[frame.timestamp * timestamp_scale] = labelFromRecord(frame);
+        m_offset = end;
+        m_rawFrames++;
+    }
+}
+
+size_t CaptureFollower::Poll(std::vector<AlignedFrame>& frames) {
+    if (m_finished || !m_file.is_open()) {
+        return 0;
+    }
+
+    bool complete = m_forceComplete;
+    if (!readHeader(complete)) {
+        return 0;
+    }
+    readRecords();
+
+    // Piecewise alignment needs bounded deviations, so legacy captures wait for the end
+    if (!m_hostUs && !complete) {
+        return 0;
+    }
+    const uint64_t max_deviation = m_hostUs ? kSyncedAlignmentWindowUs : std::numeric_limits<uint64_t>::max();
+
+    // A label further than twice the window behind the newest one cannot gain a closer
+    // image from records still to come
+    uint64_t horizon = std::numeric_limits<uint64_t>::max();
+    if (!complete) {
+        if (m_labels.empty() || m_labels.rbegin()->first < 2 * max_deviation) {
+            return 0;
+        }
+        horizon = m_labels.rbegin()->first - 2 * max_deviation;
+    }
+
+    auto label_end = complete ? m_labels.end() : m_labels.upper_bound(horizon);
+    std::vector<std::pair<uint64_t, CaptureLabel>> label_frames(m_labels.begin(), label_end);
+    m_labels.erase(m_labels.begin(), label_end);
+
+    std::vector<AlignedFrame> aligned;
+    if (!label_frames.empty()) {
+        std::vector<TimedImage> left_frames, right_frames;
+        for (auto& pair : m_left) {
+            left_frames.emplace_back(pair.first, std::move(pair.second));
+        }
+        for (auto& pair : m_right) {
+            right_frames.emplace_back(pair.first, std::move(pair.second));
+        }
+        m_left.clear();
+        m_right.clear();
+
+        std::vector<char> used_left_frames;
+        std::vector<char> used_right_frames;
+        aligned = alignCaptureFrames(label_frames, left_frames, right_frames, max_deviation,
+                                     used_left_frames, used_right_frames);
+
+        // Keep unused images that a later label could still reach
+        if (!complete) {
+            const uint64_t keep_from = horizon > max_deviation ? horizon - max_deviation : 0;
+            for (size_t i = 0; i < left_frames.size(); i++) {
+                if (!used_left_frames[i] && left_frames[i].first >= keep_from) {
+                    m_left[left_frames[i].first] = std::move(left_frames[i].second);
+                }
+            }
+            for (size_t i = 0; i < right_frames.size(); i++) {
+                if (!used_right_frames[i] && right_frames[i].first >= keep_from) {
+                    m_right[right_frames[i].first] = std::move(right_frames[i].second);
+                }
+            }
+        }
+    }
+
+    frames.insert(frames.end(), std::make_move_iterator(aligned.begin()), std::make_move_iterator(aligned.end()));
+    m_alignedFrames += aligned.size();
+
+    if (complete) {
+        m_finished = true;
+        m_left.clear();
+        m_right.clear();
+        std::cout << "Capture complete: " << m_rawFrames << " raw frames, " << m_alignedFrames << " aligned" << std::endl;
+    }
+    return aligned.size();
+}
+
 bool AlignedFrame::DecodeImageLeft(std::vector<uint32_t>& rgb_buffer, int& width, int& height) const {
     // Check if we have cached data
     if (has_decoded_left) {
@@ -320,6 +514,10 @@ bool AlignedFrame::DecodeImageRight(std::vector<uint32_t>& rgb_buffer, int& widt
     return result;
 }
 
+bool AlignedFrame::DecodeImage(bool right_eye, std::vector<uint32_t>& rgb_buffer, int& width, int& height) const {
+    return DecodeJpegData(right_eye ? right_image : left_image, rgb_buffer, width, height);
+}
+
 // Helper method for JPEG decoding using libturbojpeg
 bool AlignedFrame::DecodeJpegData(const std::vector<uint8_t>& jpeg_data, 
                                  std::vector<uint32_t>& pixel_buffer, 
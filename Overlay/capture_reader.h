@@ -4,6 +4,9 @@
 #include <vector>
 #include <string>
 #include <tuple>
+#include <map>
+#include <chrono>
+#include <fstream>
 #include <cstdint>
 #include "capture_data.h"
 
@@ -12,13 +15,23 @@ struct AlignedFrame {
     std::tuple<float, float, float, float, float, float, float, float, float, float, float, uint32_t> label_data; // (pitch, yaw, distance, fovAdjust, leftLid, rightLid, browRaise, browAngry, widen, squint, dilate, state)
     std::vector<uint8_t> left_image;  // JPEG data
     std::vector<uint8_t> right_image; // JPEG data
-    uint64_t label_timestamp;
+    uint64_t label_timestamp;         // microseconds (legacy millisecond captures are scaled on load)
 
     // Decode the left eye image to RGB pixels
     bool DecodeImageLeft(std::vector<uint32_t>& rgb_buffer, int& width, int& height) const;
     
     // Decode the right eye image to RGB pixels
     bool DecodeImageRight(std::vector<uint32_t>& rgb_buffer, int& width, int& height) const;
+
+    // Decode either eye without touching the per-frame cache. Safe to call from several
+    // threads at once, including on the same frame.
+    bool DecodeImage(bool right_eye, std::vector<uint32_t>& rgb_buffer, int& width, int& height) const;
+
+    // Heap bytes held by the JPEG payloads and the decode cache
+    size_t GetMemoryBytes() const {
+        return left_image.capacity() + right_image.capacity() +
+               (rgb_buffer_left.capacity() + rgb_buffer_right.capacity()) * sizeof(uint32_t);
+    }
     
 private:
     // Helper method for JPEG decoding to avoid code duplication
@@ -42,8 +55,59 @@ private:
     mutable std::vector<uint32_t> rgb_buffer_right;
 };
 
+// Wall time of read_capture_file's two halves
+struct CaptureReadTiming {
+    double readSeconds = 0.0;   // reading and parsing the records
+    double alignSeconds = 0.0;  // matching images to labels, including the statistics
+};
+
 // Main function to read and process a capture file
-std::vector<AlignedFrame> read_capture_file(const std::string& filename);
+std::vector<AlignedFrame> read_capture_file(const std::string& filename, CaptureReadTiming* timing = nullptr);
+
+/**
+ * @brief Incremental reader for a capture that is still being recorded
+ *
+ * Poll() reads the records appended since the last call and aligns the labels whose
+ * alignment window has passed, with the same matching as read_capture_file. Images that
+ * could still pair with a later label are kept for the next poll. Once the writer sets
+ * CAPTURE_FLAG_COMPLETE in the header, the next poll aligns everything left and
+ * Finished() turns true. Legacy captures without synchronised timestamps cannot be
+ * aligned piecewise and are aligned in one go when complete.
+ */
+class CaptureFollower {
+public:
+    bool Open(const std::string& filename);
+
+    // Appends newly aligned frames, in timestamp order, to frames. Returns how many.
+    size_t Poll(std::vector<AlignedFrame>& frames);
+
+    bool Finished() const { return m_finished; }
+    // Seconds since the file last grew
+    double IdleSeconds() const;
+    // Treat the capture as complete, e.g. when the writer has gone away
+    void ForceComplete() { m_forceComplete = true; }
+
+private:
+    bool readHeader(bool& complete);
+    void readRecords();
+
+    std::ifstream m_file;
+    std::string m_filename;
+    uint64_t m_offset = 0;
+    uint64_t m_size = 0;
+    bool m_headerRead = false;
+    bool m_hostUs = false;
+    bool m_forceComplete = false;
+    bool m_finished = false;
+    size_t m_rawFrames = 0;
+    size_t m_alignedFrames = 0;
+    std::chrono::steady_clock::time_point m_lastGrowth;
+
+    // Records read but not aligned yet, keyed by microsecond timestamp
+    std::map<uint64_t, std::tuple<float, float, float, float, float, float, float, float, float, float, float, uint32_t>> m_labels;
+    std::map<uint64_t, std::vector<uint8_t>> m_left;
+    std::map<uint64_t, std::vector<uint8_t>> m_right;
+};
 
 // Helper function to extract label components
 inline void extract_label_data(const AlignedFrame& frame, 
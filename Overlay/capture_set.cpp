@@ -0,0 +1,155 @@
+#include "capture_set.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#undef max
+#undef min
+#else
+#include <glob.h>
+#endif
+
+std::vector<std::string> ExpandCapturePattern(const std::string& pattern) {
+    std::vector<std::string> files;
+    if (pattern.find_first_of("*?") == std::string::npos) {
+        files.push_back(pattern);
+        return files;
+    }
+
+#ifdef _WIN32
+    const size_t slash = pattern.find_last_of("\\/");
+    const std::string directory = slash == std::string::npos ? "" : pattern.substr(0, slash + 1);
+    WIN32_FIND_DATAA data;
+    HANDLE find = FindFirstFileA(pattern.c_str(), &data);
+    if (find != INVALID_HANDLE_VALUE) {
+        do {
+            if (!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+                files.push_back(directory + data.cFileName);
+            }
+        } while (FindNextFileA(find, &data));
+        FindClose(find);
+    }
+#else
+    glob_t matches;
+    if (glob(pattern.c_str(), 0, NULL, &matches) == 0) {
+        for (size_t i = 0; i < matches.gl_pathc; i++) {
+            files.push_back(matches.gl_pathv[i]);
+        }
+    }
+    globfree(&matches);
+#endif
+
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+bool ParseSessionWeights(const char* spec, std::vector<float>& weights) {
+    weights.clear();
+    const char* cursor = spec;
+    while (true) {
+        char* end = nullptr;
+        const float weight = strtof(cursor, &end);
+        if (end == cursor || !(weight >= 0.0f)) {
+            return false;
+        }
+        weights.push_back(weight);
+        if (*end == '\0') {
+            return true;
+        }
+        if (*end != ',') {
+            return false;
+        }
+        cursor = end + 1;
+    }
+}
+
+CaptureSetReader::CaptureSetReader(const std::vector<std::string>& files)
+    : m_files(files)
+{
+}
+
+void CaptureSetReader::startRead() {
+    const std::string file = m_files[m_next];
+    m_pending = std::async(std::launch::async, [file]() {
+        ReadResult result;
+        result.frames = read_capture_file(file, &result.timing);
+        return result;
+    });
+}
+
+bool CaptureSetReader::Next(std::vector<AlignedFrame>& frames, CaptureReadTiming& timing) {
+    if (m_next >= m_files.size()) {
+        return false;
+    }
+
+    if (!m_pending.valid()) {
+        startRead();
+    }
+    ReadResult result = m_pending.get();
+    frames = std::move(result.frames);
+    timing = result.timing;
+    m_next++;
+    return true;
+}
+
+void CaptureSetReader::ReadAhead() {
+    if (m_next < m_files.size() && !m_pending.valid()) {
+        startRead();
+    }
+}
+
+SessionSampler::SessionSampler(const std::vector<float>& weights)
+    : m_sessions(weights.size())
+{
+    for (size_t s = 0; s < weights.size(); s++) {
+        m_sessions[s].weight = weights[s];
+    }
+}
+
+void SessionSampler::AddWindow(size_t window, size_t session) {
+    m_sessions[session].windows.push_back(window);
+}
+
+// Windows of a session per epoch
+static size_t sessionQuota(size_t windows, float weight) {
+    return (size_t)(windows * (double)weight + 0.5);
+}
+
+size_t SessionSampler::GetEpochSize() const {
+    size_t total = 0;
+    for (const Session& session : m_sessions) {
+        total += sessionQuota(session.windows.size(), session.weight);
+    }
+    return total;
+}
+
+void SessionSampler::DrawEpoch(std::mt19937& rng, size_t* out) {
+    for (Session& session : m_sessions) {
+        const size_t count = session.windows.size();
+        size_t quota = sessionQuota(count, session.weight);
+        for (; quota >= count && count > 0; quota -= count) {
+            out = std::copy(session.windows.begin(), session.windows.end(), out);
+        }
+        for (size_t k = 0; k < quota; k++) {
+            if (session.cursor == 0) {
+                std::shuffle(session.windows.begin(), session.windows.end(), rng);
+            }
+            *out++ = session.windows[session.cursor];
+            session.cursor = (session.cursor + 1) % count;
+        }
+    }
+}
+
+void SessionSampler::PrintPlan(const std::vector<std::string>& names) const {
+    printf("Session weights:\n");
+    printf("  %-40s %8s %8s %10s\n", "Capture", "Windows", "Weight", "Per epoch");
+    for (size_t s = 0; s < m_sessions.size(); s++) {
+        const Session& session = m_sessions[s];
+        printf("  %-40s %8zu %8.2f %10zu\n", s < names.size() ? names[s].c_str() : "?", session.windows.size(),
+               session.weight, sessionQuota(session.windows.size(), session.weight));
+    }
+}
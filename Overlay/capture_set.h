@@ -0,0 +1,91 @@
+// capture_set.h
+#ifndef CAPTURE_SET_H
+#define CAPTURE_SET_H
+
+#include <cstddef>
+#include <future>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "capture_reader.h"
+
+// Files matching a pattern with * and ? in its file name, sorted. A pattern without
+// wildcards is returned as is, whether or not the file exists.
+std::vector<std::string> ExpandCapturePattern(const std::string& pattern);
+
+// Parses "w1,w2,..." into one non-negative weight per session
+bool ParseSessionWeights(const char* spec, std::vector<float>& weights);
+
+/**
+ * @brief Reads several capture files one after another, optionally one file ahead
+ *
+ * Next() hands out the frames of a file, reading it first unless ReadAhead() already
+ * started that in the background. Calling ReadAhead() after Next() overlaps reading the
+ * following file with whatever the caller does with the frames (decoding them into the
+ * frame cache); the caller decides per file, e.g. whether the memory budget has room for
+ * both. At most two files are held at a time: the one being processed and the one being
+ * read.
+ */
+class CaptureSetReader {
+public:
+    explicit CaptureSetReader(const std::vector<std::string>& files);
+
+    // Replaces frames with the next file's. Returns false after the last file.
+    bool Next(std::vector<AlignedFrame>& frames, CaptureReadTiming& timing);
+
+    // Starts reading the file the next Next() returns, if any and not started yet
+    void ReadAhead();
+    // Whether the file the next Next() returns is already being read
+    bool IsReading() const { return m_pending.valid(); }
+
+    // File of the frames Next() returned last
+    const std::string& GetFile() const { return m_files[m_next - 1]; }
+    // Files Next() has returned so far
+    size_t GetFilesRead() const { return m_next; }
+
+private:
+    struct ReadResult {
+        std::vector<AlignedFrame> frames;
+        CaptureReadTiming timing;
+    };
+
+    void startRead();
+
+    std::vector<std::string> m_files;
+    size_t m_next = 0;
+    std::future<ReadResult> m_pending;
+};
+
+/**
+ * @brief Per-session weighting of the training windows of an epoch
+ *
+ * A session of weight w contributes w times its windows to every epoch: whole copies
+ * for the integer part and a draw from its own shuffled cycle for the rest, so a
+ * down-weighted session is still covered completely over several epochs.
+ */
+class SessionSampler {
+public:
+    explicit SessionSampler(const std::vector<float>& weights);
+
+    void AddWindow(size_t window, size_t session);
+
+    // Windows per epoch over all sessions
+    size_t GetEpochSize() const;
+
+    // Writes GetEpochSize() windows to out, in session order
+    void DrawEpoch(std::mt19937& rng, size_t* out);
+
+    void PrintPlan(const std::vector<std::string>& names) const;
+
+private:
+    struct Session {
+        std::vector<size_t> windows;
+        size_t cursor = 0;   // position in the current shuffled cycle
+        float weight = 1.0f;
+    };
+
+    std::vector<Session> m_sessions;
+};
+
+#endif // CAPTURE_SET_H
@@ -0,0 +1,197 @@
+#include "clock_sync.h"
+
+#include <cmath>
+#include <algorithm>
+
+#ifdef _WIN32
+    #include <windows.h>
+    #undef max
+    #undef min
+#else
+    #include <time.h>
+#endif
+
+// Minimum samples before the fit is trusted (about half a second at 30 fps)
+static const size_t kMinFitSamples = 16;
+
+// Crystal oscillators stay well within this; anything larger is a bad fit on a short window
+static const double kMaxDriftPpm = 500.0;
+
+// A camera clock that runs ahead of the host by this much between two frames has restarted
+static const double kMaxForwardJumpUs = 5.0 * 1000000.0;
+
+uint64_t host_monotonic_us(void) {
+    #ifdef _WIN32
+        static LARGE_INTEGER frequency = { 0 };
+        if (frequency.QuadPart == 0) {
+            QueryPerformanceFrequency(&frequency);
+        }
+
+        LARGE_INTEGER count;
+        QueryPerformanceCounter(&count);
+
+        // Split to avoid overflowing count * 1000000
+        uint64_t seconds = (uint64_t)(count.QuadPart / frequency.QuadPart);
+        uint64_t remainder = (uint64_t)(count.QuadPart % frequency.QuadPart);
+        return seconds * 1000000ULL + (remainder * 1000000ULL) / (uint64_t)frequency.QuadPart;
+    #else
+        struct timespec spec;
+        clock_gettime(CLOCK_MONOTONIC, &spec);
+        return (uint64_t)spec.tv_sec * 1000000ULL + (uint64_t)spec.tv_nsec / 1000ULL;
+    #endif
+}
+
+ClockSync::ClockSync(double cameraTicksPerSecond, size_t windowSize)
+    : m_usPerTick(1000000.0 / (cameraTicksPerSecond > 0.0 ? cameraTicksPerSecond : 1000.0)),
+      m_windowSize(std::max(windowSize, kMinFitSamples)) {
+    m_samples.reserve(m_windowSize);
+}
+
+void ClockSync::Reset() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ResetLocked();
+    m_resets = 0;
+}
+
+void ClockSync::ResetLocked() {
+    m_hasReference = false;
+    m_samples.clear();
+    m_head = 0;
+    m_valid = false;
+    m_intercept = 0.0;
+    m_slope = 1.0;
+    m_jitterUs = 0.0;
+}
+
+void ClockSync::AddSample(uint64_t cameraTicks, uint64_t hostReceiveUs) {
+    // Streams without an X-Timestamp header report 0; nothing to fit
+    if (cameraTicks == 0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_hasReference) {
+        double cameraDeltaUs = ((double)cameraTicks - (double)m_lastCameraTicks) * m_usPerTick;
+        double hostDeltaUs = (double)hostReceiveUs - (double)m_lastHostUs;
+
+        if (cameraTicks < m_lastCameraTicks || cameraDeltaUs - hostDeltaUs > kMaxForwardJumpUs) {
+            ResetLocked();
+            m_resets++;
+        }
+    }
+
+    if (!m_hasReference) {
+        m_hasReference = true;
+        m_refCameraTicks = cameraTicks;
+        m_refHostUs = hostReceiveUs;
+    }
+
+    m_lastCameraTicks = cameraTicks;
+    m_lastHostUs = hostReceiveUs;
+
+    Sample sample;
+    sample.x = (double)(cameraTicks - m_refCameraTicks) * m_usPerTick;
+    sample.y = (double)hostReceiveUs - (double)m_refHostUs;
+
+    if (m_samples.size() < m_windowSize) {
+        m_samples.push_back(sample);
+    } else {
+        m_samples[m_head] = sample;
+        m_head = (m_head + 1) % m_windowSize;
+    }
+
+    RefitLocked();
+}
+
+void ClockSync::RefitLocked() {
+    const size_t n = m_samples.size();
+    if (n < kMinFitSamples) {
+        m_valid = false;
+        return;
+    }
+
+    // Least squares on centered coordinates
+    double meanX = 0.0, meanY = 0.0;
+    for (const Sample& s : m_samples) {
+        meanX += s.x;
+        meanY += s.y;
+    }
+    meanX /= n;
+    meanY /= n;
+
+    double sxx = 0.0, sxy = 0.0;
+    for (const Sample& s : m_samples) {
+        double dx = s.x - meanX;
+        sxx += dx * dx;
+        sxy += dx * (s.y - meanY);
+    }
+
+    double slope = (sxx > 0.0) ? (sxy / sxx) : 1.0;
+    const double maxDrift = kMaxDriftPpm * 1e-6;
+    slope = std::max(1.0 - maxDrift, std::min(1.0 + maxDrift, slope));
+    double intercept = meanY - slope * meanX;
+
+    // Residuals: RMS gives the jitter, the minimum gives the lower envelope
+    double sumSq = 0.0;
+    double minResidual = 0.0;
+    bool first = true;
+    for (const Sample& s : m_samples) {
+        double r = s.y - (intercept + slope * s.x);
+        sumSq += r * r;
+        if (first || r < minResidual) {
+            minResidual = r;
+            first = false;
+        }
+    }
+
+    m_slope = slope;
+    m_intercept = intercept + minResidual;
+    m_jitterUs = std::sqrt(sumSq / n);
+    m_valid = true;
+}
+
+uint64_t ClockSync::ToHostMicros(uint64_t cameraTicks, uint64_t fallbackHostUs) const {
+    if (cameraTicks == 0) {
+        return fallbackHostUs;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (!m_valid || cameraTicks < m_refCameraTicks) {
+        return fallbackHostUs;
+    }
+
+    double x = (double)(cameraTicks - m_refCameraTicks) * m_usPerTick;
+    double host = (double)m_refHostUs + m_intercept + m_slope * x;
+    if (host <= 0.0) {
+        return fallbackHostUs;
+    }
+
+    return (uint64_t)std::llround(host);
+}
+
+ClockSyncStats ClockSync::GetStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    ClockSyncStats stats;
+    stats.valid = m_valid;
+    stats.sampleCount = m_samples.size();
+    stats.resets = m_resets;
+
+    if (m_valid) {
+        double lastX = (double)(m_lastCameraTicks - m_refCameraTicks) * m_usPerTick;
+        double firstX = lastX;
+        for (const Sample& s : m_samples) {
+            firstX = std::min(firstX, s.x);
+        }
+
+        stats.offsetUs = ((double)m_refHostUs + m_intercept + m_slope * lastX) -
+                         (double)m_lastCameraTicks * m_usPerTick;
+        stats.driftPpm = (1.0 / m_slope - 1.0) * 1e6;
+        stats.jitterUs = m_jitterUs;
+        stats.spanSeconds = (lastX - firstX) / 1000000.0;
+    }
+
+    return stats;
+}
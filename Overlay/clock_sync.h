@@ -0,0 +1,84 @@
+// clock_sync.h
+#ifndef CLOCK_SYNC_H
+#define CLOCK_SYNC_H
+
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+// Host monotonic clock in microseconds (QPC on Windows, CLOCK_MONOTONIC elsewhere).
+// All capture timestamps (labels and corrected camera times) live in this domain.
+uint64_t host_monotonic_us(void);
+
+// Quality of the current camera -> host clock fit
+struct ClockSyncStats {
+    bool valid = false;         // true once enough samples have been collected for a fit
+    size_t sampleCount = 0;     // samples in the fit window
+    double offsetUs = 0.0;      // host time minus camera time at the most recent sample
+    double driftPpm = 0.0;      // camera clock rate error relative to the host clock
+    double jitterUs = 0.0;      // RMS residual of the samples around the fitted line
+    double spanSeconds = 0.0;   // camera time covered by the fit window
+    uint32_t resets = 0;        // number of times the camera clock jumped and the fit restarted
+};
+
+/**
+ * @brief Online estimator of offset and drift between a camera clock and the host clock
+ *
+ * Each received frame contributes a (camera timestamp, host receive time) pair. A least
+ * squares line over a sliding window gives the drift; the intercept is then moved down to
+ * the lower envelope of the samples, since transport delay can only make a frame arrive
+ * later than it was captured. Camera timestamps that go backwards or jump by more than
+ * the host clock did restart the fit (camera reboot or stream reconnect).
+ *
+ * Thread safe: the frame thread adds samples while other threads convert or read stats.
+ */
+class ClockSync {
+public:
+    // cameraTicksPerSecond is the unit of the X-Timestamp header (milliseconds by default)
+    explicit ClockSync(double cameraTicksPerSecond = 1000.0, size_t windowSize = 1024);
+
+    // Record a frame's camera timestamp together with the host time it was received at
+    void AddSample(uint64_t cameraTicks, uint64_t hostReceiveUs);
+
+    // Convert a camera timestamp to host microseconds. Returns fallbackHostUs while the
+    // fit is not yet valid or when the camera did not provide a timestamp.
+    uint64_t ToHostMicros(uint64_t cameraTicks, uint64_t fallbackHostUs) const;
+
+    ClockSyncStats GetStats() const;
+
+    void Reset();
+
+private:
+    struct Sample {
+        double x;   // camera time since reference, in microseconds
+        double y;   // host time since reference, in microseconds
+    };
+
+    void ResetLocked();
+    void RefitLocked();
+
+    mutable std::mutex m_mutex;
+
+    double m_usPerTick;
+    size_t m_windowSize;
+
+    bool m_hasReference = false;
+    uint64_t m_refCameraTicks = 0;
+    uint64_t m_refHostUs = 0;
+    uint64_t m_lastCameraTicks = 0;
+    uint64_t m_lastHostUs = 0;
+
+    // Ring buffer of the most recent samples
+    std::vector<Sample> m_samples;
+    size_t m_head = 0;
+
+    // Current fit: host = ref + m_intercept + m_slope * camera
+    bool m_valid = false;
+    double m_intercept = 0.0;
+    double m_slope = 1.0;
+    double m_jitterUs = 0.0;
+    uint32_t m_resets = 0;
+};
+
+#endif // CLOCK_SYNC_H
@@ -8,12 +8,12 @@ set "OUTPUT_EXE=calibration_runner.exe"
 set "VS_PATH=C:\Program Files (x86)\Microsoft Visual Studio\2019\Community\VC\Auxiliary\Build\vcvarsall.bat"
 set "VS_ARCHITECTURE=x64"
 set "ONNXRUNTIME_PATH=C:\ortt" 
-set "LIBRARIES=turbojpeg.lib onnxruntime.lib"
+set "LIBRARIES=turbojpeg.lib onnxruntime.lib psapi.lib"
 set "ICON_FILE=app.ico"
 set "TURBOJPEG_PATH=C:\libjpeg-turbo64"
 
 :: Source files
-set "CPP_SOURCE_FILES=trainer.cpp numpy_io.cpp capture_reader.cpp"
+set "CPP_SOURCE_FILES=trainer.cpp numpy_io.cpp capture_reader.cpp capture_set.cpp batch_loader.cpp trainer_options.cpp frame_cache.cpp gather_kernels.cpp augmentation.cpp stage_sampler.cpp frame_dedup.cpp image_resample.cpp lr_schedule.cpp memory_tracker.cpp phase_profiler.cpp progress_channel.cpp thread_planner.cpp training_telemetry.cpp"
 
 :: Check if cl.exe is in PATH
 where cl.exe >nul 2>nul
@@ -164,6 +164,11 @@ class DatasetScrubber:
             self.frames = []
             
             with open(filename, 'rb') as f:
+                # Newer captures start with a 16-byte header (magic, version, flags)
+                file_header = f.read(16)
+                if not file_header.startswith(b'BBCAPT01'):
+                    f.seek(0)
+                
                 frame_count = 0
                 while True:
                     # Read frame header
@@ -23,6 +23,10 @@
 #define FLAG_ROUTINE_23         (1U << 22) 
 #define FLAG_ROUTINE_24         (1U << 23)  
 
+// Stage bits: the overlay records FLAG_ROUTINE_1 << RoutineController::m_routineStage
+#define FLAG_ROUTINE_STAGE(stage) (FLAG_ROUTINE_1 << (stage))
+#define FLAG_ROUTINE_STAGE_MASK   0x00FFFFFFU
+
 #define FLAG_CONVERGENCE        (1U << 24)  
 #define FLAG_IN_MOVEMENT        (1U << 25)  
 #define FLAG_RESTING            (1U << 26) 
@@ -11,37 +11,6 @@
 
 
 
-#ifdef _WIN32
-    #include <windows.h>
-#else
-    #include <sys/time.h>
-    #include <time.h>
-#endif
-uint64_t current_time_ms_2(void) { // todo: utils class
-    #ifdef _WIN32
-        // Windows implementation
-        LARGE_INTEGER frequency;
-        LARGE_INTEGER count;
-        
-        QueryPerformanceFrequency(&frequency);
-        QueryPerformanceCounter(&count);
-        
-        return (uint64_t)((count.QuadPart * 1000ULL) / frequency.QuadPart);
-    #else
-        // POSIX implementation
-        struct timespec spec;
-        
-        if (clock_gettime(CLOCK_REALTIME, &spec) == 0) {
-            return (uint64_t)(spec.tv_sec * 1000ULL + spec.tv_nsec / 1000000ULL);
-        } else {
-            // Fallback to gettimeofday if clock_gettime is not available
-            struct timeval tv;
-            gettimeofday(&tv, NULL);
-            return (uint64_t)(tv.tv_sec * 1000ULL + tv.tv_usec / 1000ULL);
-        }
-    #endif
-}
-
 FrameBuffer::FrameBuffer(const char* url, int updateInterval)
     : streamUrl(url), 
       frontBuffer(0), 
@@ -199,7 +168,7 @@ void FrameBuffer::updateLoop() {
         //}
 
         //printf("Update loop 3\n");
-        uint64_t time = current_time_ms_2();
+        uint64_t receive_time_us = host_monotonic_us();
         //printf("Update loop 4\n");
         if (pixels) {
             //printf("Update loop 5\n");
@@ -244,7 +213,10 @@ void FrameBuffer::updateLoop() {
             buffers[backBuffer].width = width;
             buffers[backBuffer].height = height;
 
+            clockSync.AddSample(timestamp, receive_time_us);
+
             buffers[backBuffer].time = timestamp;
+            buffers[backBuffer].host_time_us = clockSync.ToHostMicros(timestamp, receive_time_us);
             buffers[backBuffer].frame_size = frame_size;
 
             memcpy(buffers[backBuffer].pixels, pixels, frame_size);
@@ -276,7 +248,8 @@ void FrameBuffer::swapBuffers() {
     }
 }
 
-unsigned char* FrameBuffer::getFrameCopy(int* width, int* height, uint64_t* time, size_t* data_size) {
+unsigned char* FrameBuffer::getFrameCopy(int* width, int* height, uint64_t* time, size_t* data_size,
+                                         uint64_t* host_time_us) {
     std::lock_guard<std::mutex> lock(frameMutex);
     
     Frame& front = buffers[frontBuffer];
@@ -284,6 +257,7 @@ unsigned char* FrameBuffer::getFrameCopy(int* width, int* height, uint64_t* time
     if (!front.pixels) {
         *width = *height = 0;
         *time = 0;
+        if (host_time_us) *host_time_us = 0;
         printf("Get Frame Copy returned nothing!\n");
         return nullptr;
     }
@@ -311,16 +285,22 @@ unsigned char* FrameBuffer::getFrameCopy(int* width, int* height, uint64_t* time
         *height = front.height;
         *time = front.time;
         *data_size = front.frame_size;
+        if (host_time_us) *host_time_us = front.host_time_us;
     } else {
         *width = *height = 0;
         *time = 0;
         *data_size = 0;
+        if (host_time_us) *host_time_us = 0;
     }
     
     
     return copy;
 }
 
+ClockSyncStats FrameBuffer::getClockSyncStats() const {
+    return clockSync.GetStats();
+}
+
 /*
 void FrameBuffer::lockFrame(int** pixels, int* width, int* height) {
     std::unique_lock<std::mutex> lock(frameMutex);
@@ -7,6 +7,8 @@
 #include <atomic>
 #include <condition_variable>
 
+#include "clock_sync.h"
+
 // Forward declaration - use the exact same struct name from jpeg_stream.h
 struct MJPEGStream;
 
@@ -20,7 +22,13 @@ public:
 
     // Get a copy of the current frame
     // The caller is responsible for freeing the returned memory
-    unsigned char* getFrameCopy(int* width, int* height, uint64_t* time, size_t* data_size);
+    // time receives the camera's own timestamp, host_time_us (optional) the same
+    // instant corrected onto the host monotonic clock
+    unsigned char* getFrameCopy(int* width, int* height, uint64_t* time, size_t* data_size,
+                                uint64_t* host_time_us = nullptr);
+
+    // Current quality of the camera -> host clock fit
+    ClockSyncStats getClockSyncStats() const;
 
     void setTargetResolution(int width, int height);
     
@@ -41,6 +49,7 @@ private:
         int width = 0;
         int height = 0;
         uint64_t time = 0;
+        uint64_t host_time_us = 0;
         size_t frame_size = 0;
         
         void clear() {
@@ -81,6 +90,9 @@ private:
     int targetWidth = 0;
     int targetHeight = 0;
     bool resizeEnabled = false;
+
+    // Maps the camera's X-Timestamp onto the host clock
+    ClockSync clockSync;
 };
 
 #endif // FRAME_BUFFER_H
\ No newline at end of file
@@ -0,0 +1,94 @@
+#include "frame_cache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include "image_resample.h"
+#include "thread_planner.h"
+
+void FrameTensorCache::Build(const std::vector<AlignedFrame>& frames, int resolution, size_t labelCount,
+                             LabelFunction labelFunction, size_t workerCount, ResampleMode resampleMode) {
+    m_resolution = resolution;
+    m_resampleMode = resampleMode;
+    m_frameCount = 0;
+    m_labelCount = labelCount;
+    m_decodeFailures = 0;
+    m_labelFunction = labelFunction;
+    m_chunks.clear();
+    m_labels.clear();
+    m_labelValid.clear();
+
+    Append(frames, workerCount);
+}
+
+size_t FrameTensorCache::GetAppendBytes(size_t cachedFrames, size_t newFrames, int resolution, size_t labelCount) {
+    const size_t chunkBytes = CHUNK_FRAMES * 2 * (size_t)resolution * resolution;
+    const size_t cachedChunks = (cachedFrames + CHUNK_FRAMES - 1) / CHUNK_FRAMES;
+    const size_t totalFrames = cachedFrames + newFrames;
+    const size_t totalChunks = (totalFrames + CHUNK_FRAMES - 1) / CHUNK_FRAMES;
+    return (totalChunks - cachedChunks) * chunkBytes + totalFrames * (labelCount * sizeof(float) + 1);
+}
+
+void FrameTensorCache::Append(const std::vector<AlignedFrame>& frames, size_t workerCount) {
+    const size_t first = m_frameCount;
+    if (frames.size() <= first) {
+        return;
+    }
+    m_frameCount = frames.size();
+
+    const size_t planeSize = GetPlaneSize();
+    const int resolution = m_resolution;
+    const ResampleMode resampleMode = m_resampleMode;
+    while (m_chunks.size() * CHUNK_FRAMES < m_frameCount) {
+        m_chunks.emplace_back(CHUNK_FRAMES * 2 * planeSize, 0);
+    }
+    m_labels.resize(m_frameCount * m_labelCount, 0.0f);
+    m_labelValid.resize(m_frameCount, 0);
+
+    if (workerCount == 0) {
+        workerCount = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+    workerCount = std::min(workerCount, m_frameCount - first);
+
+    // Frames are handed out one at a time; each worker keeps its own decode buffer
+    std::atomic<size_t> nextFrame(first);
+    std::atomic<size_t> failures(0);
+
+    auto worker = [&]() {
+        std::vector<uint32_t> decoded;
+        size_t i;
+        while ((i = nextFrame.fetch_add(1)) < m_frameCount) {
+            const AlignedFrame& frame = frames[i];
+
+            m_labelValid[i] = m_labelFunction(frame, &m_labels[i * m_labelCount]) ? 1 : 0;
+
+            for (int eye = 0; eye < 2; eye++) {
+                int width = 0, height = 0;
+                if (frame.DecodeImage(eye == 1, decoded, width, height) && width > 0 && height > 0) {
+                    // Red byte of each RGBX pixel
+                    ResamplePlane(reinterpret_cast<const uint8_t*>(decoded.data()), width, height,
+                                  (size_t)width * 4, 4, plane(i, eye),
+                                  resolution, resolution, resolution, 1, resampleMode);
+                } else {
+                    failures++;
+                }
+            }
+        }
+    };
+
+    // The calling thread takes a share and keeps its own affinity
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < workerCount; t++) {
+        threads.emplace_back([&worker]() {
+            PinWorkerThread(ThreadRole::Decode);
+            worker();
+        });
+    }
+    worker();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    m_decodeFailures += failures.load();
+}
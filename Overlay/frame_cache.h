@@ -0,0 +1,81 @@
+// frame_cache.h
+#ifndef FRAME_CACHE_H
+#define FRAME_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "capture_reader.h"
+#include "image_resample.h"
+
+/**
+ * @brief Every captured frame decoded once and stored at training resolution
+ *
+ * Holds a [frames, 2, resolution, resolution] uint8 tensor (left plane, then right
+ * plane, red channel of the decoded image) and a contiguous [frames, labelCount]
+ * float label array. Overlapping temporal windows share the same rows, so batch
+ * assembly becomes a gather and no JPEG is decoded after Build().
+ *
+ * The planes are stored in chunks of CHUNK_FRAMES frames, so Append adds chunks instead
+ * of reallocating and copying everything cached before, and growing by a session costs
+ * that session's planes only.
+ */
+class FrameTensorCache {
+public:
+    static const size_t CHUNK_FRAMES = 256;
+
+    // Converts a frame's label data into labelCount floats; false marks the labels unusable
+    using LabelFunction = std::function<bool(const AlignedFrame& frame, float* labels)>;
+
+    // Decode and resize all frames using workerCount threads (0 = hardware threads).
+    // Frames that fail to decode get black planes.
+    void Build(const std::vector<AlignedFrame>& frames, int resolution, size_t labelCount,
+               LabelFunction labelFunction, size_t workerCount = 0,
+               ResampleMode resampleMode = ResampleMode::Area);
+
+    // Decode frames[GetFrameCount(), frames.size()) with the settings of Build() and add
+    // them after the cached ones. Nothing may read the cache meanwhile; the labels move.
+    void Append(const std::vector<AlignedFrame>& frames, size_t workerCount = 0);
+
+    // Most bytes a cache of cachedFrames allocates while growing by newFrames: the new
+    // plane chunks plus the grown label arrays, which briefly coexist with the old ones
+    static size_t GetAppendBytes(size_t cachedFrames, size_t newFrames, int resolution, size_t labelCount);
+
+    size_t GetFrameCount() const { return m_frameCount; }
+    int GetResolution() const { return m_resolution; }
+    ResampleMode GetResampleMode() const { return m_resampleMode; }
+    size_t GetPlaneSize() const { return (size_t)m_resolution * m_resolution; }
+    size_t GetLabelCount() const { return m_labelCount; }
+    size_t GetDecodeFailures() const { return m_decodeFailures; }
+
+    // eye: 0 = left, 1 = right
+    const uint8_t* Plane(size_t frame, int eye) const {
+        return m_chunks[frame / CHUNK_FRAMES].data() + ((frame % CHUNK_FRAMES) * 2 + eye) * GetPlaneSize();
+    }
+    const float* Labels(size_t frame) const { return m_labels.data() + frame * m_labelCount; }
+    bool LabelsValid(size_t frame) const { return m_labelValid[frame] != 0; }
+
+    size_t GetMemoryBytes() const {
+        return m_chunks.size() * CHUNK_FRAMES * 2 * GetPlaneSize() + m_labels.size() * sizeof(float) +
+               m_labelValid.size();
+    }
+
+private:
+    uint8_t* plane(size_t frame, int eye) {
+        return m_chunks[frame / CHUNK_FRAMES].data() + ((frame % CHUNK_FRAMES) * 2 + eye) * GetPlaneSize();
+    }
+
+    int m_resolution = 0;
+    ResampleMode m_resampleMode = ResampleMode::Area;
+    size_t m_frameCount = 0;
+    size_t m_labelCount = 0;
+    size_t m_decodeFailures = 0;
+    LabelFunction m_labelFunction;
+    std::vector<std::vector<uint8_t>> m_chunks;
+    std::vector<float> m_labels;
+    std::vector<uint8_t> m_labelValid;
+};
+
+#endif // FRAME_CACHE_H
@@ -0,0 +1,109 @@
+#include "frame_dedup.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <thread>
+
+#include "thread_planner.h"
+
+// Block means of one plane into SIGNATURE_GRID x SIGNATURE_GRID bytes
+static void planeSignature(const uint8_t* plane, int resolution, uint8_t* out) {
+    for (int by = 0; by < SIGNATURE_GRID; by++) {
+        const int y0 = by * resolution / SIGNATURE_GRID;
+        const int y1 = (by + 1) * resolution / SIGNATURE_GRID;
+        for (int bx = 0; bx < SIGNATURE_GRID; bx++) {
+            const int x0 = bx * resolution / SIGNATURE_GRID;
+            const int x1 = (bx + 1) * resolution / SIGNATURE_GRID;
+            uint32_t sum = 0;
+            for (int y = y0; y < y1; y++) {
+                const uint8_t* row = plane + (size_t)y * resolution;
+                for (int x = x0; x < x1; x++) {
+                    sum += row[x];
+                }
+            }
+            const uint32_t count = (uint32_t)((y1 - y0) * (x1 - x0));
+            out[by * SIGNATURE_GRID + bx] = (uint8_t)(count > 0 ? (sum + count / 2) / count : 0);
+        }
+    }
+}
+
+void FrameSignatures::Build(const FrameTensorCache& cache, size_t workerCount) {
+    const size_t frameCount = cache.GetFrameCount();
+    const size_t eyeSize = SIGNATURE_SIZE / 2;
+    m_signatures.assign(frameCount * SIGNATURE_SIZE, 0);
+
+    if (workerCount == 0) {
+        workerCount = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+    workerCount = std::min(workerCount, std::max<size_t>(frameCount, 1));
+
+    std::atomic<size_t> nextFrame(0);
+    auto worker = [&]() {
+        size_t i;
+        while ((i = nextFrame.fetch_add(1)) < frameCount) {
+            for (int eye = 0; eye < 2; eye++) {
+                planeSignature(cache.Plane(i, eye), cache.GetResolution(), &m_signatures[i * SIGNATURE_SIZE + eye * eyeSize]);
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < workerCount; t++) {
+        threads.emplace_back([&worker]() {
+            PinWorkerThread(ThreadRole::Decode);
+            worker();
+        });
+    }
+    worker();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+float FrameSignatures::Distance(size_t a, size_t b) const {
+    const uint8_t* sa = Get(a);
+    const uint8_t* sb = Get(b);
+    uint32_t sum = 0;
+    for (size_t i = 0; i < SIGNATURE_SIZE; i++) {
+        sum += (uint32_t)std::abs((int)sa[i] - (int)sb[i]);
+    }
+    return (float)sum / SIGNATURE_SIZE;
+}
+
+std::vector<char> PruneNearDuplicates(const FrameTensorCache& cache, const FrameSignatures& signatures,
+                                      const std::vector<size_t>& firstFrames, const std::vector<size_t>& lastFrames,
+                                      float imageThreshold, float labelTolerance, int keepEvery, DedupStats& stats) {
+    const size_t count = lastFrames.size();
+    const size_t labelCount = cache.GetLabelCount();
+    std::vector<char> keep(count, 1);
+    stats = DedupStats();
+    stats.windows = count;
+
+    size_t kept = 0;      // index of the window the current run is compared against
+    size_t runLength = 0; // windows removed since it
+    for (size_t i = 1; i < count; i++) {
+        const float* keptLabels = cache.Labels(lastFrames[kept]);
+        const float* labels = cache.Labels(lastFrames[i]);
+        float labelDistance = 0.0f;
+        for (size_t l = 0; l < labelCount; l++) {
+            labelDistance = std::max(labelDistance, std::fabs(labels[l] - keptLabels[l]));
+        }
+
+        const bool duplicate = labelDistance <= labelTolerance &&
+            signatures.Distance(lastFrames[i], lastFrames[kept]) <= imageThreshold &&
+            signatures.Distance(firstFrames[i], firstFrames[kept]) <= imageThreshold;
+
+        if (duplicate && !(keepEvery > 0 && runLength + 1 >= (size_t)keepEvery)) {
+            keep[i] = 0;
+            runLength++;
+            stats.removed++;
+            stats.maxLabelDistance = std::max(stats.maxLabelDistance, labelDistance);
+        } else {
+            kept = i;
+            runLength = 0;
+        }
+    }
+    return keep;
+}
@@ -0,0 +1,56 @@
+// frame_dedup.h
+#ifndef FRAME_DEDUP_H
+#define FRAME_DEDUP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "frame_cache.h"
+
+// Block means of each eye plane on a SIGNATURE_GRID x SIGNATURE_GRID grid
+static const int SIGNATURE_GRID = 8;
+static const size_t SIGNATURE_SIZE = 2 * SIGNATURE_GRID * SIGNATURE_GRID;
+
+/**
+ * @brief Perceptual signatures of every cached frame for near-duplicate detection
+ *
+ * A signature is the block-mean thumbnail of both eye planes, so a frame with noise or a
+ * one-pixel jitter stays close to its neighbours while a blink or a saccade does not.
+ * The distance is the mean absolute difference in 8-bit levels.
+ */
+class FrameSignatures {
+public:
+    // Computes the signatures of every frame in the cache using workerCount threads
+    void Build(const FrameTensorCache& cache, size_t workerCount = 0);
+
+    const uint8_t* Get(size_t frame) const { return &m_signatures[frame * SIGNATURE_SIZE]; }
+    float Distance(size_t a, size_t b) const;
+
+private:
+    std::vector<uint8_t> m_signatures;
+};
+
+// Outcome of PruneNearDuplicates
+struct DedupStats {
+    size_t windows = 0;
+    size_t removed = 0;
+    float maxLabelDistance = 0.0f;   // largest label change from a removed window to its kept one
+};
+
+/**
+ * @brief Marks windows that nearly repeat the window kept before them
+ *
+ * Windows are given by their first and last frame, in temporal order. A window is
+ * removed when both frames are within imageThreshold of the last kept window's, and
+ * every label of its last frame is within labelTolerance. Comparing against the kept
+ * window rather than the previous one stops slow drifts from being pruned away, and the
+ * label tolerance keeps every target the routine showed. keepEvery > 0 still keeps one
+ * window in that many of a run, down-weighting long holds instead of collapsing them.
+ * Returns one keep flag per window.
+ */
+std::vector<char> PruneNearDuplicates(const FrameTensorCache& cache, const FrameSignatures& signatures,
+                                      const std::vector<size_t>& firstFrames, const std::vector<size_t>& lastFrames,
+                                      float imageThreshold, float labelTolerance, int keepEvery, DedupStats& stats);
+
+#endif // FRAME_DEDUP_H
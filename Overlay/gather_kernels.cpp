@@ -0,0 +1,284 @@
+#include "gather_kernels.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define GATHER_X86 1
+    #include <immintrin.h>
+    #ifdef _MSC_VER
+        #include <intrin.h>
+    #endif
+#else
+    #define GATHER_X86 0
+#endif
+
+// GCC and Clang need per-function target attributes to emit AVX2 outside -mavx2 builds;
+// MSVC accepts the intrinsics anywhere
+#if GATHER_X86 && (defined(__GNUC__) || defined(__clang__))
+    #define TARGET_AVX2 __attribute__((target("avx2")))
+    #define TARGET_SSE2 __attribute__((target("sse2")))
+#else
+    #define TARGET_AVX2
+    #define TARGET_SSE2
+#endif
+
+static void convertScalar(const uint8_t* src, float* dst, size_t count, float scale) {
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = src[i] * scale;
+    }
+}
+
+#if GATHER_X86
+TARGET_SSE2
+static void convertSSE2(const uint8_t* src, float* dst, size_t count, float scale) {
+    const __m128 vscale = _mm_set1_ps(scale);
+    const __m128i zero = _mm_setzero_si128();
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i lo16 = _mm_unpacklo_epi8(bytes, zero);
+        __m128i hi16 = _mm_unpackhi_epi8(bytes, zero);
+
+        _mm_storeu_ps(dst + i + 0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo16, zero)), vscale));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo16, zero)), vscale));
+        _mm_storeu_ps(dst + i + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi16, zero)), vscale));
+        _mm_storeu_ps(dst + i + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi16, zero)), vscale));
+    }
+    convertScalar(src + i, dst + i, count - i, scale);
+}
+
+TARGET_AVX2
+static void convertAVX2(const uint8_t* src, float* dst, size_t count, float scale) {
+    const __m256 vscale = _mm256_set1_ps(scale);
+
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 16));
+
+        _mm256_storeu_ps(dst + i + 0, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(a)), vscale));
+        _mm256_storeu_ps(dst + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(a, 8))), vscale));
+        _mm256_storeu_ps(dst + i + 16, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(b)), vscale));
+        _mm256_storeu_ps(dst + i + 24, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(b, 8))), vscale));
+    }
+    for (; i + 8 <= count; i += 8) {
+        __m128i a = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i));
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(a)), vscale));
+    }
+    convertScalar(src + i, dst + i, count - i, scale);
+}
+#endif
+
+static void lutScalar(const uint8_t* src, const float* lut, const float* noise, size_t count, float* dst) {
+    if (noise != NULL) {
+        for (size_t i = 0; i < count; i++) {
+            dst[i] = lut[src[i]] + noise[i];
+        }
+    } else {
+        for (size_t i = 0; i < count; i++) {
+            dst[i] = lut[src[i]];
+        }
+    }
+}
+
+#if GATHER_X86
+// SSE2 has no gather; the lookups stay scalar and only the noise add is vectorised
+TARGET_SSE2
+static void lutSSE2(const uint8_t* src, const float* lut, const float* noise, size_t count, float* dst) {
+    size_t i = 0;
+    if (noise != NULL) {
+        for (; i + 4 <= count; i += 4) {
+            __m128 values = _mm_setr_ps(lut[src[i]], lut[src[i + 1]], lut[src[i + 2]], lut[src[i + 3]]);
+            _mm_storeu_ps(dst + i, _mm_add_ps(values, _mm_loadu_ps(noise + i)));
+        }
+        lutScalar(src + i, lut, noise + i, count - i, dst + i);
+    } else {
+        for (; i + 4 <= count; i += 4) {
+            _mm_storeu_ps(dst + i, _mm_setr_ps(lut[src[i]], lut[src[i + 1]], lut[src[i + 2]], lut[src[i + 3]]));
+        }
+        lutScalar(src + i, lut, NULL, count - i, dst + i);
+    }
+}
+
+TARGET_AVX2
+static void lutAVX2(const uint8_t* src, const float* lut, const float* noise, size_t count, float* dst) {
+    size_t i = 0;
+    if (noise != NULL) {
+        for (; i + 8 <= count; i += 8) {
+            __m256i index = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i)));
+            __m256 values = _mm256_i32gather_ps(lut, index, 4);
+            _mm256_storeu_ps(dst + i, _mm256_add_ps(values, _mm256_loadu_ps(noise + i)));
+        }
+        lutScalar(src + i, lut, noise + i, count - i, dst + i);
+    } else {
+        for (; i + 8 <= count; i += 8) {
+            __m256i index = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i)));
+            _mm256_storeu_ps(dst + i, _mm256_i32gather_ps(lut, index, 4));
+        }
+        lutScalar(src + i, lut, NULL, count - i, dst + i);
+    }
+}
+#endif
+
+typedef void (*ConvertFunction)(const uint8_t* src, float* dst, size_t count, float scale);
+
+static ConvertFunction convertFor(KernelLevel level) {
+#if GATHER_X86
+    switch (level) {
+        case KernelLevel::AVX2: return convertAVX2;
+        case KernelLevel::SSE2: return convertSSE2;
+        default: break;
+    }
+#else
+    (void)level;
+#endif
+    return convertScalar;
+}
+
+KernelLevel DetectKernelLevel() {
+#if GATHER_X86
+    #ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 0);
+        int maxLeaf = info[0];
+
+        __cpuid(info, 1);
+        bool sse2 = (info[3] & (1 << 26)) != 0;
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+
+        // The OS must save YMM state for AVX2 to be usable
+        bool ymmEnabled = osxsave && avx && ((_xgetbv(0) & 0x6) == 0x6);
+
+        bool avx2 = false;
+        if (maxLeaf >= 7) {
+            __cpuidex(info, 7, 0);
+            avx2 = (info[1] & (1 << 5)) != 0;
+        }
+
+        if (avx2 && ymmEnabled) return KernelLevel::AVX2;
+        if (sse2) return KernelLevel::SSE2;
+    #else
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) return KernelLevel::AVX2;
+        if (__builtin_cpu_supports("sse2")) return KernelLevel::SSE2;
+    #endif
+#endif
+    return KernelLevel::Scalar;
+}
+
+// -1 until first use
+static std::atomic<int> g_kernelLevel(-1);
+
+KernelLevel GetKernelLevel() {
+    int level = g_kernelLevel.load(std::memory_order_relaxed);
+    if (level < 0) {
+        level = (int)DetectKernelLevel();
+        g_kernelLevel.store(level, std::memory_order_relaxed);
+    }
+    return (KernelLevel)level;
+}
+
+KernelLevel SetKernelLevel(KernelLevel level) {
+    KernelLevel detected = DetectKernelLevel();
+    if ((int)level > (int)detected) {
+        level = detected;
+    }
+    g_kernelLevel.store((int)level, std::memory_order_relaxed);
+    return level;
+}
+
+const char* KernelLevelName(KernelLevel level) {
+    switch (level) {
+        case KernelLevel::AVX2: return "avx2";
+        case KernelLevel::SSE2: return "sse2";
+        default: return "scalar";
+    }
+}
+
+void GatherNormalizePlanes(const uint8_t* const* planes, size_t planeCount, size_t planeSize,
+                           float scale, float* dst) {
+    ConvertFunction convert = convertFor(GetKernelLevel());
+    for (size_t i = 0; i < planeCount; i++) {
+        convert(planes[i], dst + i * planeSize, planeSize, scale);
+    }
+}
+
+void ConvertLutAddNoise(const uint8_t* src, const float* lut, const float* noise, size_t count, float* dst) {
+#if GATHER_X86
+    switch (GetKernelLevel()) {
+        case KernelLevel::AVX2: lutAVX2(src, lut, noise, count, dst); return;
+        case KernelLevel::SSE2: lutSSE2(src, lut, noise, count, dst); return;
+        default: break;
+    }
+#endif
+    lutScalar(src, lut, noise, count, dst);
+}
+
+bool RunGatherBenchmark(size_t batchSize, size_t planesPerSample, size_t planeSize, int iterations) {
+    // Synthetic frame store several times larger than a batch so gathers miss the cache
+    // the way shuffled samples do
+    const size_t storePlanes = batchSize * planesPerSample * 8;
+    std::vector<uint8_t> store(storePlanes * planeSize);
+    std::mt19937 rng(1234);
+    for (uint8_t& v : store) {
+        v = (uint8_t)(rng() & 0xFF);
+    }
+
+    std::vector<const uint8_t*> planes(batchSize * planesPerSample);
+    std::uniform_int_distribution<size_t> pick(0, storePlanes - 1);
+
+    std::vector<float> reference(planes.size() * planeSize);
+    std::vector<float> output(planes.size() * planeSize);
+
+    const KernelLevel previous = GetKernelLevel();
+    const KernelLevel best = DetectKernelLevel();
+    const double bytesPerBatch = (double)planes.size() * planeSize * (1 + sizeof(float));
+
+    printf("Gather benchmark: %zu samples x %zu planes of %zu bytes, %d iterations\n",
+           batchSize, planesPerSample, planeSize, iterations);
+
+    bool ok = true;
+    double scalarSeconds = 0.0;
+    for (int level = (int)KernelLevel::Scalar; level <= (int)best; level++) {
+        SetKernelLevel((KernelLevel)level);
+
+        double seconds = 0.0;
+        for (int it = 0; it < iterations; it++) {
+            for (const uint8_t*& plane : planes) {
+                plane = &store[pick(rng) * planeSize];
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            GatherNormalizePlanes(planes.data(), planes.size(), planeSize, 1.0f / 255.0f, output.data());
+            seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            // Verify against the scalar kernel on the same gather
+            if (level != (int)KernelLevel::Scalar && it == 0) {
+                for (size_t i = 0; i < planes.size(); i++) {
+                    convertScalar(planes[i], &reference[i * planeSize], planeSize, 1.0f / 255.0f);
+                }
+                if (memcmp(reference.data(), output.data(), output.size() * sizeof(float)) != 0) {
+                    printf("  %-6s output differs from scalar kernel\n", KernelLevelName((KernelLevel)level));
+                    ok = false;
+                }
+            }
+        }
+
+        if (level == (int)KernelLevel::Scalar) {
+            scalarSeconds = seconds;
+        }
+        printf("  %-6s %8.3f ms/batch  %6.2f GB/s  %5.2fx\n", KernelLevelName((KernelLevel)level),
+               seconds * 1000.0 / iterations, bytesPerBatch * iterations / seconds / 1e9,
+               seconds > 0.0 ? scalarSeconds / seconds : 0.0);
+    }
+
+    SetKernelLevel(previous);
+    return ok;
+}
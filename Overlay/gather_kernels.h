@@ -0,0 +1,50 @@
+// gather_kernels.h
+#ifndef GATHER_KERNELS_H
+#define GATHER_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Instruction set used by the gather kernels
+enum class KernelLevel {
+    Scalar,
+    SSE2,
+    AVX2,
+};
+
+// Best level the running CPU and OS support
+KernelLevel DetectKernelLevel();
+
+// Level currently used by GatherNormalizePlanes (detected on first use)
+KernelLevel GetKernelLevel();
+
+// Force a level, e.g. for benchmarking; requests above the detected level are clamped.
+// Returns the level actually selected.
+KernelLevel SetKernelLevel(KernelLevel level);
+
+const char* KernelLevelName(KernelLevel level);
+
+/**
+ * @brief Gathers uint8 planes into one contiguous float tensor
+ *
+ * planes[i] points at planeSize bytes; plane i is written to dst + i * planeSize as
+ * value * scale. With the trainer's planes in (frame, eye) order this produces the
+ * stacked NCHW channel layout of one sample.
+ */
+void GatherNormalizePlanes(const uint8_t* const* planes, size_t planeCount, size_t planeSize,
+                           float scale, float* dst);
+
+/**
+ * @brief Maps bytes through a 256-entry float table and adds optional noise
+ *
+ * dst[i] = lut[src[i]] + noise[i], or just the lookup when noise is NULL. The table
+ * folds the normalisation scale and any per-plane intensity curve into one pass. Every
+ * level produces bit-identical results.
+ */
+void ConvertLutAddNoise(const uint8_t* src, const float* lut, const float* noise, size_t count, float* dst);
+
+// Times every available level on a synthetic batch of the given shape, checks that
+// they agree with the scalar kernel and prints throughput. Returns false on mismatch.
+bool RunGatherBenchmark(size_t batchSize, size_t planesPerSample, size_t planeSize, int iterations);
+
+#endif // GATHER_KERNELS_H
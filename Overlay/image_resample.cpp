@@ -0,0 +1,482 @@
+#include "image_resample.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define RESAMPLE_SSE2 1
+    #include <emmintrin.h>
+#else
+    #define RESAMPLE_SSE2 0
+#endif
+
+bool ParseResampleMode(const char* name, ResampleMode& mode) {
+    if (strcmp(name, "nearest") == 0) {
+        mode = ResampleMode::Nearest;
+    } else if (strcmp(name, "bilinear") == 0) {
+        mode = ResampleMode::Bilinear;
+    } else if (strcmp(name, "area") == 0) {
+        mode = ResampleMode::Area;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* ResampleModeName(ResampleMode mode) {
+    switch (mode) {
+        case ResampleMode::Nearest: return "nearest";
+        case ResampleMode::Bilinear: return "bilinear";
+        default: return "area";
+    }
+}
+
+// Source taps of one output sample along an axis
+struct FilterTaps {
+    std::vector<int> first;      // first source index per output index
+    std::vector<int> count;      // number of taps per output index
+    std::vector<float> weights;  // maxTaps weights per output index
+    int maxTaps = 0;
+};
+
+static void buildTaps(int srcSize, int dstSize, ResampleMode mode, FilterTaps& taps) {
+    const double scale = (double)srcSize / dstSize;
+
+    switch (mode) {
+        case ResampleMode::Nearest: taps.maxTaps = 1; break;
+        case ResampleMode::Bilinear: taps.maxTaps = 2; break;
+        default: taps.maxTaps = (int)std::ceil(scale) + 1; break;
+    }
+
+    taps.first.assign(dstSize, 0);
+    taps.count.assign(dstSize, 0);
+    taps.weights.assign((size_t)dstSize * taps.maxTaps, 0.0f);
+
+    for (int i = 0; i < dstSize; i++) {
+        float* w = &taps.weights[(size_t)i * taps.maxTaps];
+
+        if (mode == ResampleMode::Nearest) {
+            taps.first[i] = std::min((int)(i * scale), srcSize - 1);
+            taps.count[i] = 1;
+            w[0] = 1.0f;
+        } else if (mode == ResampleMode::Bilinear) {
+            double centre = (i + 0.5) * scale - 0.5;
+            int j = (int)std::floor(centre);
+            float frac = (float)(centre - j);
+            if (j < 0) {
+                j = 0;
+                frac = 0.0f;
+            }
+            if (j >= srcSize - 1) {
+                j = srcSize - 1;
+                frac = 0.0f;
+            }
+            taps.first[i] = j;
+            taps.count[i] = (frac > 0.0f) ? 2 : 1;
+            w[0] = 1.0f - frac;
+            w[1] = frac;
+        } else {
+            // Overlap of [i, i + 1) * scale with each source pixel
+            double start = i * scale;
+            double end = std::min((i + 1) * scale, (double)srcSize);
+            int j0 = (int)std::floor(start);
+            int j1 = std::min((int)std::ceil(end), srcSize);
+            taps.first[i] = j0;
+            taps.count[i] = j1 - j0;
+
+            double total = end - start;
+            for (int j = j0; j < j1; j++) {
+                double overlap = std::min(end, (double)j + 1) - std::max(start, (double)j);
+                w[j - j0] = (float)(overlap / total);
+            }
+        }
+    }
+}
+
+static inline uint8_t toByte(float value) {
+    value += 0.5f;
+    return (uint8_t)(value <= 0.0f ? 0 : (value >= 255.0f ? 255 : (int)value));
+}
+
+// Adds one source row of a channel to the 16 bit column sums. Packed planes and the
+// single byte of 4-byte pixels (a channel of RGBX) are summed with SIMD.
+static void addRowToColumnSums(const uint8_t* row, int width, int pixelStride, uint16_t* sums) {
+    int x = 0;
+#if RESAMPLE_SSE2
+    if (pixelStride == 1) {
+        const __m128i zero = _mm_setzero_si128();
+        for (; x + 16 <= width; x += 16) {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+            __m128i* out = reinterpret_cast<__m128i*>(sums + x);
+            _mm_storeu_si128(out, _mm_add_epi16(_mm_loadu_si128(out), _mm_unpacklo_epi8(bytes, zero)));
+            _mm_storeu_si128(out + 1, _mm_add_epi16(_mm_loadu_si128(out + 1), _mm_unpackhi_epi8(bytes, zero)));
+        }
+    } else if (pixelStride == 4) {
+        // 8 pixels per step; the loads end before the last pixel, whose trailing bytes
+        // may lie past the row when row points at a later channel
+        const __m128i mask = _mm_set1_epi32(0xFF);
+        for (; x + 8 < width; x += 8) {
+            __m128i lo = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + (size_t)x * 4)), mask);
+            __m128i hi = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + (size_t)x * 4 + 16)), mask);
+            __m128i* out = reinterpret_cast<__m128i*>(sums + x);
+            _mm_storeu_si128(out, _mm_add_epi16(_mm_loadu_si128(out), _mm_packs_epi32(lo, hi)));
+        }
+    }
+#endif
+    for (; x < width; x++) {
+        sums[x] = (uint16_t)(sums[x] + row[(size_t)x * pixelStride]);
+    }
+}
+
+// Area average at an integer ratio: k source rows are summed into 16 bit column sums,
+// then every k columns are reduced and divided with rounding
+static void areaIntegerRatio(const uint8_t* src, int srcWidth, size_t srcRowStride, int srcPixelStride,
+                             uint8_t* dst, int dstWidth, int dstHeight, size_t dstRowStride, int dstPixelStride,
+                             int k) {
+    std::vector<uint16_t> columnSums(srcWidth);
+    const uint32_t divisor = (uint32_t)(k * k);
+
+    for (int y = 0; y < dstHeight; y++) {
+        std::fill(columnSums.begin(), columnSums.end(), 0);
+        for (int r = 0; r < k; r++) {
+            addRowToColumnSums(src + (size_t)(y * k + r) * srcRowStride, srcWidth, srcPixelStride, columnSums.data());
+        }
+
+        uint8_t* out = dst + (size_t)y * dstRowStride;
+        const uint16_t* sums = columnSums.data();
+        for (int x = 0; x < dstWidth; x++, sums += k) {
+            uint32_t total = 0;
+            for (int c = 0; c < k; c++) {
+                total += sums[c];
+            }
+            out[(size_t)x * dstPixelStride] = (uint8_t)((total + divisor / 2) / divisor);
+        }
+    }
+}
+
+#if RESAMPLE_SSE2
+// Taps per output index of the fixed point path, one SSE2 register of 16 bit weights
+static const int FIXED_TAPS = 8;
+static const int WEIGHT_BITS = 14;
+// Fraction bits the vertical pass keeps; 255 << 6 still fits a signed 16 bit lane
+static const int COLUMN_BITS = 6;
+
+// Filter weights in WEIGHT_BITS fixed point, at least FIXED_TAPS and an even number per
+// output index, zero after the last tap. The running sum is rounded rather than each
+// weight, so every set sums to 1 exactly. Returns the number per output index.
+static int fixedWeights(const FilterTaps& taps, std::vector<int16_t>& weights) {
+    const int outputs = (int)taps.first.size();
+    const int stride = std::max(FIXED_TAPS, (taps.maxTaps + 1) & ~1);
+    weights.assign((size_t)outputs * stride, 0);
+    for (int i = 0; i < outputs; i++) {
+        const float* w = &taps.weights[(size_t)i * taps.maxTaps];
+        int16_t* fixed = &weights[(size_t)i * stride];
+        double sum = 0.0;
+        long previous = 0;
+        for (int t = 0; t < taps.count[i]; t++) {
+            sum += w[t];
+            const long next = t + 1 < taps.count[i] ? std::lround(sum * (1 << WEIGHT_BITS)) : (1 << WEIGHT_BITS);
+            fixed[t] = (int16_t)(next - previous);
+            previous = next;
+        }
+    }
+    return stride;
+}
+
+// One row of a channel widened to 16 bit. width is a multiple of 8 past the pixels, which
+// are zeroed. The SIMD loads of 4-byte pixels cover 32 bytes from pixel x, so they stop
+// before the last pixel, whose trailing bytes may lie past the row.
+static void widenRow(const uint8_t* row, int pixels, int pixelStride, int16_t* dst, int width) {
+    int x = 0;
+    if (pixelStride == 1) {
+        const __m128i zero = _mm_setzero_si128();
+        for (; x + 16 <= pixels; x += 16) {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm_unpacklo_epi8(bytes, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x + 8), _mm_unpackhi_epi8(bytes, zero));
+        }
+    } else if (pixelStride == 4) {
+        const __m128i mask = _mm_set1_epi32(0xFF);
+        for (; x + 8 < pixels; x += 8) {
+            __m128i lo = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + (size_t)x * 4)), mask);
+            __m128i hi = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + (size_t)x * 4 + 16)), mask);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm_packs_epi32(lo, hi));
+        }
+    }
+    for (; x < pixels; x++) {
+        dst[x] = row[(size_t)x * pixelStride];
+    }
+    for (; x < width; x++) {
+        dst[x] = 0;
+    }
+}
+
+/**
+ * Fixed point form of the separable filter for Area and Bilinear with up to FIXED_TAPS
+ * horizontal taps. Source rows are widened to 16 bit once each, into a ring that holds
+ * the rows of the current output row. The vertical pass accumulates them in pairs with
+ * _mm_madd_epi16 into a 16 bit row with COLUMN_BITS of fraction; the horizontal pass
+ * then takes one 8-lane madd per output and reduces four outputs at a time. Results are
+ * within one level of the float path.
+ */
+static void resampleFixedPoint(const uint8_t* src, int srcWidth, size_t srcRowStride, int srcPixelStride,
+                               uint8_t* dst, int dstWidth, int dstHeight, size_t dstRowStride, int dstPixelStride,
+                               const FilterTaps& xTaps, const FilterTaps& yTaps) {
+    std::vector<int16_t> xWeights, yWeights;
+    fixedWeights(xTaps, xWeights);
+    const int yStride = fixedWeights(yTaps, yWeights);
+
+    // Rows padded to whole registers plus FIXED_TAPS, so the horizontal loads of the last
+    // outputs stay inside; the padding meets zero weights. Ring slot yStride is all zeros
+    // and pairs up with the last row of an odd tap count.
+    const int width = (srcWidth + 7) / 8 * 8 + FIXED_TAPS;
+    std::vector<int16_t> ring((size_t)(yStride + 1) * width, 0);
+    std::vector<int> ringRow(yStride, -1);
+    std::vector<const int16_t*> rows(yStride);
+    std::vector<int16_t> column(width, 0);
+
+    const int columnShift = WEIGHT_BITS - COLUMN_BITS;
+    const int outputShift = WEIGHT_BITS + COLUMN_BITS;
+    const int outputRound = 1 << (outputShift - 1);
+
+    for (int y = 0; y < dstHeight; y++) {
+        const int16_t* wy = &yWeights[(size_t)y * yStride];
+        const int rowCount = yTaps.count[y];
+        for (int t = 0; t < yStride; t++) {
+            const int sy = yTaps.first[y] + t;
+            const int slot = sy % yStride;
+            if (t < rowCount && ringRow[slot] != sy) {
+                widenRow(src + (size_t)sy * srcRowStride, srcWidth, srcPixelStride, &ring[(size_t)slot * width], width);
+                ringRow[slot] = sy;
+            }
+            rows[t] = t < rowCount ? &ring[(size_t)slot * width] : &ring[(size_t)yStride * width];
+        }
+
+        // Vertical pass, two source rows per madd
+        for (int x = 0; x + 8 <= width; x += 8) {
+            __m128i accLo = _mm_set1_epi32(1 << (columnShift - 1));
+            __m128i accHi = accLo;
+            for (int t = 0; t < rowCount; t += 2) {
+                const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[t] + x));
+                const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[t + 1] + x));
+                const __m128i weights = _mm_set1_epi32((int)(((uint32_t)(uint16_t)wy[t + 1] << 16) | (uint16_t)wy[t]));
+                accLo = _mm_add_epi32(accLo, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), weights));
+                accHi = _mm_add_epi32(accHi, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), weights));
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&column[x]),
+                             _mm_packs_epi32(_mm_srai_epi32(accLo, columnShift), _mm_srai_epi32(accHi, columnShift)));
+        }
+
+        // Horizontal pass, four outputs per step
+        uint8_t* out = dst + (size_t)y * dstRowStride;
+        int x = 0;
+        for (; x + 4 <= dstWidth; x += 4) {
+            __m128i sums[4];
+            for (int k = 0; k < 4; k++) {
+                const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&column[xTaps.first[x + k]]));
+                const __m128i weights = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&xWeights[(size_t)(x + k) * FIXED_TAPS]));
+                sums[k] = _mm_madd_epi16(pixels, weights);
+            }
+            const __m128i ab = _mm_add_epi32(_mm_unpacklo_epi32(sums[0], sums[1]), _mm_unpackhi_epi32(sums[0], sums[1]));
+            const __m128i cd = _mm_add_epi32(_mm_unpacklo_epi32(sums[2], sums[3]), _mm_unpackhi_epi32(sums[2], sums[3]));
+            __m128i total = _mm_add_epi32(_mm_unpacklo_epi64(ab, cd), _mm_unpackhi_epi64(ab, cd));
+            total = _mm_srai_epi32(_mm_add_epi32(total, _mm_set1_epi32(outputRound)), outputShift);
+            const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(total, total), total);
+            const uint32_t bytes = (uint32_t)_mm_cvtsi128_si32(packed);
+            if (dstPixelStride == 1) {
+                memcpy(out + x, &bytes, 4);
+            } else {
+                for (int k = 0; k < 4; k++) {
+                    out[(size_t)(x + k) * dstPixelStride] = (uint8_t)(bytes >> (8 * k));
+                }
+            }
+        }
+        for (; x < dstWidth; x++) {
+            const int16_t* wx = &xWeights[(size_t)x * FIXED_TAPS];
+            int acc = outputRound;
+            for (int t = 0; t < xTaps.count[x]; t++) {
+                acc += column[xTaps.first[x] + t] * wx[t];
+            }
+            out[(size_t)x * dstPixelStride] = (uint8_t)std::min(acc >> outputShift, 255);
+        }
+    }
+}
+#endif
+
+// General path: separable filter taps, horizontal pass into floats, then vertical
+static void resampleSeparable(const uint8_t* src, int srcHeight, size_t srcRowStride, int srcPixelStride,
+                              uint8_t* dst, int dstWidth, int dstHeight, size_t dstRowStride, int dstPixelStride,
+                              const FilterTaps& xTaps, const FilterTaps& yTaps) {
+    // Horizontal pass on the source rows that are actually referenced, into floats
+    std::vector<float> rows((size_t)srcHeight * dstWidth);
+    std::vector<char> rowNeeded(srcHeight, 0);
+    for (int y = 0; y < dstHeight; y++) {
+        for (int t = 0; t < yTaps.count[y]; t++) {
+            rowNeeded[yTaps.first[y] + t] = 1;
+        }
+    }
+
+    for (int sy = 0; sy < srcHeight; sy++) {
+        if (!rowNeeded[sy]) {
+            continue;
+        }
+        const uint8_t* row = src + (size_t)sy * srcRowStride;
+        float* out = &rows[(size_t)sy * dstWidth];
+
+        for (int x = 0; x < dstWidth; x++) {
+            const uint8_t* p = row + (size_t)xTaps.first[x] * srcPixelStride;
+            const float* w = &xTaps.weights[(size_t)x * xTaps.maxTaps];
+            float sum = 0.0f;
+            for (int t = 0; t < xTaps.count[x]; t++) {
+                sum += p[(size_t)t * srcPixelStride] * w[t];
+            }
+            out[x] = sum;
+        }
+    }
+
+    // Vertical pass: weighted sum of whole intermediate rows (contiguous, vectorisable)
+    std::vector<float> accum(dstWidth);
+    for (int y = 0; y < dstHeight; y++) {
+        std::fill(accum.begin(), accum.end(), 0.0f);
+        const float* w = &yTaps.weights[(size_t)y * yTaps.maxTaps];
+
+        for (int t = 0; t < yTaps.count[y]; t++) {
+            const float* row = &rows[(size_t)(yTaps.first[y] + t) * dstWidth];
+            const float weight = w[t];
+            for (int x = 0; x < dstWidth; x++) {
+                accum[x] += row[x] * weight;
+            }
+        }
+
+        uint8_t* out = dst + (size_t)y * dstRowStride;
+        for (int x = 0; x < dstWidth; x++) {
+            out[(size_t)x * dstPixelStride] = toByte(accum[x]);
+        }
+    }
+}
+
+void ResamplePlane(const uint8_t* src, int srcWidth, int srcHeight, size_t srcRowStride, int srcPixelStride,
+                   uint8_t* dst, int dstWidth, int dstHeight, size_t dstRowStride, int dstPixelStride,
+                   ResampleMode mode) {
+    if (!src || !dst || srcWidth <= 0 || srcHeight <= 0 || dstWidth <= 0 || dstHeight <= 0) {
+        return;
+    }
+
+    // Fast path: exact integer downscale. k <= 16 keeps the sums in 16 bits.
+    if (mode == ResampleMode::Area && srcWidth % dstWidth == 0 && srcHeight % dstHeight == 0) {
+        int k = srcWidth / dstWidth;
+        if (k >= 2 && k <= 16 && srcHeight / dstHeight == k) {
+            areaIntegerRatio(src, srcWidth, srcRowStride, srcPixelStride, dst, dstWidth, dstHeight, dstRowStride,
+                             dstPixelStride, k);
+            return;
+        }
+    }
+
+    // Nearest needs no filtering, only the source index of every column and row
+    if (mode == ResampleMode::Nearest) {
+        FilterTaps xTaps;
+        buildTaps(srcWidth, dstWidth, mode, xTaps);
+        for (int y = 0; y < dstHeight; y++) {
+            const int sy = std::min((int)(y * ((double)srcHeight / dstHeight)), srcHeight - 1);
+            const uint8_t* row = src + (size_t)sy * srcRowStride;
+            uint8_t* out = dst + (size_t)y * dstRowStride;
+            for (int x = 0; x < dstWidth; x++) {
+                out[(size_t)x * dstPixelStride] = row[(size_t)xTaps.first[x] * srcPixelStride];
+            }
+        }
+        return;
+    }
+
+    FilterTaps xTaps, yTaps;
+    buildTaps(srcWidth, dstWidth, mode, xTaps);
+    buildTaps(srcHeight, dstHeight, mode, yTaps);
+#if RESAMPLE_SSE2
+    if (xTaps.maxTaps <= FIXED_TAPS) {
+        resampleFixedPoint(src, srcWidth, srcRowStride, srcPixelStride, dst, dstWidth, dstHeight, dstRowStride,
+                           dstPixelStride, xTaps, yTaps);
+        return;
+    }
+#endif
+    resampleSeparable(src, srcHeight, srcRowStride, srcPixelStride, dst, dstWidth, dstHeight, dstRowStride,
+                      dstPixelStride, xTaps, yTaps);
+}
+
+// Nearest-neighbour loop the trainer used before the resampler, on the red byte of RGBX
+static void legacyNearest(const uint32_t* src, int srcWidth, int srcHeight, uint8_t* dst, int dstSize) {
+    const float xScale = (float)srcWidth / dstSize;
+    const float yScale = (float)srcHeight / dstSize;
+    for (int y = 0; y < dstSize; y++) {
+        const int srcY = std::max(0, std::min((int)(y * yScale), srcHeight - 1));
+        for (int x = 0; x < dstSize; x++) {
+            const int srcX = std::max(0, std::min((int)(x * xScale), srcWidth - 1));
+            dst[y * dstSize + x] = (uint8_t)(src[srcY * srcWidth + srcX] & 0xFF);
+        }
+    }
+}
+
+bool RunResampleBenchmark(int srcSize, int dstSize, int iterations) {
+    // Random RGBX frame, read through the red byte the way the frame cache does
+    std::vector<uint32_t> frame((size_t)srcSize * srcSize);
+    std::mt19937 rng(1234);
+    for (uint32_t& pixel : frame) {
+        pixel = rng();
+    }
+    const uint8_t* red = reinterpret_cast<const uint8_t*>(frame.data());
+    const size_t rowStride = (size_t)srcSize * 4;
+    std::vector<uint8_t> output((size_t)dstSize * dstSize);
+    std::vector<uint8_t> reference((size_t)dstSize * dstSize);
+
+    const bool integerRatio = srcSize % dstSize == 0 && srcSize / dstSize >= 2 && srcSize / dstSize <= 16;
+    printf("Resample benchmark: %dx%d RGBX red byte to %dx%d%s, %d iterations\n", srcSize, srcSize, dstSize,
+           dstSize, integerRatio ? " (integer ratio)" : "", iterations);
+
+    auto timeIt = [&](auto&& run) {
+        auto start = std::chrono::steady_clock::now();
+        for (int it = 0; it < iterations; it++) {
+            run();
+        }
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / iterations;
+    };
+
+    const double legacySeconds = timeIt([&]() { legacyNearest(frame.data(), srcSize, srcSize, output.data(), dstSize); });
+    printf("  %-16s %8.3f ms/plane\n", "legacy nearest", legacySeconds * 1000.0);
+
+    const ResampleMode modes[] = {ResampleMode::Nearest, ResampleMode::Bilinear, ResampleMode::Area};
+    for (ResampleMode mode : modes) {
+        const double seconds = timeIt([&]() {
+            ResamplePlane(red, srcSize, srcSize, rowStride, 4, output.data(), dstSize, dstSize, dstSize, 1, mode);
+        });
+        printf("  %-16s %8.3f ms/plane  %5.2fx legacy\n", ResampleModeName(mode), seconds * 1000.0,
+               seconds > 0.0 ? legacySeconds / seconds : 0.0);
+    }
+
+    // The fast paths of the filtered modes against the float separable filter
+    bool ok = true;
+    const ResampleMode filtered[] = {ResampleMode::Bilinear, ResampleMode::Area};
+    for (ResampleMode mode : filtered) {
+        const double floatSeconds = timeIt([&]() {
+            FilterTaps xTaps, yTaps;
+            buildTaps(srcSize, dstSize, mode, xTaps);
+            buildTaps(srcSize, dstSize, mode, yTaps);
+            resampleSeparable(red, srcSize, rowStride, 4, reference.data(), dstSize, dstSize, dstSize, 1, xTaps,
+                              yTaps);
+        });
+        ResamplePlane(red, srcSize, srcSize, rowStride, 4, output.data(), dstSize, dstSize, dstSize, 1, mode);
+        int maxDifference = 0;
+        for (size_t i = 0; i < output.size(); i++) {
+            maxDifference = std::max(maxDifference, std::abs((int)output[i] - (int)reference[i]));
+        }
+        const std::string name = std::string(ResampleModeName(mode)) + " float";
+        printf("  %-16s %8.3f ms/plane  %5.2fx legacy, max difference %d\n", name.c_str(), floatSeconds * 1000.0,
+               floatSeconds > 0.0 ? legacySeconds / floatSeconds : 0.0, maxDifference);
+        ok = ok && maxDifference <= 1;
+    }
+    return ok;
+}
@@ -0,0 +1,52 @@
+#include "lr_schedule.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+bool ParseLRSchedule(const char* name, LRScheduleType& type) {
+    if (strcmp(name, "constant") == 0) {
+        type = LRScheduleType::Constant;
+    } else if (strcmp(name, "linear") == 0) {
+        type = LRScheduleType::Linear;
+    } else if (strcmp(name, "cosine") == 0) {
+        type = LRScheduleType::Cosine;
+    } else if (strcmp(name, "step") == 0) {
+        type = LRScheduleType::Step;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* LRScheduleName(LRScheduleType type) {
+    switch (type) {
+        case LRScheduleType::Linear: return "linear";
+        case LRScheduleType::Cosine: return "cosine";
+        case LRScheduleType::Step: return "step";
+        default: return "constant";
+    }
+}
+
+float LRSchedule::RateAt(int64_t step) const {
+    step = std::max<int64_t>(step, 0);
+    if (step < warmupSteps) {
+        return baseRate * (float)(step + 1) / (float)warmupSteps;
+    }
+
+    const int64_t decaySteps = std::max<int64_t>(totalSteps - warmupSteps, 1);
+    const int64_t decayStep = std::min(step - warmupSteps, decaySteps);
+
+    switch (type) {
+        case LRScheduleType::Linear:
+            return baseRate * (float)(decaySteps - decayStep) / (float)decaySteps;
+        case LRScheduleType::Cosine: {
+            const double progress = (double)decayStep / (double)decaySteps;
+            return minRate + (baseRate - minRate) * (float)(0.5 * (1.0 + std::cos(3.14159265358979323846 * progress)));
+        }
+        case LRScheduleType::Step:
+            return baseRate * std::pow(gamma, (float)(decayStep / std::max<int64_t>(stepInterval, 1)));
+        default:
+            return baseRate;
+    }
+}
@@ -0,0 +1,37 @@
+// lr_schedule.h
+#ifndef LR_SCHEDULE_H
+#define LR_SCHEDULE_H
+
+#include <cstdint>
+
+enum class LRScheduleType {
+    Constant,   // base rate throughout (after any warmup)
+    Linear,     // linear warmup, then linear decay to zero (ORT's built-in scheduler)
+    Cosine,     // linear warmup, then half-cosine decay to minRate
+    Step,       // linear warmup, then multiply by gamma every stepInterval steps
+};
+
+// Parses "constant", "linear", "cosine" or "step"; returns false for anything else
+bool ParseLRSchedule(const char* name, LRScheduleType& type);
+const char* LRScheduleName(LRScheduleType type);
+
+/**
+ * @brief Learning rate as a function of the optimizer step
+ *
+ * Linear has the shape of ORT's RegisterLinearLRScheduler, which the trainer uses for
+ * that schedule; the others are driven from the host through SetLearningRate.
+ */
+struct LRSchedule {
+    LRScheduleType type = LRScheduleType::Constant;
+    float baseRate = 1e-4f;
+    float minRate = 0.0f;
+    int64_t warmupSteps = 0;
+    int64_t totalSteps = 1;
+    int64_t stepInterval = 1;
+    float gamma = 0.5f;
+
+    // Rate for the optimizer step with the given zero-based index
+    float RateAt(int64_t step) const;
+};
+
+#endif // LR_SCHEDULE_H
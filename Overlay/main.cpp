@@ -57,7 +57,7 @@ FileHandle openCaptureFile(const char* filename) {
         return CreateFileA(
             filename,
             GENERIC_WRITE,
-            0,
+            FILE_SHARE_READ,  // the trainer may follow the capture while it is written
             NULL,
             CREATE_ALWAYS,
             FILE_ATTRIBUTE_NORMAL,
@@ -77,6 +77,23 @@ bool writeCaptureFrame(FileHandle handle, const void* data, size_t size) {
     #endif
 }
 
+// Rewrites the header with CAPTURE_FLAG_COMPLETE set, leaving the write position at the end
+bool markCaptureComplete(FileHandle handle, CaptureFileHeader& header) {
+    header.flags |= CAPTURE_FLAG_COMPLETE;
+    #ifdef _WIN32
+        DWORD bytesWritten;
+        LARGE_INTEGER start = {};
+        LARGE_INTEGER end = {};
+        bool ok = SetFilePointerEx(handle, start, &end, FILE_CURRENT) &&
+                  SetFilePointerEx(handle, start, NULL, FILE_BEGIN) &&
+                  WriteFile(handle, &header, (DWORD)sizeof(header), &bytesWritten, NULL) && bytesWritten == sizeof(header);
+        SetFilePointerEx(handle, end, NULL, FILE_BEGIN);
+        return ok;
+    #else
+        return pwrite(handle, &header, sizeof(header), 0) == (ssize_t)sizeof(header);
+    #endif
+}
+
 void closeCaptureFile(FileHandle handle) {
     #ifdef _WIN32
         CloseHandle(handle);
@@ -170,6 +187,7 @@ float g_fTargetPitchOffset = 0.0f; // Current pitch offset of target from center
 bool g_bTargetLocked = false;     // Whether the target position is locked
 bool g_Recording = false; // is recording data
 bool g_runningCalibration = false;
+bool g_onlineTraining = false; // start the trainer on the capture while it is still recorded
 bool g_isTrained = false;
 DashboardUI g_DashboardUI;
 TrainerWrapper g_Trainer;
@@ -254,6 +272,120 @@ void print_active_flags(uint32_t flags) {
     }
 }
 
+// Launches the trainer on a capture file. online starts it with --follow while the
+// capture is still being recorded.
+void startTrainer(const char* captureFile, bool online) {
+    printf("Starting %strainer with capture file: %s\n", online ? "online " : "", captureFile);
+
+    std::vector<std::string> extraArgs;
+    if (online) {
+        extraArgs.push_back("--follow");
+    }
+
+    g_Trainer.start(captureFile, g_outputModelPath,
+        [](const std::string& output){
+            printf("trainer output: %s", output.c_str());
+        },
+        [](const TrainerProgress& progress){
+            printf("DEBUG: Trainer progress callback invoked - isTraining=%d, isComplete=%d, hasError=%d\n", 
+                   progress.isTraining, progress.isComplete, progress.hasError);
+            // Set global training progress (to be used by main thread)
+            std::string progressDisplay = "   ~~ Neural Network Training ~~ \n\n";
+            
+            if (progress.isComplete) {
+                progressDisplay += "Training Complete!\n";
+                progressDisplay += "Final Loss: " + std::to_string(progress.epochAverageLoss);
+            } else if (progress.hasError) {
+                progressDisplay += "Training Error:\n" + progress.lastError;
+            } else if (progress.isTraining) {
+                // Epoch 0 is the online phase while the capture is still recorded
+                if (progress.currentEpoch == 0) {
+                    progressDisplay += "Learning while recording...\n";
+                }
+                // Epoch progress
+                if (progress.totalEpochs > 0 && progress.currentEpoch > 0) {
+                    float epochProgress = static_cast<float>(progress.currentEpoch) / progress.totalEpochs;
+                    progressDisplay += "Epoch: " + std::to_string(progress.currentEpoch) + "/" + std::to_string(progress.totalEpochs) + "\n";
+                    
+                    // ASCII progress bar
+                    int barWidth = 20;
+                    int pos = static_cast<int>(barWidth * epochProgress);
+                    std::string bar = "[";
+                    for (int i = 0; i < barWidth; ++i) {
+                        if (i < pos) bar += "|";
+                        //else if (i == pos) bar += "▌";
+                        else bar += ".";
+                    }
+                    bar += "] " + std::to_string(static_cast<int>(epochProgress * 100)) + "%\n\n";
+                    progressDisplay += bar;
+                }
+                
+                // Batch progress
+                if (progress.totalBatches > 0) {
+                    float batchProgress = static_cast<float>(progress.currentBatch) / progress.totalBatches;
+                    progressDisplay += "Batch: " + std::to_string(progress.currentBatch) + "/" + std::to_string(progress.totalBatches) + "\n";
+                    
+                    int barWidth = 20;
+                    int pos = static_cast<int>(barWidth * batchProgress);
+                    std::string bar = "[";
+                    for (int i = 0; i < barWidth; ++i) {
+                        if (i < pos) bar += "|";
+                        //else if (i == pos) bar += "▌";
+                        else bar += ".";
+                    }
+                    bar += "] " + std::to_string(static_cast<int>(batchProgress * 100)) + "%\n\n";
+                    progressDisplay += bar;
+                }
+                
+                // Current loss
+                if (progress.currentLoss > 0) {
+                    progressDisplay += "Current Loss: " + std::to_string(progress.currentLoss) + "\n";
+                }
+                if (progress.epochAverageLoss > 0) {
+                    progressDisplay += "Epoch Avg: " + std::to_string(progress.epochAverageLoss) + "\n";
+                }
+                
+                if (progress.validationLoss > 0) {
+                    progressDisplay += "Validation: " + std::to_string(progress.validationLoss) + "\n";
+                }
+                
+                // ETA as reported by the trainer
+                if (progress.etaSeconds >= 0) {
+                    float etaSeconds = progress.etaSeconds;
+                    
+                    int eta_hours = static_cast<int>(etaSeconds) / 3600;
+                    int eta_minutes = (static_cast<int>(etaSeconds) % 3600) / 60;
+                    int eta_secs = static_cast<int>(etaSeconds) % 60;
+                    
+                    progressDisplay += "ETA: ";
+                    if (eta_hours > 0) progressDisplay += std::to_string(eta_hours) + "h ";
+                    if (eta_minutes > 0 || eta_hours > 0) progressDisplay += std::to_string(eta_minutes) + "m ";
+                    progressDisplay += std::to_string(eta_secs) + "s\n";
+                }
+                
+                // Add graph label if we have data
+                if (progress.lossHistory.size() > 1) {
+                    progressDisplay += "\nLoss Trend Graph:\n";
+                }
+            } else {
+                progressDisplay += "Training is getting started, please wait...";
+            }
+            
+            // Set global variables for main thread to use
+            g_trainingProgressDisplay = progressDisplay;
+            g_trainingLossHistory = progress.lossHistory;
+            g_hasTrainingUpdate = true;
+            printf("DEBUG: Set g_hasTrainingUpdate=true, progressDisplay length=%zu, lossHistory size=%zu\n", 
+                   progressDisplay.length(), progress.lossHistory.size());
+        },
+        [](){
+            printf("trainer finished!");
+            g_isTrained = true;
+        },
+        extraArgs
+    );
+}
+
 void RunPreviewInference(FrameBuffer* frameBufferLeft, FrameBuffer* frameBufferRight, OverlayManager* overlayManager) {
     // Print info about starting preview thread
     printf("Starting preview inference thread with model: %s\n", g_PreviewModelPath.c_str());
@@ -514,7 +646,7 @@ int main(int argc, char* argv[])
 
 
     // returns the status of the current calibration. if status=complete, you can use the checkpoint at the path specified in /start_calibration
-    server.register_handler("/status", [](const std::unordered_map<std::string, std::string>& params){
+    server.register_handler("/status", [&frameBufferLeft, &frameBufferRight](const std::unordered_map<std::string, std::string>& params){
 
         std::string sRunning = std::to_string(g_runningCalibration);
         std::string sRecording = std::to_string(g_Recording);
@@ -524,7 +656,16 @@ int main(int argc, char* argv[])
         std::string sMaxOpIndex = std::to_string(g_OverlayManager.g_routineController.getTotalOperationCount());
         std::string sIstrained = std::to_string(g_isTrained);
 
-        return "{\"result\":\"ok\", \"running\":\""+sRunning+"\", \"recording\":\""+sRecording+"\", \"calibrationComplete\":\""+sIsCalibrationComplete+"\", \"isTrained\":\""+sIstrained+"\", \"currentIndex\":"+sCurrentOpIndex+", \"maxIndex\":"+sMaxOpIndex+"}";
+        ClockSyncStats syncLeft = frameBufferLeft.getClockSyncStats();
+        ClockSyncStats syncRight = frameBufferRight.getClockSyncStats();
+        std::string sClockSync = "{\"leftValid\":" + std::to_string(syncLeft.valid) +
+            ", \"leftDriftPpm\":" + std::to_string(syncLeft.driftPpm) +
+            ", \"leftJitterUs\":" + std::to_string(syncLeft.jitterUs) +
+            ", \"rightValid\":" + std::to_string(syncRight.valid) +
+            ", \"rightDriftPpm\":" + std::to_string(syncRight.driftPpm) +
+            ", \"rightJitterUs\":" + std::to_string(syncRight.jitterUs) + "}";
+
+        return "{\"result\":\"ok\", \"running\":\""+sRunning+"\", \"recording\":\""+sRecording+"\", \"calibrationComplete\":\""+sIsCalibrationComplete+"\", \"isTrained\":\""+sIstrained+"\", \"currentIndex\":"+sCurrentOpIndex+", \"maxIndex\":"+sMaxOpIndex+", \"clockSync\":"+sClockSync+"}";
     });
 
     server.register_handler("/settings", [](const std::unordered_map<std::string, std::string>& params){
@@ -597,6 +738,7 @@ int main(int argc, char* argv[])
         }
         
         g_outputModelPath = decodedPath;    
+        g_onlineTraining = params.count("online_training") != 0 && params.at("online_training") == "1";
 
         g_OverlayManager.StartRoutine((uint32_t) std::stoi(params.at("routine_id")));
 
@@ -788,6 +930,17 @@ int main(int argc, char* argv[])
         return -1;
     }
 
+    // All timestamps in this capture are on the host monotonic clock, in microseconds
+    CaptureFileHeader captureHeader;
+    memcpy(captureHeader.magic, CAPTURE_FILE_MAGIC, sizeof(captureHeader.magic));
+    captureHeader.version = CAPTURE_FILE_VERSION;
+    captureHeader.flags = CAPTURE_FLAG_HOST_US;
+    if (!writeCaptureFrame(captureFile, &captureHeader, sizeof(captureHeader))) {
+        printf("ERROR: Failed to write capture file header!\n");
+    }
+
+    bool trainerStarted = false;
+
     // Main application loop
     CaptureFrame frame;
     char str[1024];
@@ -1009,116 +1162,33 @@ int main(int argc, char* argv[])
         if(g_Recording){
             if(OverlayManager::s_routineState == FLAG_ROUTINE_COMPLETE){
                 g_Recording = false;
+                if (!markCaptureComplete(captureFile, captureHeader)) {
+                    printf("ERROR: Failed to mark the capture file complete!\n");
+                }
                 closeCaptureFile(captureFile);
 
-                printf("Starting trainer with capture file: %s\n", filename);
-
-                g_Trainer.start(filename, g_outputModelPath,
-                    [](const std::string& output){
-                        printf("trainer output: %s", output.c_str());
-                    },
-                    [](const TrainerProgress& progress){
-                        printf("DEBUG: Trainer progress callback invoked - isTraining=%d, isComplete=%d, hasError=%d\n", 
-                               progress.isTraining, progress.isComplete, progress.hasError);
-                        // Set global training progress (to be used by main thread)
-                        std::string progressDisplay = "   ~~ Neural Network Training ~~ \n\n";
-                        
-                        if (progress.isComplete) {
-                            progressDisplay += "Training Complete!\n";
-                            progressDisplay += "Final Loss: " + std::to_string(progress.epochAverageLoss);
-                        } else if (progress.hasError) {
-                            progressDisplay += "Training Error:\n" + progress.lastError;
-                        } else if (progress.isTraining) {
-                            // Epoch progress
-                            if (progress.totalEpochs > 0) {
-                                float epochProgress = static_cast<float>(progress.currentEpoch) / progress.totalEpochs;
-                                progressDisplay += "Epoch: " + std::to_string(progress.currentEpoch) + "/" + std::to_string(progress.totalEpochs) + "\n";
-                                
-                                // ASCII progress bar
-                                int barWidth = 20;
-                                int pos = static_cast<int>(barWidth * epochProgress);
-                                std::string bar = "[";
-                                for (int i = 0; i < barWidth; ++i) {
-                                    if (i < pos) bar += "|";
-                                    //else if (i == pos) bar += "▌";
-                                    else bar += ".";
-                                }
-                                bar += "] " + std::to_string(static_cast<int>(epochProgress * 100)) + "%\n\n";
-                                progressDisplay += bar;
-                            }
-                            
-                            // Batch progress
-                            if (progress.totalBatches > 0) {
-                                float batchProgress = static_cast<float>(progress.currentBatch) / progress.totalBatches;
-                                progressDisplay += "Batch: " + std::to_string(progress.currentBatch) + "/" + std::to_string(progress.totalBatches) + "\n";
-                                
-                                int barWidth = 20;
-                                int pos = static_cast<int>(barWidth * batchProgress);
-                                std::string bar = "[";
-                                for (int i = 0; i < barWidth; ++i) {
-                                    if (i < pos) bar += "|";
-                                    //else if (i == pos) bar += "▌";
-                                    else bar += ".";
-                                }
-                                bar += "] " + std::to_string(static_cast<int>(batchProgress * 100)) + "%\n\n";
-                                progressDisplay += bar;
-                            }
-                            
-                            // Current loss
-                            if (progress.currentLoss > 0) {
-                                progressDisplay += "Current Loss: " + std::to_string(progress.currentLoss) + "\n";
-                            }
-                            if (progress.epochAverageLoss > 0) {
-                                progressDisplay += "Epoch Avg: " + std::to_string(progress.epochAverageLoss) + "\n";
-                            }
-                            
-                            // ETA calculation
-                            auto now = std::chrono::steady_clock::now();
-                            auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - progress.startTime).count();
-                            if (progress.totalEpochs > 0 && progress.currentEpoch > 0 && elapsed > 0) {
-                                float epochsPerSecond = static_cast<float>(progress.currentEpoch) / elapsed;
-                                int remainingEpochs = progress.totalEpochs - progress.currentEpoch;
-                                float etaSeconds = remainingEpochs / epochsPerSecond;
-                                
-                                int eta_hours = static_cast<int>(etaSeconds) / 3600;
-                                int eta_minutes = (static_cast<int>(etaSeconds) % 3600) / 60;
-                                int eta_secs = static_cast<int>(etaSeconds) % 60;
-                                
-                                progressDisplay += "ETA: ";
-                                if (eta_hours > 0) progressDisplay += std::to_string(eta_hours) + "h ";
-                                if (eta_minutes > 0 || eta_hours > 0) progressDisplay += std::to_string(eta_minutes) + "m ";
-                                progressDisplay += std::to_string(eta_secs) + "s\n";
-                            }
-                            
-                            // Add graph label if we have data
-                            if (progress.lossHistory.size() > 1) {
-                                progressDisplay += "\nLoss Trend Graph:\n";
-                            }
-                        } else {
-                            progressDisplay += "Training is getting started, please wait...";
-                        }
-                        
-                        // Set global variables for main thread to use
-                        g_trainingProgressDisplay = progressDisplay;
-                        g_trainingLossHistory = progress.lossHistory;
-                        g_hasTrainingUpdate = true;
-                        printf("DEBUG: Set g_hasTrainingUpdate=true, progressDisplay length=%zu, lossHistory size=%zu\n", 
-                               progressDisplay.length(), progress.lossHistory.size());
-                    },
-                    [](){
-                        printf("trainer finished!");
-                        g_isTrained = true;
-                    }
-                );
+                ClockSyncStats syncLeft = frameBufferLeft.getClockSyncStats();
+                ClockSyncStats syncRight = frameBufferRight.getClockSyncStats();
+                printf("Clock sync left: %s, drift %.1f ppm, jitter %.0f us over %.1f s (%u resets)\n",
+                       syncLeft.valid ? "valid" : "not fitted", syncLeft.driftPpm, syncLeft.jitterUs,
+                       syncLeft.spanSeconds, syncLeft.resets);
+                printf("Clock sync right: %s, drift %.1f ppm, jitter %.0f us over %.1f s (%u resets)\n",
+                       syncRight.valid ? "valid" : "not fitted", syncRight.driftPpm, syncRight.jitterUs,
+                       syncRight.spanSeconds, syncRight.resets);
+
+                if (!trainerStarted) {
+                    startTrainer(filename, false);
+                }
             }else{
                 if(true){//if(OverlayManager::s_routineState == FLAG_RESTING && !RoutineController::m_stepWritten){
                     //OverlayManager::s_routineState = FLAG_IN_MOVEMENT;
                     //RoutineController::m_stepWritten = true;
                     int width, height;
                     uint64_t time_left, time_right;
+                    uint64_t host_time_left, host_time_right;
                     size_t size_left, size_right;
-                    unsigned char* imageLeft = frameBufferLeft.getFrameCopy(&width, &height, &time_left, &size_left);
-                    unsigned char* imageRight = frameBufferRight.getFrameCopy(&width, &height, &time_right, &size_right);
+                    unsigned char* imageLeft = frameBufferLeft.getFrameCopy(&width, &height, &time_left, &size_left, &host_time_left);
+                    unsigned char* imageRight = frameBufferRight.getFrameCopy(&width, &height, &time_right, &size_right, &host_time_right);
 
                     /*FILE* fp = fopen("./good_data4.bin", "wb");
                     printf("Writing good data...\n");
@@ -1127,7 +1197,7 @@ int main(int argc, char* argv[])
                         fclose(fp);
                         printf("Dumped bad JPEG data to bad_data4.bin (%u bytes)\n", size_left);
                     }*/
-                    uint64_t now = current_time_ms();
+                    uint64_t now = host_monotonic_us();
 
                     //memcpy(frame.image_data_left, imageLeft, width*height*sizeof(int));
                     //memcpy(frame.image_data_right, imageRight, width*height*sizeof(int));
@@ -1148,6 +1218,12 @@ int main(int argc, char* argv[])
 
                     if(goodData)
                         frame.routineState |= FLAG_GOOD_DATA;
+
+                    // Routine stage and the target's stage flags, so the trainer can balance stages
+                    if (RoutineController::m_routineStage >= 0 && RoutineController::m_routineStage <= COMPLETION_STAGE)
+                        frame.routineState |= FLAG_ROUTINE_STAGE(RoutineController::m_routineStage);
+                    frame.routineState |= OverlayManager::s_routineState &
+                        (FLAG_CONVERGENCE | FLAG_DILATION_BLACK | FLAG_DILATION_WHITE | FLAG_DILATION_GRADIENT);
                     //frame.routineState = OverlayManager::s_routineState;//(uint32_t)OverlayManager::s_routineState;
                     // printf("Time_left: %lld, time_right: %lld, now: %lld\n", time_left, time_right, now); // Commented out to reduce spam
                     // printf("Routine position: %f %f, time diffL: %lld, time diffR: %lld ", frame.routinePitch, frame.routineYaw, now - time_left, now - time_right); // Commented out to reduce spam
@@ -1162,8 +1238,8 @@ int main(int argc, char* argv[])
                     //frame.videoTimestampHigh = (uint32_t)((time >> 32) & 0xFFFFFFFF);
 
                     frame.timestamp = now;
-                    frame.timestamp_left = time_left;
-                    frame.timestamp_right = time_right;
+                    frame.timestamp_left = host_time_left;
+                    frame.timestamp_right = host_time_right;
 
                     // printf("frame size: %lld", sizeof(frame)); // Commented out to reduce spam
 
@@ -1181,6 +1257,11 @@ int main(int argc, char* argv[])
                     
                     free(imageLeft); 
                     free(imageRight);
+
+                    if (g_onlineTraining && !trainerStarted) {
+                        trainerStarted = true;
+                        startTrainer(filename, true);
+                    }
                 }
             }
         }
@@ -0,0 +1,180 @@
+#include "memory_tracker.h"
+
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#undef max
+#undef min
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#include <sys/resource.h>
+#endif
+
+#include <algorithm>
+
+static double toMB(size_t bytes) {
+    return bytes / (1024.0 * 1024.0);
+}
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+// Value of a "Name:   1234 kB" line of /proc/self/status in bytes
+static size_t procStatusBytes(const char* field) {
+    FILE* file = fopen("/proc/self/status", "r");
+    if (file == NULL) {
+        return 0;
+    }
+    const size_t fieldLength = strlen(field);
+    char line[256];
+    size_t bytes = 0;
+    while (fgets(line, sizeof(line), file) != NULL) {
+        if (strncmp(line, field, fieldLength) == 0 && line[fieldLength] == ':') {
+            unsigned long long kb = 0;
+            if (sscanf(line + fieldLength + 1, "%llu", &kb) == 1) {
+                bytes = (size_t)kb * 1024;
+            }
+            break;
+        }
+    }
+    fclose(file);
+    return bytes;
+}
+#endif
+
+size_t GetResidentBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.WorkingSetSize;
+    }
+    return 0;
+#elif defined(__APPLE__)
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) == KERN_SUCCESS) {
+        return (size_t)info.resident_size;
+    }
+    return 0;
+#else
+    return procStatusBytes("VmRSS");
+#endif
+}
+
+size_t GetPeakResidentBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.PeakWorkingSetSize;
+    }
+    return 0;
+#elif defined(__APPLE__)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        return (size_t)usage.ru_maxrss;  // bytes on macOS
+    }
+    return 0;
+#else
+    return procStatusBytes("VmHWM");
+#endif
+}
+
+const char* MemoryCategoryName(MemoryCategory category) {
+    switch (category) {
+        case MemoryCategory::Capture: return "capture";
+        case MemoryCategory::FrameCache: return "frame cache";
+        case MemoryCategory::Windows: return "windows";
+        case MemoryCategory::Batches: return "batches";
+        case MemoryCategory::OrtState: return "ORT state";
+        default: return "unknown";
+    }
+}
+
+size_t MemoryTracker::GetTrackedBytes() const {
+    size_t total = 0;
+    for (int c = 0; c < MEMORY_CATEGORY_COUNT; c++) {
+        total += m_bytes[c];
+    }
+    return total;
+}
+
+bool MemoryTracker::Fits(size_t bytes) const {
+    return m_budget == 0 || GetResidentBytes() + bytes <= m_budget;
+}
+
+bool MemoryTracker::Reserve(const char* what, size_t bytes) {
+    if (m_budget == 0) {
+        return true;
+    }
+    const size_t resident = GetResidentBytes();
+    if (resident + bytes <= m_budget) {
+        return true;
+    }
+    fprintf(stderr, "Memory budget exceeded: %s needs %.1f MB on top of %.1f MB resident, budget %.1f MB\n",
+            what, toMB(bytes), toMB(resident), toMB(m_budget));
+    printBreakdown(resident);
+    return false;
+}
+
+bool MemoryTracker::Snapshot(const std::string& phase) {
+    PhaseRecord record;
+    record.phase = phase;
+    record.resident = GetResidentBytes();
+    record.peak = GetPeakResidentBytes();
+    std::copy(m_bytes, m_bytes + MEMORY_CATEGORY_COUNT, record.bytes);
+    m_records.push_back(record);
+    return Check(phase);
+}
+
+bool MemoryTracker::Check(const std::string& phase) {
+    if (m_budget == 0) {
+        return true;
+    }
+    const size_t resident = GetResidentBytes();
+    if (resident <= m_budget) {
+        return true;
+    }
+    fprintf(stderr, "Memory budget exceeded after %s: %.1f MB resident, budget %.1f MB\n",
+            phase.c_str(), toMB(resident), toMB(m_budget));
+    printBreakdown(resident);
+    return false;
+}
+
+void MemoryTracker::printBreakdown(size_t resident) const {
+    const size_t tracked = GetTrackedBytes();
+    for (int c = 0; c < MEMORY_CATEGORY_COUNT; c++) {
+        fprintf(stderr, "  %-18s %10.1f MB\n", MemoryCategoryName((MemoryCategory)c), toMB(m_bytes[c]));
+    }
+    fprintf(stderr, "  %-18s %10.1f MB\n", "untracked", toMB(resident > tracked ? resident - tracked : 0));
+    fprintf(stderr, "  %-18s %10.1f MB\n", "peak resident", toMB(GetPeakResidentBytes()));
+}
+
+void MemoryTracker::PrintReport() const {
+    if (m_records.empty()) {
+        return;
+    }
+
+    printf("===== Memory by phase (MB) =====\n");
+    printf("%-20s %11s %11s", "Phase", "Resident", "Peak");
+    for (int c = 0; c < MEMORY_CATEGORY_COUNT; c++) {
+        printf(" %11s", MemoryCategoryName((MemoryCategory)c));
+    }
+    printf(" %11s\n", "untracked");
+
+    for (const PhaseRecord& record : m_records) {
+        size_t tracked = 0;
+        printf("%-20s %11.1f %11.1f", record.phase.c_str(), toMB(record.resident), toMB(record.peak));
+        for (int c = 0; c < MEMORY_CATEGORY_COUNT; c++) {
+            printf(" %11.1f", toMB(record.bytes[c]));
+            tracked += record.bytes[c];
+        }
+        printf(" %11.1f\n", toMB(record.resident > tracked ? record.resident - tracked : 0));
+    }
+    printf("Peak resident: %.1f MB", toMB(GetPeakResidentBytes()));
+    if (m_budget > 0) {
+        printf(" of a %.1f MB budget", toMB(m_budget));
+    }
+    printf("\nORT state is estimated from the parameter count; untracked is mostly ORT's arenas.\n");
+    printf("================================\n");
+}
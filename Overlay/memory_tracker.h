@@ -0,0 +1,80 @@
+// memory_tracker.h
+#ifndef MEMORY_TRACKER_H
+#define MEMORY_TRACKER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Current resident set of the process in bytes; 0 where unavailable
+size_t GetResidentBytes();
+// Largest resident set the process has had so far; 0 where unavailable
+size_t GetPeakResidentBytes();
+
+// What the trainer's tracked allocations hold
+enum class MemoryCategory {
+    Capture,      // aligned frames: JPEG payloads and per-frame decode buffers
+    FrameCache,   // decoded planes and labels at training resolution
+    Windows,      // temporal windows, signatures and sample orders
+    Batches,      // batch loader pools
+    OrtState,     // parameters, gradients and optimizer state (estimated from the parameter count)
+    Count
+};
+
+static const int MEMORY_CATEGORY_COUNT = (int)MemoryCategory::Count;
+
+const char* MemoryCategoryName(MemoryCategory category);
+
+/**
+ * @brief Memory use of the trainer by category and phase, with an optional budget
+ *
+ * The trainer sets the byte count of each category from the sizes of its containers
+ * whenever they change, and takes a snapshot of the resident set after every phase.
+ * Whatever the resident set holds beyond the tracked bytes is mostly ORT's arenas
+ * (activations and workspace) and transient buffers, and is reported as untracked.
+ *
+ * With a budget, Reserve refuses an allocation that is known in advance and would not
+ * fit, and Snapshot or Check fail once the resident set exceeds it, each printing the
+ * breakdown so the run stops with an explanation instead of pushing the machine into
+ * swap.
+ */
+class MemoryTracker {
+public:
+    // budgetBytes 0 means no budget
+    explicit MemoryTracker(size_t budgetBytes = 0) : m_budget(budgetBytes) {}
+
+    void Set(MemoryCategory category, size_t bytes) { m_bytes[(int)category] = bytes; }
+    size_t Get(MemoryCategory category) const { return m_bytes[(int)category]; }
+    size_t GetTrackedBytes() const;
+    size_t GetBudget() const { return m_budget; }
+
+    // Whether bytes more still fit the budget on top of the current resident set
+    bool Fits(size_t bytes) const;
+    // Same check for an allocation the trainer cannot do without; prints the breakdown
+    // when it does not fit
+    bool Reserve(const char* what, size_t bytes);
+
+    // Records the resident set after a phase; false if it is over the budget
+    bool Snapshot(const std::string& phase);
+    // Same check without a record, cheap enough for every few batches
+    bool Check(const std::string& phase);
+
+    // Every snapshot by phase, then the peak
+    void PrintReport() const;
+
+private:
+    struct PhaseRecord {
+        std::string phase;
+        size_t resident = 0;
+        size_t peak = 0;
+        size_t bytes[MEMORY_CATEGORY_COUNT] = {};
+    };
+
+    void printBreakdown(size_t resident) const;
+
+    size_t m_budget;
+    size_t m_bytes[MEMORY_CATEGORY_COUNT] = {};
+    std::vector<PhaseRecord> m_records;
+};
+
+#endif // MEMORY_TRACKER_H
@@ -174,6 +174,10 @@ def export_model_with_training_artifacts():
         nominal_checkpoint=True
     )
     
+    # Names of the trainable tensors, read by the trainer's parameter telemetry
+    with open(os.path.join(artifacts_output_dir, "trainable_params.txt"), "w") as f:
+        f.write("\n".join(requires_grad_params) + "\n")
+    
     print(f"Training artifacts generated in {artifacts_output_dir}")
     print(f"Number of trainable parameters: {trainable_param_count:,}")
     print(f"Number of trainable parameter tensors: {len(requires_grad_params)}")
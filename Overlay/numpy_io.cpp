@@ -6,9 +6,221 @@
 #include <stdexcept>
 #include <unordered_map>
 #include <typeindex>
+#include <algorithm>
+#include <limits>
+#include <cstdio>
+#include <cstdlib>
 
 #include "numpy_io.h"
 
+#ifdef _WIN32
+#include <windows.h>
+#undef max
+#undef min
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static char nativeEndianChar() {
+    uint16_t endianCheck = 1;
+    return *reinterpret_cast<char*>(&endianCheck) ? '<' : '>';
+}
+
+// Single byte types carry no byte order ('|'), wider types the native one
+static std::string descrFor(const TypeInfo& typeInfo) {
+    return std::string(1, typeInfo.size == 1 ? '|' : nativeEndianChar()) + typeInfo.numpyDescr;
+}
+
+/**
+ * Resolves a dtype descriptor such as "<f4" or "|u1"
+ *
+ * @param descr Descriptor from the header
+ * @param dataType Receives the matching type
+ * @param swapBytes Receives whether the data is in the opposite byte order to the host
+ * @return false for descriptors outside TYPE_INFO
+ */
+static bool lookupDescr(const std::string& descr, NumPyDataType& dataType, bool& swapBytes) {
+    if (descr.length() < 2) {
+        return false;
+    }
+    char order = descr[0];
+    if (order != '<' && order != '>' && order != '|' && order != '=') {
+        return false;
+    }
+
+    for (const auto& entry : TYPE_INFO) {
+        if (descr.compare(1, std::string::npos, entry.second.numpyDescr) == 0) {
+            dataType = entry.first;
+            swapBytes = entry.second.size > 1 && (order == '<' || order == '>') && order != nativeEndianChar();
+            return true;
+        }
+    }
+    return false;
+}
+
+static void swapBytesInPlace(void* data, size_t elements, size_t elementSize) {
+    uint8_t* bytes = static_cast<uint8_t*>(data);
+    for (size_t i = 0; i < elements; i++, bytes += elementSize) {
+        std::reverse(bytes, bytes + elementSize);
+    }
+}
+
+static std::string shapeToString(const std::vector<size_t>& shape) {
+    std::string shapeStr = "(";
+    for (size_t i = 0; i < shape.size(); ++i) {
+        shapeStr += std::to_string(shape[i]);
+        if (i < shape.size() - 1) {
+            shapeStr += ", ";
+        }
+    }
+    // For single-dimension arrays, add trailing comma to make it a tuple
+    if (shape.size() == 1) {
+        shapeStr += ",";
+    }
+    shapeStr += ")";
+    return shapeStr;
+}
+
+static std::string buildHeaderDict(const TypeInfo& typeInfo, const std::vector<size_t>& shape) {
+    std::string header = "{'descr': '";
+    header += descrFor(typeInfo);
+    header += "', 'fortran_order': False, 'shape': ";
+    header += shapeToString(shape);
+    header += ", }";
+    return header;
+}
+
+// Magic string, version and little endian header length (2 bytes for 1.0, 4 bytes for 2.0/3.0)
+static void writePreamble(std::ostream& file, uint8_t majorVersion, size_t headerLen) {
+    const char magic[] = "\x93NUMPY";
+    file.write(magic, 6);
+
+    const uint8_t version[2] = { majorVersion, 0 };
+    file.write(reinterpret_cast<const char*>(version), 2);
+
+    uint8_t length[4] = { (uint8_t)headerLen, (uint8_t)(headerLen >> 8), (uint8_t)(headerLen >> 16), (uint8_t)(headerLen >> 24) };
+    file.write(reinterpret_cast<const char*>(length), majorVersion == 1 ? 2 : 4);
+}
+
+// Reads the preamble; returns the offset of the header text, or 0 if the file is not a .npy
+static size_t readPreamble(std::istream& file, uint8_t& majorVersion, size_t& headerLen) {
+    uint8_t preamble[12];
+    if (!file.read(reinterpret_cast<char*>(preamble), 10) || memcmp(preamble, "\x93NUMPY", 6) != 0) {
+        return 0;
+    }
+
+    majorVersion = preamble[6];
+    if (majorVersion == 1) {
+        headerLen = preamble[8] | (preamble[9] << 8);
+        return 10;
+    }
+    if ((majorVersion == 2 || majorVersion == 3) && file.read(reinterpret_cast<char*>(preamble + 10), 2)) {
+        headerLen = (size_t)preamble[8] | ((size_t)preamble[9] << 8) | ((size_t)preamble[10] << 16) | ((size_t)preamble[11] << 24);
+        return 12;
+    }
+    return 0;
+}
+
+// Large arrays are written and read in chunks; some C runtimes fail single transfers over 2-4 GB
+static const size_t STREAM_CHUNK_BYTES = 64 * 1024 * 1024;
+
+static bool writeChunked(std::ostream& file, const void* data, size_t bytes) {
+    const char* p = static_cast<const char*>(data);
+    while (bytes > 0 && file.good()) {
+        size_t n = std::min(bytes, STREAM_CHUNK_BYTES);
+        file.write(p, (std::streamsize)n);
+        p += n;
+        bytes -= n;
+    }
+    return file.good();
+}
+
+static bool readChunked(std::istream& file, void* data, size_t bytes) {
+    char* p = static_cast<char*>(data);
+    while (bytes > 0) {
+        size_t n = std::min(bytes, STREAM_CHUNK_BYTES);
+        if (!file.read(p, (std::streamsize)n)) {
+            return false;
+        }
+        p += n;
+        bytes -= n;
+    }
+    return true;
+}
+
+float NumPyHalfToFloat(NumPyHalf value) {
+    uint32_t sign = (uint32_t)(value.bits & 0x8000) << 16;
+    uint32_t exponent = (value.bits >> 10) & 0x1F;
+    uint32_t mantissa = value.bits & 0x3FF;
+    uint32_t bits;
+
+    if (exponent == 0) {
+        if (mantissa == 0) {
+            bits = sign;
+        } else {
+            // Subnormal: normalise into a float exponent
+            exponent = 127 - 15 + 1;
+            while ((mantissa & 0x400) == 0) {
+                mantissa <<= 1;
+                exponent--;
+            }
+            bits = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+        }
+    } else if (exponent == 0x1F) {
+        bits = sign | 0x7F800000 | (mantissa << 13);
+    } else {
+        bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    }
+
+    float result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+NumPyHalf NumPyFloatToHalf(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+    int32_t exponent = (int32_t)((bits >> 23) & 0xFF) - 127 + 15;
+    uint32_t mantissa = bits & 0x7FFFFF;
+    NumPyHalf half;
+
+    if (((bits >> 23) & 0xFF) == 0xFF) {
+        // Inf or NaN (keep NaN quiet and non-zero)
+        half.bits = sign | 0x7C00 | (mantissa ? 0x200 : 0);
+    } else if (exponent >= 0x1F) {
+        half.bits = sign | 0x7C00;
+    } else if (exponent <= 0) {
+        if (exponent < -10) {
+            half.bits = sign;
+        } else {
+            // Subnormal, round to nearest even
+            mantissa |= 0x800000;
+            uint32_t shift = (uint32_t)(14 - exponent);
+            uint32_t halfMantissa = mantissa >> shift;
+            uint32_t remainder = mantissa & ((1u << shift) - 1);
+            uint32_t halfway = 1u << (shift - 1);
+            if (remainder > halfway || (remainder == halfway && (halfMantissa & 1))) {
+                halfMantissa++;
+            }
+            half.bits = sign | (uint16_t)halfMantissa;
+        }
+    } else {
+        // Normal, round to nearest even; a carry into the exponent is correct behaviour
+        uint32_t halfBits = ((uint32_t)exponent << 10) | (mantissa >> 13);
+        uint32_t remainder = mantissa & 0x1FFF;
+        if (remainder > 0x1000 || (remainder == 0x1000 && (halfBits & 1))) {
+            halfBits++;
+        }
+        half.bits = sign | (uint16_t)halfBits;
+    }
+    return half;
+}
+
 /**
  * Saves an array to a NumPy .npy file
  * 
@@ -38,62 +250,29 @@ bool NumPyIO::SaveArrayToNumpy(const std::string& filename, const void* data,
         totalElements *= dim;
     }
 
-    // Build shape string for header
-    std::string shapeStr = "(";
-    for (size_t i = 0; i < shape.size(); ++i) {
-        shapeStr += std::to_string(shape[i]);
-        if (i < shape.size() - 1) {
-            shapeStr += ", ";
-        }
-    }
-    // For single-dimension arrays, add trailing comma to make it a tuple
-    if (shape.size() == 1) {
-        shapeStr += ",";
-    }
-    shapeStr += ")";
-
-    // Check endianness
-    uint16_t endianCheck = 1;
-    char endianness = *reinterpret_cast<char*>(&endianCheck) ? '<' : '>';
-
     // Create header
-    std::string header = "{'descr': '";
-    header += endianness;
-    header += typeInfo.numpyDescr;
-    header += "', 'fortran_order': False, 'shape': ";
-    header += shapeStr;
-    header += "}";
+    std::string header = buildHeaderDict(typeInfo, shape);
 
-    // Pad header to make total length divisible by 64 for alignment
-    size_t headerLen = header.length() + 1; // +1 for newline
-    size_t padLen = 64 - ((headerLen + 10) % 64); // +10 for magic string, version, header length
-    if (padLen < 64) {
-        headerLen += padLen;
+    // Version 1.0 stores the header length in 16 bits; fall back to 2.0 beyond that
+    uint8_t majorVersion = 1;
+    size_t preambleLen = 10;
+    if (header.length() + 1 + 64 > 0xFFFF) {
+        majorVersion = 2;
+        preambleLen = 12;
     }
+
+    // Pad header to make total length divisible by 64 for alignment
+    size_t padLen = (64 - ((preambleLen + header.length() + 1) % 64)) % 64;
     header.append(padLen, ' ');
     header += '\n';
 
-    // Magic string for .npy format
-    const char magic[] = "\x93NUMPY";
-    file.write(magic, 6);
-
-    // Version 1.0
-    const uint8_t majorVersion = 1;
-    const uint8_t minorVersion = 0;
-    file.write(reinterpret_cast<const char*>(&majorVersion), 1);
-    file.write(reinterpret_cast<const char*>(&minorVersion), 1);
-
-    // Header length (little endian)
-    uint16_t headerLenLE = static_cast<uint16_t>(header.length());
-    file.write(reinterpret_cast<char*>(&headerLenLE), 2);
+    writePreamble(file, majorVersion, header.length());
 
     // Header
     file.write(header.c_str(), header.length());
 
     // Data
-    file.write(reinterpret_cast<const char*>(data), totalElements * typeInfo.size);
-
-    return file.good();
+    return writeChunked(file, data, totalElements * typeInfo.size);
 }
 
 /**
@@ -121,54 +300,27 @@ void* NumPyIO::ReadNumpyToArray(const std::string& filename, void* data,
         throw std::runtime_error("Failed to open file: " + filename);
     }
 
-    // Check magic string
-    char magic[6];
-    file.read(magic, 6);
-    if (memcmp(magic, "\x93NUMPY", 6) != 0) {
-        throw std::runtime_error("Invalid NumPy file format (incorrect magic string)");
+    // Check magic string and read version and header length
+    uint8_t majorVersion = 0;
+    size_t headerLen = 0;
+    if (readPreamble(file, majorVersion, headerLen) == 0) {
+        throw std::runtime_error("Invalid NumPy file format (incorrect magic string or unsupported version)");
     }
-
-    // Read version
-    uint8_t majorVersion, minorVersion;
-    file.read(reinterpret_cast<char*>(&majorVersion), 1);
-    file.read(reinterpret_cast<char*>(&minorVersion), 1);
-    
-    // Read header length
-    uint16_t headerLen;
-    file.read(reinterpret_cast<char*>(&headerLen), 2);
     
     // Read header
-    std::vector<char> headerBuf(headerLen + 1, 0); // +1 for null terminator
-    file.read(headerBuf.data(), headerLen);
-    std::string header(headerBuf.data());
-    
-    // Parse shape from header
-    shape.clear();
-    size_t shapeStart = header.find("'shape': (") + 10;
-    size_t shapeEnd = header.find(")", shapeStart);
-    std::string shapeStr = header.substr(shapeStart, shapeEnd - shapeStart);
-    
-    // Parse shape dimensions
-    size_t pos = 0;
-    while (pos < shapeStr.length()) {
-        size_t commaPos = shapeStr.find(',', pos);
-        if (commaPos == std::string::npos) {
-            // Handle last number or single dimension
-            std::string numStr = shapeStr.substr(pos);
-            if (!numStr.empty() && numStr.find_first_not_of(" \t") != std::string::npos) {
-                shape.push_back(std::stoull(numStr));
-            }
-            break;
-        }
-        
-        std::string numStr = shapeStr.substr(pos, commaPos - pos);
-        shape.push_back(std::stoull(numStr));
-        pos = commaPos + 1;
+    std::string header(headerLen, '\0');
+    if (!file.read(&header[0], headerLen)) {
+        throw std::runtime_error("Truncated NumPy header");
     }
     
-    // Verify we have a valid shape
-    if (shape.empty()) {
-        throw std::runtime_error("Failed to parse array shape from NumPy header");
+    // Parse descr, order and shape from header
+    std::string descr;
+    bool fortranOrder = false;
+    if (!parseHeader(header, descr, fortranOrder, shape)) {
+        throw std::runtime_error("Failed to parse NumPy header");
+    }
+    if (fortranOrder) {
+        throw std::runtime_error("Fortran-ordered NumPy arrays are not supported");
     }
     
     // Calculate total elements
@@ -178,11 +330,9 @@ void* NumPyIO::ReadNumpyToArray(const std::string& filename, void* data,
     }
     
     // Check data type from header
-    std::string expectedType1 = "'descr': '<" + typeInfo.numpyDescr + "'";
-    std::string expectedType2 = "'descr': '>" + typeInfo.numpyDescr + "'";
-    
-    if (header.find(expectedType1) == std::string::npos && 
-        header.find(expectedType2) == std::string::npos) {
+    NumPyDataType fileType;
+    bool swapBytes = false;
+    if (!lookupDescr(descr, fileType, swapBytes) || fileType != dataType) {
         throw std::runtime_error("File contains incompatible data type for the requested read");
     }
     
@@ -193,33 +343,25 @@ void* NumPyIO::ReadNumpyToArray(const std::string& filename, void* data,
     }
     
     // Read the actual data
-    file.read(reinterpret_cast<char*>(resultData), totalElements * typeInfo.size);
-    
-    // Check endianness
-    bool fileIsLittleEndian = (header.find("'descr': '<") != std::string::npos);
-    
-    // Check if we need to swap endianness
-    uint16_t endianCheck = 1;
-    bool systemIsLittleEndian = (*reinterpret_cast<char*>(&endianCheck) == 1);
+    if (!readChunked(file, resultData, totalElements * typeInfo.size)) {
+        if (data == nullptr) {
+            operator delete(resultData);
+        }
+        throw std::runtime_error("NumPy data is shorter than its shape in " + filename);
+    }
     
     // Swap endianness if needed
-    if (fileIsLittleEndian != systemIsLittleEndian) {
-        // For 4-byte types (float32, int32)
-        if (typeInfo.size == 4) {
-            uint32_t* values = reinterpret_cast<uint32_t*>(resultData);
-            for (size_t i = 0; i < totalElements; i++) {
-                values[i] = ((values[i] & 0xFF) << 24) | 
-                           ((values[i] & 0xFF00) << 8) | 
-                           ((values[i] & 0xFF0000) >> 8) | 
-                           ((values[i] & 0xFF000000) >> 24);
-            }
-        }
-        // Add more cases for different sizes if needed
+    if (swapBytes) {
+        swapBytesInPlace(resultData, totalElements, typeInfo.size);
     }
     
     return resultData;
 }
 
+// Header length field used by NumPyAppender: 10 byte preamble + 246 = 256 bytes, which keeps
+// the data 64-byte aligned and leaves room for a 20 digit row count on any practical shape
+static const size_t APPENDER_HEADER_LENGTH = 246;
+
 /**
  * Appends data to a NumPy .npy file or creates a new file if it doesn't exist
  *
@@ -232,125 +374,1092 @@ void* NumPyIO::ReadNumpyToArray(const std::string& filename, void* data,
 bool NumPyIO::AppendToNumpyArray(const std::string &filename, const void *data,
                                  size_t elements, NumPyDataType dataType)
 {
-    const size_t FIXED_HEADER_SIZE = 256; // Fixed size for header with padding
+    NumPyAppender appender;
+    if (!appender.Open(filename, dataType, {}, true, 0))
+    {
+        return false;
+    }
+
+    bool ok = appender.Append(data, elements);
+    return appender.Close() && ok;
+}
+
+/**
+ * Helper function to write a NumPy header with specified size
+ */
+void NumPyIO::writeHeader(std::ostream &file, const std::vector<size_t> &shape, NumPyDataType dataType, size_t fixedHeaderSize)
+{
+    auto typeInfoIt = TYPE_INFO.find(dataType);
+    const TypeInfo &typeInfo = typeInfoIt->second;
+
+    std::string header = buildHeaderDict(typeInfo, shape);
+
+    // Pad header to fixed size (leave space for one newline)
+    size_t paddingNeeded = fixedHeaderSize - 1 - header.length();
+    header.append(paddingNeeded, ' ');
+    header += '\n';
+
+    // Version 1.0 with fixed header length
+    writePreamble(file, 1, fixedHeaderSize);
+
+    // Header
+    file.write(header.c_str(), header.length());
+}
+
+/**
+ * Parses the Python dict literal of a .npy header
+ *
+ * @param header Header text following the preamble
+ * @param descr Receives the dtype descriptor, e.g. "<f4"
+ * @param fortranOrder Receives the fortran_order flag
+ * @param shape Receives the array dimensions (empty for a scalar)
+ * @return true if all three keys were found and well formed
+ */
+bool NumPyIO::parseHeader(const std::string &header, std::string &descr, bool &fortranOrder, std::vector<size_t> &shape)
+{
+    bool hasDescr = false, hasOrder = false, hasShape = false;
+    size_t pos = header.find('{');
+    if (pos == std::string::npos)
+    {
+        return false;
+    }
+    pos++;
+
+    auto skipSpace = [&header, &pos]() {
+        while (pos < header.length() && (header[pos] == ' ' || header[pos] == '\t' || header[pos] == '\n' || header[pos] == ','))
+        {
+            pos++;
+        }
+    };
+    auto readQuoted = [&header, &pos](std::string &out) {
+        if (pos >= header.length() || (header[pos] != '\'' && header[pos] != '"'))
+        {
+            return false;
+        }
+        char quote = header[pos++];
+        size_t end = header.find(quote, pos);
+        if (end == std::string::npos)
+        {
+            return false;
+        }
+        out = header.substr(pos, end - pos);
+        pos = end + 1;
+        return true;
+    };
+
+    while (true)
+    {
+        skipSpace();
+        if (pos >= header.length())
+        {
+            return false;
+        }
+        if (header[pos] == '}')
+        {
+            break;
+        }
+
+        std::string key;
+        if (!readQuoted(key))
+        {
+            return false;
+        }
+        skipSpace();
+        if (pos >= header.length() || header[pos] != ':')
+        {
+            return false;
+        }
+        pos++;
+        skipSpace();
+
+        if (key == "descr")
+        {
+            if (!readQuoted(descr))
+            {
+                return false;
+            }
+            hasDescr = true;
+        }
+        else if (key == "fortran_order")
+        {
+            if (header.compare(pos, 4, "True") == 0)
+            {
+                fortranOrder = true;
+                pos += 4;
+            }
+            else if (header.compare(pos, 5, "False") == 0)
+            {
+                fortranOrder = false;
+                pos += 5;
+            }
+            else
+            {
+                return false;
+            }
+            hasOrder = true;
+        }
+        else if (key == "shape")
+        {
+            if (pos >= header.length() || header[pos] != '(')
+            {
+                return false;
+            }
+            size_t end = header.find(')', pos);
+            if (end == std::string::npos)
+            {
+                return false;
+            }
+            shape.clear();
+            const char *p = header.c_str() + pos + 1;
+            const char *stop = header.c_str() + end;
+            while (p < stop)
+            {
+                if (*p >= '0' && *p <= '9')
+                {
+                    char *next = nullptr;
+                    shape.push_back((size_t)strtoull(p, &next, 10));
+                    p = next;
+                }
+                else if (*p == ' ' || *p == ',' || *p == 'L')
+                {
+                    p++;
+                }
+                else
+                {
+                    return false;
+                }
+            }
+            pos = end + 1;
+            hasShape = true;
+        }
+        else
+        {
+            // Unknown key: skip its value up to the next top-level comma
+            int depth = 0;
+            while (pos < header.length())
+            {
+                char c = header[pos];
+                if (c == '(' || c == '[' || c == '{') depth++;
+                else if (c == ')' || c == ']') depth--;
+                else if (c == '}' && depth-- == 0) break;
+                else if (c == ',' && depth == 0) break;
+                pos++;
+            }
+        }
+    }
+
+    return hasDescr && hasOrder && hasShape;
+}
+
+NumPyAppender::~NumPyAppender()
+{
+    Close();
+}
+
+/**
+ * Opens a .npy file for appending rows
+ *
+ * @param filename Path to the .npy file
+ * @param dataType Element type of the array
+ * @param rowShape Shape of one row (all dimensions after the first)
+ * @param appendExisting Continue an existing compatible file instead of truncating it
+ * @param bufferBytes Size of the in-memory write buffer (0 writes straight through)
+ * @return true if the file is open and ready for Append()
+ */
+bool NumPyAppender::Open(const std::string &filename, NumPyDataType dataType,
+                         const std::vector<size_t> &rowShape, bool appendExisting,
+                         size_t bufferBytes)
+{
+    Close();
 
-    // Get type information
     auto typeInfoIt = TYPE_INFO.find(dataType);
     if (typeInfoIt == TYPE_INFO.end())
     {
         return false;
     }
-    const TypeInfo &typeInfo = typeInfoIt->second;
 
-    // Check if file exists
-    size_t currentSize = 0;
-    std::ifstream checkFile(filename, std::ios::binary);
-    bool fileExists = checkFile.good();
+    m_filename = filename;
+    m_dataType = dataType;
+    m_rowShape = rowShape;
+    m_rowBytes = typeInfoIt->second.size;
+    for (size_t dim : rowShape)
+    {
+        m_rowBytes *= dim;
+    }
+    m_rowCount = 0;
+    m_headerRowCount = 0;
+    m_bufferUsed = 0;
+    m_failed = false;
+    m_buffer.assign(bufferBytes, 0);
+
+    if (m_rowBytes == 0)
+    {
+        return false;
+    }
+
+    if (appendExisting)
+    {
+        std::ifstream probe(filename, std::ios::binary);
+        bool exists = probe.good();
+        probe.close();
 
-    if (fileExists)
+        if (exists)
+        {
+            bool compatible = false;
+            if (openExisting(compatible))
+            {
+                return true;
+            }
+            if (!compatible)
+            {
+                // Refuse to clobber an array of a different type or layout
+                return false;
+            }
+        }
+    }
+
+    return createFile();
+}
+
+bool NumPyAppender::createFile()
+{
+    m_file.open(m_filename, std::ios::binary | std::ios::in | std::ios::out | std::ios::trunc);
+    if (!m_file.is_open())
     {
-        // Skip magic string, version, and header length (10 bytes)
-        checkFile.seekg(10);
+        return false;
+    }
+
+    m_headerLength = APPENDER_HEADER_LENGTH;
+    std::vector<size_t> shape(1, 0);
+    shape.insert(shape.end(), m_rowShape.begin(), m_rowShape.end());
+    NumPyIO::writeHeader(m_file, shape, m_dataType, m_headerLength);
 
-        // Read header length
-        uint16_t headerLen;
-        checkFile.read(reinterpret_cast<char *>(&headerLen), 2);
+    return m_file.good();
+}
 
-        // Skip the header
-        checkFile.seekg(headerLen, std::ios::cur);
+/**
+ * Continues an existing file. Sets compatible to false when the file holds a different
+ * dtype or row shape. Files whose header has no room for a growing row count are
+ * rewritten once with an appender-sized header.
+ */
+bool NumPyAppender::openExisting(bool &compatible)
+{
+    compatible = false;
 
-        // Calculate current size based on file size
-        std::streampos dataStart = checkFile.tellg();
-        checkFile.seekg(0, std::ios::end);
-        std::streampos fileEnd = checkFile.tellg();
+    std::ifstream in(m_filename, std::ios::binary);
+    uint8_t majorVersion = 0;
+    size_t headerLen = 0;
+    size_t preambleLen = readPreamble(in, majorVersion, headerLen);
+    if (preambleLen == 0)
+    {
+        return false;
+    }
 
-        currentSize = (fileEnd - dataStart) / typeInfo.size;
+    std::string header(headerLen, '\0');
+    if (!in.read(&header[0], headerLen))
+    {
+        return false;
     }
-    checkFile.close();
 
-    if (!fileExists)
+    std::string descr;
+    bool fortranOrder = false;
+    std::vector<size_t> shape;
+    if (!NumPyIO::parseHeader(header, descr, fortranOrder, shape))
     {
-        // Create new file
-        std::ofstream file(filename, std::ios::binary);
-        if (!file.is_open())
+        return false;
+    }
+
+    const TypeInfo &typeInfo = TYPE_INFO.find(m_dataType)->second;
+    NumPyDataType fileType;
+    bool swapBytes = false;
+    if (!lookupDescr(descr, fileType, swapBytes) || fileType != m_dataType || swapBytes ||
+        fortranOrder || shape.size() != m_rowShape.size() + 1 ||
+        !std::equal(m_rowShape.begin(), m_rowShape.end(), shape.begin() + 1))
+    {
+        return false;
+    }
+    compatible = true;
+
+    // Rows present on disk; a crashed writer may have left rows beyond the header count
+    const size_t dataStart = preambleLen + headerLen;
+    in.seekg(0, std::ios::end);
+    size_t fileSize = (size_t)in.tellg();
+    size_t rowsOnDisk = (fileSize > dataStart) ? (fileSize - dataStart) / m_rowBytes : 0;
+
+    // Make sure the header can hold the largest row count without moving the data.
+    // Patching always writes a 1.0 preamble, so other versions are rewritten too.
+    std::vector<size_t> largest = shape;
+    largest[0] = std::numeric_limits<size_t>::max();
+    bool hasRoom = majorVersion == 1 && buildHeaderDict(typeInfo, largest).length() + 1 <= headerLen;
+
+    if (!hasRoom)
+    {
+        // One-off rewrite into a file with an appender header
+        std::string tmpName = m_filename + ".tmp";
+        std::ofstream out(tmpName, std::ios::binary | std::ios::trunc);
+        if (!out.is_open())
+        {
+            return false;
+        }
+        shape[0] = rowsOnDisk;
+        NumPyIO::writeHeader(out, shape, m_dataType, APPENDER_HEADER_LENGTH);
+
+        in.clear();
+        in.seekg(dataStart);
+        std::vector<char> chunk(1 << 20);
+        size_t remaining = rowsOnDisk * m_rowBytes;
+        while (remaining > 0)
+        {
+            size_t n = std::min(remaining, chunk.size());
+            if (!in.read(chunk.data(), n) || !out.write(chunk.data(), n))
+            {
+                return false;
+            }
+            remaining -= n;
+        }
+        in.close();
+        out.close();
+        if (!out)
+        {
+            return false;
+        }
+
+        std::remove(m_filename.c_str());
+        if (std::rename(tmpName.c_str(), m_filename.c_str()) != 0)
         {
             return false;
         }
+        headerLen = APPENDER_HEADER_LENGTH;
+    }
+    in.close();
+
+    m_file.open(m_filename, std::ios::binary | std::ios::in | std::ios::out);
+    if (!m_file.is_open())
+    {
+        return false;
+    }
 
-        // Create new header
-        writeHeader(file, elements, dataType, FIXED_HEADER_SIZE);
+    m_headerLength = headerLen;
+    m_rowCount = rowsOnDisk;
+    m_headerRowCount = shape[0] == rowsOnDisk ? rowsOnDisk : (size_t)-1;
+    m_file.seekp(10 + headerLen + rowsOnDisk * m_rowBytes);
+    return m_file.good();
+}
 
-        // Write data
-        file.write(reinterpret_cast<const char *>(data), elements * typeInfo.size);
+/**
+ * Appends rows to the array
+ *
+ * @param rows Pointer to rowCount rows in C order
+ * @param rowCount Number of rows to append
+ * @return true if the rows were buffered or written
+ */
+bool NumPyAppender::Append(const void *rows, size_t rowCount)
+{
+    if (!m_file.is_open() || m_failed)
+    {
+        return false;
+    }
+
+    const size_t bytes = rowCount * m_rowBytes;
+    if (m_bufferUsed + bytes > m_buffer.size())
+    {
+        if (!writeBuffered())
+        {
+            return false;
+        }
+    }
 
-        return file.good();
+    if (bytes > m_buffer.size())
+    {
+        // Large appends go straight to the file
+        if (!writeChunked(m_file, rows, bytes))
+        {
+            m_failed = true;
+            return false;
+        }
     }
     else
     {
-        // Open for append
-        std::fstream file(filename, std::ios::binary | std::ios::in | std::ios::out);
-        if (!file.is_open())
+        memcpy(m_buffer.data() + m_bufferUsed, rows, bytes);
+        m_bufferUsed += bytes;
+    }
+
+    m_rowCount += rowCount;
+    return true;
+}
+
+bool NumPyAppender::writeBuffered()
+{
+    if (m_bufferUsed > 0)
+    {
+        if (!m_file.write(m_buffer.data(), m_bufferUsed))
         {
+            m_failed = true;
             return false;
         }
+        m_bufferUsed = 0;
+    }
+    return true;
+}
+
+bool NumPyAppender::Flush()
+{
+    if (!m_file.is_open() || m_failed)
+    {
+        return false;
+    }
+
+    if (!writeBuffered())
+    {
+        return false;
+    }
+
+    if (m_headerRowCount != m_rowCount)
+    {
+        std::streampos end = m_file.tellp();
+
+        std::vector<size_t> shape(1, m_rowCount);
+        shape.insert(shape.end(), m_rowShape.begin(), m_rowShape.end());
+        m_file.seekp(0);
+        NumPyIO::writeHeader(m_file, shape, m_dataType, m_headerLength);
+        m_file.seekp(end);
+
+        m_headerRowCount = m_rowCount;
+    }
 
-        // Calculate new size
-        size_t newSize = currentSize + elements;
+    m_file.flush();
+    if (!m_file.good())
+    {
+        m_failed = true;
+        return false;
+    }
+    return true;
+}
+
+bool NumPyAppender::Close()
+{
+    if (!m_file.is_open())
+    {
+        return true;
+    }
+
+    bool ok = Flush();
+    m_file.close();
+    m_buffer.clear();
+    m_buffer.shrink_to_fit();
+    return ok;
+}
+
+// ---------------------------------------------------------------------------
+// Memory-mapped reading
+// ---------------------------------------------------------------------------
+
+// Read-only mapping of a whole file, released when the last view goes away
+struct MappedFile {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
+#endif
+
+    ~MappedFile() {
+#ifdef _WIN32
+        if (data) UnmapViewOfFile(data);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+        if (data) munmap(const_cast<uint8_t*>(data), size);
+#endif
+    }
+};
+
+static std::shared_ptr<MappedFile> mapFile(const std::string& filename) {
+    std::shared_ptr<MappedFile> mapped = std::make_shared<MappedFile>();
 
-        // Rewrite the header with the new size
-        file.seekp(0);
-        writeHeader(file, newSize, dataType, FIXED_HEADER_SIZE);
+#ifdef _WIN32
+    mapped->file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                               OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (mapped->file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Failed to open file: " + filename);
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(mapped->file, &fileSize) || fileSize.QuadPart == 0) {
+        throw std::runtime_error("Failed to map empty or unreadable file: " + filename);
+    }
+    mapped->size = (size_t)fileSize.QuadPart;
 
-        // Seek to end and append data
-        file.seekp(0, std::ios::end);
-        file.write(reinterpret_cast<const char *>(data), elements * typeInfo.size);
+    mapped->mapping = CreateFileMappingA(mapped->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapped->mapping) {
+        throw std::runtime_error("Failed to map file: " + filename);
+    }
+    mapped->data = static_cast<const uint8_t*>(MapViewOfFile(mapped->mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open file: " + filename);
+    }
 
-        return file.good();
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        throw std::runtime_error("Failed to map empty or unreadable file: " + filename);
     }
+    mapped->size = (size_t)st.st_size;
+
+    void* address = mmap(nullptr, mapped->size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (address != MAP_FAILED) {
+        mapped->data = static_cast<const uint8_t*>(address);
+    }
+#endif
+
+    if (!mapped->data) {
+        throw std::runtime_error("Failed to map file: " + filename);
+    }
+    return mapped;
+}
+
+static uint16_t readLE16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t readLE32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t readLE64(const uint8_t* p) {
+    return (uint64_t)readLE32(p) | ((uint64_t)readLE32(p + 4) << 32);
 }
 
 /**
- * Helper function to write a NumPy header with specified size
+ * Builds a view over a complete .npy image in memory
+ *
+ * @param storage Owner of the bytes, shared with the returned view
+ * @param bytes Start of the .npy image (magic string)
+ * @param size Size of the image in bytes
+ * @param mapped Whether the bytes come from a file mapping
+ * @param name File or member name used in error messages
  */
-void NumPyIO::writeHeader(std::ostream &file, size_t elements, NumPyDataType dataType, size_t fixedHeaderSize)
-{
-    auto typeInfoIt = TYPE_INFO.find(dataType);
-    const TypeInfo &typeInfo = typeInfoIt->second;
+NumPyArray NumPyIO::viewNpy(const std::shared_ptr<const void>& storage, const uint8_t* bytes,
+                            size_t size, bool mapped, const std::string& name) {
+    if (size < 10 || memcmp(bytes, "\x93NUMPY", 6) != 0) {
+        throw std::runtime_error("Invalid NumPy file format (incorrect magic string): " + name);
+    }
+    size_t preambleLen, headerLen;
+    if (bytes[6] == 1) {
+        preambleLen = 10;
+        headerLen = readLE16(bytes + 8);
+    } else if ((bytes[6] == 2 || bytes[6] == 3) && size >= 12) {
+        preambleLen = 12;
+        headerLen = readLE32(bytes + 8);
+    } else {
+        throw std::runtime_error("Unsupported NumPy format version in " + name);
+    }
 
-    // Check endianness
-    uint16_t endianCheck = 1;
-    char endianness = *reinterpret_cast<char *>(&endianCheck) ? '<' : '>';
+    size_t dataOffset = preambleLen + headerLen;
+    if (dataOffset > size) {
+        throw std::runtime_error("Truncated NumPy header in " + name);
+    }
 
-    // Create header with 1D shape
-    std::string header = "{'descr': '";
-    header += endianness;
-    header += typeInfo.numpyDescr;
-    header += "', 'fortran_order': False, 'shape': (";
-    header += std::to_string(elements);
-    header += ",)}";
+    std::string header(reinterpret_cast<const char*>(bytes + preambleLen), headerLen);
+    std::string descr;
+    bool fortranOrder = false;
+    NumPyArray array;
+    if (!parseHeader(header, descr, fortranOrder, array.m_shape)) {
+        throw std::runtime_error("Failed to parse NumPy header in " + name);
+    }
+    if (fortranOrder) {
+        throw std::runtime_error("Fortran-ordered NumPy arrays are not supported: " + name);
+    }
 
-    // Pad header to fixed size (leave space for one newline)
-    size_t paddingNeeded = fixedHeaderSize - 1 - header.length();
-    header.append(paddingNeeded, ' ');
-    header += '\n';
+    // Views cannot byte swap; non-native files go through ReadNumpyToArray instead
+    bool swapBytes = false;
+    if (!lookupDescr(descr, array.m_dataType, swapBytes) || swapBytes) {
+        throw std::runtime_error("Unsupported or non-native NumPy dtype '" + descr + "' in " + name);
+    }
+    array.m_elementSize = TYPE_INFO.find(array.m_dataType)->second.size;
 
-    // Magic string for .npy format
-    const char magic[] = "\x93NUMPY";
-    file.write(magic, 6);
+    array.m_elementCount = 1;
+    for (size_t dim : array.m_shape) {
+        array.m_elementCount *= dim;
+    }
+    if (array.ByteSize() > size - dataOffset) {
+        throw std::runtime_error("NumPy data is shorter than its shape in " + name);
+    }
 
-    // Version 1.0
-    const uint8_t majorVersion = 1;
-    const uint8_t minorVersion = 0;
-    file.write(reinterpret_cast<const char *>(&majorVersion), 1);
-    file.write(reinterpret_cast<const char *>(&minorVersion), 1);
+    const uint8_t* data = bytes + dataOffset;
+    if (reinterpret_cast<uintptr_t>(data) % array.m_elementSize == 0) {
+        array.m_storage = storage;
+        array.m_data = data;
+        array.m_mapped = mapped;
+    } else {
+        // Misaligned (e.g. a stored .npz member at an odd offset): copy into aligned memory
+        std::shared_ptr<std::vector<uint64_t>> aligned = std::make_shared<std::vector<uint64_t>>(
+            (array.ByteSize() + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+        memcpy(aligned->data(), data, array.ByteSize());
+        array.m_storage = aligned;
+        array.m_data = aligned->data();
+        array.m_mapped = false;
+    }
 
-    // Header length (fixed)
-    uint16_t headerLenLE = (uint16_t)fixedHeaderSize;
-    file.write(reinterpret_cast<char *>(&headerLenLE), 2);
+    // An empty array still gets a valid pointer so Empty() means "nothing loaded"
+    if (array.m_elementCount == 0 && array.m_data == nullptr) {
+        array.m_data = data;
+    }
+    return array;
+}
 
-    // Header
-    file.write(header.c_str(), header.length());
+/**
+ * Maps a .npy file into memory
+ *
+ * @param filename Path to the .npy file
+ * @return View of the array; the mapping stays alive as long as any copy of the view
+ */
+NumPyArray NumPyIO::MapNumpy(const std::string& filename) {
+    std::shared_ptr<MappedFile> mapped = mapFile(filename);
+    std::shared_ptr<const void> storage(mapped, mapped->data);
+    return viewNpy(storage, mapped->data, mapped->size, true, filename);
+}
+
+// ---------------------------------------------------------------------------
+// .npz archives (zip, stored or deflated members)
+// ---------------------------------------------------------------------------
+
+struct Crc32Table {
+    uint32_t entries[256];
+
+    Crc32Table() {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+            }
+            entries[i] = c;
+        }
+    }
+};
+
+static uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t length) {
+    static const Crc32Table crcTable;
+    const uint32_t* table = crcTable.entries;
+
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+// Canonical Huffman decoding table (RFC 1951 section 3.2.2)
+struct InflateHuffman {
+    uint16_t count[16];
+    uint16_t symbol[288];
+};
+
+struct InflateState {
+    const uint8_t* in;
+    size_t inSize;
+    size_t inPos;
+    uint32_t bitBuffer;
+    int bitCount;
+    uint8_t* out;
+    size_t outSize;
+    size_t outPos;
+};
+
+static uint32_t inflateBits(InflateState& s, int need) {
+    uint32_t value = s.bitBuffer;
+    while (s.bitCount < need) {
+        if (s.inPos >= s.inSize) {
+            throw std::runtime_error("Truncated deflate stream");
+        }
+        value |= (uint32_t)s.in[s.inPos++] << s.bitCount;
+        s.bitCount += 8;
+    }
+    s.bitBuffer = value >> need;
+    s.bitCount -= need;
+    return value & ((1u << need) - 1);
+}
+
+static void inflateBuild(InflateHuffman& h, const uint8_t* lengths, int n) {
+    memset(h.count, 0, sizeof(h.count));
+    for (int i = 0; i < n; i++) {
+        h.count[lengths[i]]++;
+    }
+    h.count[0] = 0;
+
+    // Reject over-subscribed code sets
+    int left = 1;
+    for (int len = 1; len < 16; len++) {
+        left <<= 1;
+        left -= h.count[len];
+        if (left < 0) {
+            throw std::runtime_error("Invalid deflate Huffman code");
+        }
+    }
+
+    uint16_t offsets[16];
+    offsets[1] = 0;
+    for (int len = 1; len < 15; len++) {
+        offsets[len + 1] = offsets[len] + h.count[len];
+    }
+    for (int i = 0; i < n; i++) {
+        if (lengths[i] != 0) {
+            h.symbol[offsets[lengths[i]]++] = (uint16_t)i;
+        }
+    }
+}
+
+static int inflateDecode(InflateState& s, const InflateHuffman& h) {
+    int code = 0, first = 0, index = 0;
+    for (int len = 1; len < 16; len++) {
+        code |= (int)inflateBits(s, 1);
+        int count = h.count[len];
+        if (code - count < first) {
+            return h.symbol[index + (code - first)];
+        }
+        index += count;
+        first += count;
+        first <<= 1;
+        code <<= 1;
+    }
+    throw std::runtime_error("Invalid deflate Huffman code");
 }
+
+static void inflateCodes(InflateState& s, const InflateHuffman& lencode, const InflateHuffman& distcode) {
+    static const uint16_t lengthBase[29] = {
+        3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+        35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    static const uint8_t lengthExtra[29] = {
+        0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+        3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    static const uint16_t distBase[30] = {
+        1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+        257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+    static const uint8_t distExtra[30] = {
+        0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+        7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+    while (true) {
+        int symbol = inflateDecode(s, lencode);
+        if (symbol < 256) {
+            if (s.outPos >= s.outSize) {
+                throw std::runtime_error("Deflate stream larger than expected");
+            }
+            s.out[s.outPos++] = (uint8_t)symbol;
+        } else if (symbol == 256) {
+            return;
+        } else {
+            symbol -= 257;
+            if (symbol >= 29) {
+                throw std::runtime_error("Invalid deflate length code");
+            }
+            size_t length = lengthBase[symbol] + inflateBits(s, lengthExtra[symbol]);
+
+            int distSymbol = inflateDecode(s, distcode);
+            if (distSymbol >= 30) {
+                throw std::runtime_error("Invalid deflate distance code");
+            }
+            size_t distance = distBase[distSymbol] + inflateBits(s, distExtra[distSymbol]);
+            if (distance > s.outPos || length > s.outSize - s.outPos) {
+                throw std::runtime_error("Invalid deflate back reference");
+            }
+
+            // Byte by byte: source and destination may overlap
+            uint8_t* dst = s.out + s.outPos;
+            const uint8_t* src = dst - distance;
+            for (size_t i = 0; i < length; i++) {
+                dst[i] = src[i];
+            }
+            s.outPos += length;
+        }
+    }
+}
+
+// Fixed Huffman codes of block type 1, built once
+struct InflateFixedCodes {
+    InflateHuffman lencode;
+    InflateHuffman distcode;
+
+    InflateFixedCodes() {
+        uint8_t lengths[288];
+        int i = 0;
+        for (; i < 144; i++) lengths[i] = 8;
+        for (; i < 256; i++) lengths[i] = 9;
+        for (; i < 280; i++) lengths[i] = 7;
+        for (; i < 288; i++) lengths[i] = 8;
+        inflateBuild(lencode, lengths, 288);
+        for (i = 0; i < 30; i++) lengths[i] = 5;
+        inflateBuild(distcode, lengths, 30);
+    }
+};
+
+/**
+ * Decompresses a raw deflate stream (zip method 8) whose decompressed size is known
+ */
+static void inflateRaw(const uint8_t* in, size_t inSize, uint8_t* out, size_t outSize) {
+    InflateState s = { in, inSize, 0, 0, 0, out, outSize, 0 };
+
+    bool last = false;
+    while (!last) {
+        last = inflateBits(s, 1) != 0;
+        uint32_t type = inflateBits(s, 2);
+
+        if (type == 0) {
+            // Stored block: drop to a byte boundary
+            s.bitBuffer = 0;
+            s.bitCount = 0;
+            if (s.inPos + 4 > s.inSize) {
+                throw std::runtime_error("Truncated deflate stream");
+            }
+            uint16_t length = readLE16(s.in + s.inPos);
+            uint16_t complement = readLE16(s.in + s.inPos + 2);
+            s.inPos += 4;
+            if (length != (uint16_t)~complement || s.inPos + length > s.inSize ||
+                length > s.outSize - s.outPos) {
+                throw std::runtime_error("Invalid stored deflate block");
+            }
+            memcpy(s.out + s.outPos, s.in + s.inPos, length);
+            s.inPos += length;
+            s.outPos += length;
+        } else if (type == 1) {
+            static const InflateFixedCodes fixed;
+            inflateCodes(s, fixed.lencode, fixed.distcode);
+        } else if (type == 2) {
+            static const uint8_t order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+            int nlen = (int)inflateBits(s, 5) + 257;
+            int ndist = (int)inflateBits(s, 5) + 1;
+            int ncode = (int)inflateBits(s, 4) + 4;
+            if (nlen > 286 || ndist > 30) {
+                throw std::runtime_error("Invalid dynamic deflate block");
+            }
+
+            uint8_t lengths[320];
+            memset(lengths, 0, sizeof(lengths));
+            for (int i = 0; i < ncode; i++) {
+                lengths[order[i]] = (uint8_t)inflateBits(s, 3);
+            }
+            InflateHuffman codeLengths;
+            inflateBuild(codeLengths, lengths, 19);
+
+            int index = 0;
+            while (index < nlen + ndist) {
+                int symbol = inflateDecode(s, codeLengths);
+                if (symbol < 16) {
+                    lengths[index++] = (uint8_t)symbol;
+                } else {
+                    uint8_t repeatValue = 0;
+                    int repeat;
+                    if (symbol == 16) {
+                        if (index == 0) {
+                            throw std::runtime_error("Invalid dynamic deflate block");
+                        }
+                        repeatValue = lengths[index - 1];
+                        repeat = 3 + (int)inflateBits(s, 2);
+                    } else if (symbol == 17) {
+                        repeat = 3 + (int)inflateBits(s, 3);
+                    } else {
+                        repeat = 11 + (int)inflateBits(s, 7);
+                    }
+                    if (index + repeat > nlen + ndist) {
+                        throw std::runtime_error("Invalid dynamic deflate block");
+                    }
+                    while (repeat--) {
+                        lengths[index++] = repeatValue;
+                    }
+                }
+            }
+
+            InflateHuffman lencode, distcode;
+            inflateBuild(lencode, lengths, nlen);
+            inflateBuild(distcode, lengths + nlen, ndist);
+            inflateCodes(s, lencode, distcode);
+        } else {
+            throw std::runtime_error("Invalid deflate block type");
+        }
+    }
+
+    if (s.outPos != s.outSize) {
+        throw std::runtime_error("Deflate stream smaller than expected");
+    }
+}
+
+/**
+ * Opens a .npz archive and reads its central directory
+ *
+ * @param filename Path to the .npz file
+ * @return Archive whose members can be fetched with Get()
+ */
+NumPyArchive NumPyIO::OpenNpz(const std::string& filename) {
+    std::shared_ptr<MappedFile> mapped = mapFile(filename);
+    const uint8_t* base = mapped->data;
+    const size_t size = mapped->size;
+
+    // End of central directory record: scan back over a possible archive comment
+    size_t eocd = std::string::npos;
+    if (size >= 22) {
+        size_t lowest = size > 22 + 0xFFFF ? size - 22 - 0xFFFF : 0;
+        for (size_t pos = size - 22; ; pos--) {
+            if (readLE32(base + pos) == 0x06054b50) {
+                eocd = pos;
+                break;
+            }
+            if (pos == lowest) {
+                break;
+            }
+        }
+    }
+    if (eocd == std::string::npos) {
+        throw std::runtime_error("Not a zip archive: " + filename);
+    }
+
+    uint64_t entryCount = readLE16(base + eocd + 10);
+    uint64_t directoryOffset = readLE32(base + eocd + 16);
+
+    // Zip64 (numpy uses it for members over 2 GB)
+    if (eocd >= 20 && readLE32(base + eocd - 20) == 0x07064b50) {
+        uint64_t zip64Eocd = readLE64(base + eocd - 20 + 8);
+        if (zip64Eocd + 56 > size || readLE32(base + zip64Eocd) != 0x06064b50) {
+            throw std::runtime_error("Corrupt zip64 directory in " + filename);
+        }
+        entryCount = readLE64(base + zip64Eocd + 32);
+        directoryOffset = readLE64(base + zip64Eocd + 48);
+    }
+
+    NumPyArchive archive;
+    archive.m_filename = filename;
+    archive.m_mapping = std::shared_ptr<const void>(mapped, mapped->data);
+    archive.m_base = base;
+    archive.m_size = size;
+
+    size_t pos = (size_t)directoryOffset;
+    for (uint64_t i = 0; i < entryCount; i++) {
+        if (pos + 46 > size || readLE32(base + pos) != 0x02014b50) {
+            throw std::runtime_error("Corrupt zip central directory in " + filename);
+        }
+
+        NumPyArchive::Member member;
+        uint16_t flags = readLE16(base + pos + 8);
+        member.method = readLE16(base + pos + 10);
+        member.crc32 = readLE32(base + pos + 16);
+        member.compressedSize = readLE32(base + pos + 20);
+        member.uncompressedSize = readLE32(base + pos + 24);
+        uint16_t nameLen = readLE16(base + pos + 28);
+        uint16_t extraLen = readLE16(base + pos + 30);
+        uint16_t commentLen = readLE16(base + pos + 32);
+        uint64_t localOffset = readLE32(base + pos + 42);
+
+        if (pos + 46 + nameLen + extraLen > size) {
+            throw std::runtime_error("Corrupt zip central directory in " + filename);
+        }
+        std::string name(reinterpret_cast<const char*>(base + pos + 46), nameLen);
+
+        // Zip64 extended information replaces the saturated 32-bit fields, in order
+        const uint8_t* extra = base + pos + 46 + nameLen;
+        const uint8_t* extraEnd = extra + extraLen;
+        while (extra + 4 <= extraEnd) {
+            uint16_t id = readLE16(extra);
+            uint16_t length = readLE16(extra + 2);
+            const uint8_t* field = extra + 4;
+            const uint8_t* fieldEnd = field + length;
+            if (fieldEnd > extraEnd) {
+                break;
+            }
+            if (id == 0x0001) {
+                if (member.uncompressedSize == 0xFFFFFFFF && field + 8 <= fieldEnd) {
+                    member.uncompressedSize = readLE64(field);
+                    field += 8;
+                }
+                if (member.compressedSize == 0xFFFFFFFF && field + 8 <= fieldEnd) {
+                    member.compressedSize = readLE64(field);
+                    field += 8;
+                }
+                if (localOffset == 0xFFFFFFFF && field + 8 <= fieldEnd) {
+                    localOffset = readLE64(field);
+                }
+            }
+            extra = fieldEnd;
+        }
+
+        pos += 46 + nameLen + extraLen + commentLen;
+
+        if (flags & 1) {
+            throw std::runtime_error("Encrypted zip members are not supported: " + name);
+        }
+        member.localHeaderOffset = (size_t)localOffset;
+
+        // numpy names members "<key>.npy"; expose the key and ignore anything else
+        if (name.length() > 4 && name.compare(name.length() - 4, 4, ".npy") == 0) {
+            name.erase(name.length() - 4);
+            archive.m_members[name] = member;
+        }
+    }
+
+    return archive;
+}
+
+std::vector<std::string> NumPyArchive::Names() const {
+    std::vector<std::string> names;
+    for (const auto& entry : m_members) {
+        names.push_back(entry.first);
+    }
+    return names;
+}
+
+bool NumPyArchive::Contains(const std::string& name) const {
+    return m_members.find(name) != m_members.end();
+}
+
+/**
+ * Returns a view of one archive member
+ *
+ * @param name Member name, as returned by Names()
+ * @return Zero-copy view for stored members, inflated copy for deflated ones
+ */
+NumPyArray NumPyArchive::Get(const std::string& name) const {
+    auto cached = m_cache.find(name);
+    if (cached != m_cache.end()) {
+        return cached->second;
+    }
+
+    auto it = m_members.find(name);
+    if (it == m_members.end()) {
+        throw std::runtime_error("Array '" + name + "' not found in " + m_filename);
+    }
+    const Member& member = it->second;
+
+    size_t pos = member.localHeaderOffset;
+    if (pos + 30 > m_size || readLE32(m_base + pos) != 0x04034b50) {
+        throw std::runtime_error("Corrupt zip local header for '" + name + "' in " + m_filename);
+    }
+    size_t dataStart = pos + 30 + readLE16(m_base + pos + 26) + readLE16(m_base + pos + 28);
+    if (dataStart > m_size || member.compressedSize > m_size - dataStart) {
+        throw std::runtime_error("Truncated zip member '" + name + "' in " + m_filename);
+    }
+    const uint8_t* data = m_base + dataStart;
+
+    NumPyArray array;
+    if (member.method == 0) {
+        array = NumPyIO::viewNpy(m_mapping, data, (size_t)member.compressedSize, true, name);
+    } else if (member.method == 8) {
+        std::shared_ptr<std::vector<uint8_t>> inflated =
+            std::make_shared<std::vector<uint8_t>>((size_t)member.uncompressedSize);
+        inflateRaw(data, (size_t)member.compressedSize, inflated->data(), inflated->size());
+        if (crc32Update(0, inflated->data(), inflated->size()) != member.crc32) {
+            throw std::runtime_error("CRC mismatch in zip member '" + name + "' in " + m_filename);
+        }
+        array = NumPyIO::viewNpy(inflated, inflated->data(), inflated->size(), false, name);
+    } else {
+        throw std::runtime_error("Unsupported zip compression method for '" + name + "' in " + m_filename);
+    }
+
+    m_cache[name] = array;
+    return array;
+}
+
 // For backward compatibility, provide the original function names
 bool NumPyIO::SaveFloatArrayToNumpy(const std::string& filename, const float* data, const std::vector<size_t>& shape) {
     return SaveArrayToNumpy(filename, data, shape, NumPyDataType::FLOAT32);
@@ -3,12 +3,26 @@
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <fstream>
+#include <memory>
+#include <map>
+#include <stdexcept>
+#include <unordered_map>
 
 // Enum for supported NumPy data types
 enum class NumPyDataType {
     FLOAT32,
     INT32,
-    // Add more types as needed
+    UINT8,
+    INT8,
+    UINT16,
+    INT16,
+    UINT32,
+    INT64,
+    UINT64,
+    FLOAT16,
+    FLOAT64,
+    BOOL,
 };
 
 // Structure to hold type information
@@ -21,12 +35,130 @@ struct TypeInfo {
 static const std::unordered_map<NumPyDataType, TypeInfo> TYPE_INFO = {
     {NumPyDataType::FLOAT32, {"f4", sizeof(float)}},
     {NumPyDataType::INT32, {"i4", sizeof(int32_t)}},
-    // Add more types as needed
+    {NumPyDataType::UINT8, {"u1", sizeof(uint8_t)}},
+    {NumPyDataType::INT8, {"i1", sizeof(int8_t)}},
+    {NumPyDataType::UINT16, {"u2", sizeof(uint16_t)}},
+    {NumPyDataType::INT16, {"i2", sizeof(int16_t)}},
+    {NumPyDataType::UINT32, {"u4", sizeof(uint32_t)}},
+    {NumPyDataType::INT64, {"i8", sizeof(int64_t)}},
+    {NumPyDataType::UINT64, {"u8", sizeof(uint64_t)}},
+    {NumPyDataType::FLOAT16, {"f2", sizeof(uint16_t)}},
+    {NumPyDataType::FLOAT64, {"f8", sizeof(double)}},
+    {NumPyDataType::BOOL, {"b1", sizeof(uint8_t)}},
+};
+
+// IEEE 754 half precision value as stored in float16 arrays
+struct NumPyHalf {
+    uint16_t bits;
+};
+
+float NumPyHalfToFloat(NumPyHalf value);
+NumPyHalf NumPyFloatToHalf(float value);
+
+// Compile-time mapping from C++ element types to NumPyDataType
+template <typename T> struct NumPyTypeOf;
+template <> struct NumPyTypeOf<float> { static const NumPyDataType value = NumPyDataType::FLOAT32; };
+template <> struct NumPyTypeOf<int32_t> { static const NumPyDataType value = NumPyDataType::INT32; };
+template <> struct NumPyTypeOf<uint8_t> { static const NumPyDataType value = NumPyDataType::UINT8; };
+template <> struct NumPyTypeOf<int8_t> { static const NumPyDataType value = NumPyDataType::INT8; };
+template <> struct NumPyTypeOf<uint16_t> { static const NumPyDataType value = NumPyDataType::UINT16; };
+template <> struct NumPyTypeOf<int16_t> { static const NumPyDataType value = NumPyDataType::INT16; };
+template <> struct NumPyTypeOf<uint32_t> { static const NumPyDataType value = NumPyDataType::UINT32; };
+template <> struct NumPyTypeOf<int64_t> { static const NumPyDataType value = NumPyDataType::INT64; };
+template <> struct NumPyTypeOf<uint64_t> { static const NumPyDataType value = NumPyDataType::UINT64; };
+template <> struct NumPyTypeOf<NumPyHalf> { static const NumPyDataType value = NumPyDataType::FLOAT16; };
+template <> struct NumPyTypeOf<double> { static const NumPyDataType value = NumPyDataType::FLOAT64; };
+template <> struct NumPyTypeOf<bool> { static const NumPyDataType value = NumPyDataType::BOOL; };
+
+/**
+ * @brief Read-only, shape-aware view of an array loaded by NumPyIO::MapNumpy or NumPyArchive
+ *
+ * The view shares ownership of its backing storage, which is either a memory mapping of
+ * the file (zero copy) or, for compressed or misaligned archive members, a private buffer.
+ * Copies are cheap and keep the storage alive.
+ */
+class NumPyArray {
+public:
+    NumPyArray() = default;
+
+    bool Empty() const { return m_data == nullptr; }
+    const void* Data() const { return m_data; }
+    const std::vector<size_t>& Shape() const { return m_shape; }
+    NumPyDataType DataType() const { return m_dataType; }
+    size_t ElementCount() const { return m_elementCount; }
+    size_t ByteSize() const { return m_elementCount * m_elementSize; }
+
+    // true when Data() points straight into a file mapping
+    bool IsMapped() const { return m_mapped; }
+
+    // Typed access; throws if T does not match the stored dtype
+    template <typename T>
+    const T* As() const {
+        if (NumPyTypeOf<T>::value != m_dataType) {
+            throw std::runtime_error("NumPy array element type does not match the requested type");
+        }
+        return static_cast<const T*>(m_data);
+    }
+
+    // Number of elements in one step along the first axis
+    size_t RowElements() const {
+        return m_shape.empty() || m_shape[0] == 0 ? 0 : m_elementCount / m_shape[0];
+    }
+
+private:
+    friend class NumPyIO;
+    friend class NumPyArchive;
+
+    std::shared_ptr<const void> m_storage;
+    const void* m_data = nullptr;
+    std::vector<size_t> m_shape;
+    NumPyDataType m_dataType = NumPyDataType::FLOAT32;
+    size_t m_elementSize = 0;
+    size_t m_elementCount = 0;
+    bool m_mapped = false;
+};
+
+/**
+ * @brief Memory-mapped .npz archive (as written by numpy.savez / savez_compressed)
+ *
+ * Stored members are returned as views into the mapping; deflated members are inflated
+ * once on first access and cached.
+ */
+class NumPyArchive {
+public:
+    NumPyArchive() = default;
+
+    // Member names without the .npy suffix
+    std::vector<std::string> Names() const;
+    bool Contains(const std::string& name) const;
+
+    // Throws std::runtime_error if the member is missing or malformed
+    NumPyArray Get(const std::string& name) const;
+
+private:
+    friend class NumPyIO;
+
+    struct Member {
+        size_t localHeaderOffset = 0;
+        uint64_t compressedSize = 0;
+        uint64_t uncompressedSize = 0;
+        uint32_t crc32 = 0;
+        uint16_t method = 0;
+    };
+
+    std::string m_filename;
+    std::shared_ptr<const void> m_mapping;
+    const uint8_t* m_base = nullptr;
+    size_t m_size = 0;
+    std::map<std::string, Member> m_members;
+    mutable std::map<std::string, NumPyArray> m_cache;
 };
 
 class NumPyIO {
 public:
-    // Generic functions that support multiple data types
+    // Generic functions that support multiple data types. Save writes a format 1.0 header
+    // (2.0 when the header outgrows 64 KiB) and streams the data in chunks, so arrays
+    // larger than 4 GB are fine. Read accepts format 1.0-3.0 in either byte order.
     static bool SaveArrayToNumpy(const std::string& filename, const void* data, 
                                 const std::vector<size_t>& shape, NumPyDataType dataType);
     
@@ -47,9 +179,75 @@ public:
     static int32_t* ReadNumpyToInt32Array(const std::string& filename, int32_t* data, 
                                          std::vector<size_t>& shape);
 
+    // Map a .npy file and return a zero-copy view. Throws std::runtime_error on failure.
+    static NumPyArray MapNumpy(const std::string& filename);
+
+    // Map a .npz archive. Throws std::runtime_error on failure.
+    static NumPyArchive OpenNpz(const std::string& filename);
+
+    // Convenience one-shot append to a 1-D array. For repeated appends use NumPyAppender,
+    // which keeps the file open instead of reopening and patching it on every call.
     static bool AppendToNumpyArray(const std::string& filename, const void* data, 
         size_t elements, NumPyDataType dataType);
     
 private:
-    static void writeHeader(std::ostream& file, size_t elements, NumPyDataType dataType, size_t fixedHeaderSize);
+    friend class NumPyAppender;
+    friend class NumPyArchive;
+
+    static void writeHeader(std::ostream& file, const std::vector<size_t>& shape, NumPyDataType dataType, size_t fixedHeaderSize);
+    static bool parseHeader(const std::string& header, std::string& descr, bool& fortranOrder, std::vector<size_t>& shape);
+    static NumPyArray viewNpy(const std::shared_ptr<const void>& storage, const uint8_t* bytes,
+                              size_t size, bool mapped, const std::string& name);
+};
+
+/**
+ * @brief Appends rows to a .npy file along the first axis while keeping it open
+ *
+ * Rows are buffered in memory and written sequentially; the shape in the header is
+ * only patched on Flush() or Close(), so an append costs a memcpy in the common case.
+ * The header is written with room for any row count, so it never has to move.
+ */
+class NumPyAppender {
+public:
+    NumPyAppender() = default;
+    ~NumPyAppender();
+
+    NumPyAppender(const NumPyAppender&) = delete;
+    NumPyAppender& operator=(const NumPyAppender&) = delete;
+
+    // rowShape is the shape of a single row, e.g. {} for a 1-D array or {2, 128, 128}
+    // for a stack of image pairs. With appendExisting, an existing file with a matching
+    // dtype and row shape is continued; otherwise the file is truncated.
+    bool Open(const std::string& filename, NumPyDataType dataType,
+              const std::vector<size_t>& rowShape, bool appendExisting = true,
+              size_t bufferBytes = 4 * 1024 * 1024);
+
+    // Append rowCount rows laid out contiguously in C order
+    bool Append(const void* rows, size_t rowCount = 1);
+
+    // Write buffered rows and patch the header shape
+    bool Flush();
+
+    bool Close();
+
+    bool IsOpen() const { return m_file.is_open(); }
+    size_t GetRowCount() const { return m_rowCount; }
+    const std::vector<size_t>& GetRowShape() const { return m_rowShape; }
+
+private:
+    bool writeBuffered();
+    bool createFile();
+    bool openExisting(bool& compatible);
+
+    std::fstream m_file;
+    std::string m_filename;
+    NumPyDataType m_dataType = NumPyDataType::FLOAT32;
+    std::vector<size_t> m_rowShape;
+    size_t m_rowBytes = 0;
+    size_t m_rowCount = 0;       // rows written or buffered
+    size_t m_headerRowCount = 0; // rows recorded in the on-disk header
+    size_t m_headerLength = 0;   // value of the header length field
+    std::vector<char> m_buffer;
+    size_t m_bufferUsed = 0;
+    bool m_failed = false;
 };
\ No newline at end of file
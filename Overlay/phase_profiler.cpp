@@ -0,0 +1,149 @@
+#include "phase_profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+const char* TrainerPhaseName(TrainerPhase phase) {
+    switch (phase) {
+        case TrainerPhase::ReadCapture: return "read_capture";
+        case TrainerPhase::Align: return "align";
+        case TrainerPhase::Decode: return "decode";
+        case TrainerPhase::BatchWait: return "batch_wait";
+        case TrainerPhase::BatchAssembly: return "batch_assembly";
+        case TrainerPhase::TrainStep: return "train_step";
+        case TrainerPhase::OptimizerStep: return "optimizer_step";
+        case TrainerPhase::LazyResetGrad: return "lazy_reset_grad";
+        case TrainerPhase::Validation: return "validation";
+        case TrainerPhase::Checkpoint: return "checkpoint";
+        case TrainerPhase::Export: return "export";
+        default: return "unknown";
+    }
+}
+
+// Lower edge of bucket b in seconds
+static double bucketLower(int bucket) {
+    return bucket == 0 ? 0.0 : std::ldexp(1e-6, bucket - 1);
+}
+
+PhaseProfiler::PhaseProfiler()
+    : m_startTime(std::chrono::steady_clock::now())
+{
+}
+
+void PhaseProfiler::Record(TrainerPhase phase, double seconds, size_t samples) {
+    PhaseStats& stats = m_phases[(int)phase];
+    seconds = std::max(seconds, 0.0);
+
+    int bucket = 0;
+    const double micros = seconds * 1e6;
+    if (micros >= 1.0) {
+        bucket = std::min((int)std::floor(std::log2(micros)) + 1, BUCKET_COUNT - 1);
+    }
+    stats.buckets[bucket]++;
+
+    if (stats.count == 0 || seconds < stats.min) {
+        stats.min = seconds;
+    }
+    stats.max = std::max(stats.max, seconds);
+    stats.count++;
+    stats.samples += samples;
+    stats.total += seconds;
+}
+
+double PhaseProfiler::Percentile(TrainerPhase phase, double fraction) const {
+    const PhaseStats& stats = m_phases[(int)phase];
+    if (stats.count == 0) {
+        return 0.0;
+    }
+
+    // Linear interpolation inside the bucket holding the rank, kept within the exact range
+    const double rank = fraction * stats.count;
+    uint64_t below = 0;
+    for (int b = 0; b < BUCKET_COUNT; b++) {
+        if (stats.buckets[b] == 0) {
+            continue;
+        }
+        if (below + stats.buckets[b] >= rank) {
+            const double lower = bucketLower(b);
+            const double upper = b == BUCKET_COUNT - 1 ? stats.max : bucketLower(b + 1);
+            const double estimate = lower + (upper - lower) * (rank - below) / stats.buckets[b];
+            return std::min(std::max(estimate, stats.min), stats.max);
+        }
+        below += stats.buckets[b];
+    }
+    return stats.max;
+}
+
+double PhaseProfiler::WallSeconds() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_startTime).count();
+}
+
+void PhaseProfiler::PrintSummary() const {
+    const double wall = WallSeconds();
+
+    printf("===== Phase profile (%.2fs wall) =====\n", wall);
+    printf("%-16s %8s %10s %7s %10s %10s %10s %10s %10s %12s\n", "Phase", "Count", "Total s", "Wall %",
+           "Mean ms", "p50 ms", "p90 ms", "p99 ms", "Max ms", "Samples/s");
+    for (int p = 0; p < TRAINER_PHASE_COUNT; p++) {
+        const PhaseStats& stats = m_phases[p];
+        if (stats.count == 0) {
+            continue;
+        }
+        const TrainerPhase phase = (TrainerPhase)p;
+        char throughput[32] = "-";
+        if (stats.samples > 0 && stats.total > 0.0) {
+            snprintf(throughput, sizeof(throughput), "%.1f", stats.samples / stats.total);
+        }
+        printf("%-16s %8llu %10.3f %7.1f %10.3f %10.3f %10.3f %10.3f %10.3f %12s\n", TrainerPhaseName(phase),
+               (unsigned long long)stats.count, stats.total, wall > 0.0 ? stats.total / wall * 100.0 : 0.0,
+               stats.total / stats.count * 1e3, Percentile(phase, 0.5) * 1e3, Percentile(phase, 0.9) * 1e3,
+               Percentile(phase, 0.99) * 1e3, stats.max * 1e3, throughput);
+    }
+    printf("Batch assembly runs on the loader threads and overlaps the other phases.\n");
+    printf("======================================\n");
+}
+
+bool PhaseProfiler::WriteReport(const std::string& path) const {
+    FILE* file = fopen(path.c_str(), "w");
+    if (file == NULL) {
+        return false;
+    }
+
+    fprintf(file, "{\n  \"wall_seconds\": %.6f,\n", WallSeconds());
+    fprintf(file, "  \"bucket_lower_seconds\": [");
+    for (int b = 0; b < BUCKET_COUNT; b++) {
+        fprintf(file, "%s%.9g", b > 0 ? ", " : "", bucketLower(b));
+    }
+    fprintf(file, "],\n  \"phases\": {");
+
+    bool first = true;
+    for (int p = 0; p < TRAINER_PHASE_COUNT; p++) {
+        const PhaseStats& stats = m_phases[p];
+        if (stats.count == 0) {
+            continue;
+        }
+        const TrainerPhase phase = (TrainerPhase)p;
+        fprintf(file, "%s\n    \"%s\": {\n", first ? "" : ",", TrainerPhaseName(phase));
+        fprintf(file, "      \"count\": %llu,\n", (unsigned long long)stats.count);
+        fprintf(file, "      \"samples\": %llu,\n", (unsigned long long)stats.samples);
+        fprintf(file, "      \"total_seconds\": %.9g,\n", stats.total);
+        fprintf(file, "      \"min_seconds\": %.9g,\n", stats.min);
+        fprintf(file, "      \"max_seconds\": %.9g,\n", stats.max);
+        fprintf(file, "      \"p50_seconds\": %.9g,\n", Percentile(phase, 0.5));
+        fprintf(file, "      \"p90_seconds\": %.9g,\n", Percentile(phase, 0.9));
+        fprintf(file, "      \"p99_seconds\": %.9g,\n", Percentile(phase, 0.99));
+        fprintf(file, "      \"samples_per_second\": %.9g,\n",
+                stats.samples > 0 && stats.total > 0.0 ? stats.samples / stats.total : 0.0);
+        fprintf(file, "      \"buckets\": [");
+        for (int b = 0; b < BUCKET_COUNT; b++) {
+            fprintf(file, "%s%llu", b > 0 ? ", " : "", (unsigned long long)stats.buckets[b]);
+        }
+        fprintf(file, "]\n    }");
+        first = false;
+    }
+    fprintf(file, "\n  }\n}\n");
+
+    const bool ok = ferror(file) == 0;
+    return fclose(file) == 0 && ok;
+}
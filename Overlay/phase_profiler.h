@@ -0,0 +1,89 @@
+// phase_profiler.h
+#ifndef PHASE_PROFILER_H
+#define PHASE_PROFILER_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Phases of a training run the profiler times
+enum class TrainerPhase {
+    ReadCapture,     // reading and parsing the capture file
+    Align,           // matching label frames to eye frames
+    Decode,          // JPEG decode and resampling into the frame cache
+    BatchWait,       // training thread blocked on the batch loader
+    BatchAssembly,   // loader worker time spent filling one batch
+    TrainStep,
+    OptimizerStep,
+    LazyResetGrad,
+    Validation,      // one full validation pass
+    Checkpoint,
+    Export,
+    Count
+};
+
+static const int TRAINER_PHASE_COUNT = (int)TrainerPhase::Count;
+
+const char* TrainerPhaseName(TrainerPhase phase);
+
+/**
+ * @brief Per-phase latency histograms and throughput of a training run
+ *
+ * Every Record adds one occurrence of a phase with its duration and the number of
+ * samples (frames or windows) it processed. Durations go into power-of-two buckets
+ * starting at 1 microsecond, from which the percentiles are estimated to within a
+ * factor of two; count, total, min and max are exact. Recording is a few additions and
+ * is meant for the training thread only; loader workers report through their batches.
+ */
+class PhaseProfiler {
+public:
+    static const int BUCKET_COUNT = 40;   // bucket b holds [2^(b-1), 2^b) us; bucket 0 is < 1 us
+
+    PhaseProfiler();
+
+    void Record(TrainerPhase phase, double seconds, size_t samples = 0);
+
+    // Estimated duration below which fraction of the occurrences fall
+    double Percentile(TrainerPhase phase, double fraction) const;
+
+    // Seconds since construction
+    double WallSeconds() const;
+
+    // Table of every phase that occurred
+    void PrintSummary() const;
+    // Same data plus the raw buckets as JSON; returns false if the file cannot be written
+    bool WriteReport(const std::string& path) const;
+
+private:
+    struct PhaseStats {
+        uint64_t count = 0;
+        uint64_t samples = 0;
+        double total = 0.0;
+        double min = 0.0;
+        double max = 0.0;
+        uint64_t buckets[BUCKET_COUNT] = {};
+    };
+
+    PhaseStats m_phases[TRAINER_PHASE_COUNT];
+    std::chrono::steady_clock::time_point m_startTime;
+};
+
+// Records the lifetime of the scope as one occurrence of a phase
+class ScopedPhase {
+public:
+    ScopedPhase(PhaseProfiler& profiler, TrainerPhase phase, size_t samples = 0)
+        : m_profiler(profiler), m_phase(phase), m_samples(samples), m_start(std::chrono::steady_clock::now()) {}
+    ~ScopedPhase() {
+        m_profiler.Record(m_phase, std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count(),
+                          m_samples);
+    }
+
+private:
+    PhaseProfiler& m_profiler;
+    TrainerPhase m_phase;
+    size_t m_samples;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+#endif // PHASE_PROFILER_H
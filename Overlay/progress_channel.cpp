@@ -0,0 +1,86 @@
+#include "progress_channel.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#undef max
+#undef min
+#else
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+ProgressChannelWriter::~ProgressChannelWriter() {
+    Close();
+}
+
+bool ProgressChannelWriter::Open(const std::string& handle) {
+    Close();
+
+    char* end = nullptr;
+    long long value = strtoll(handle.c_str(), &end, 10);
+    if (handle.empty() || *end != '\0' || value < 0) {
+        return false;
+    }
+
+#ifndef _WIN32
+    // Writing after the overlay closed its end must fail the write, not kill the trainer
+    signal(SIGPIPE, SIG_IGN);
+#endif
+
+    m_handle = (intptr_t)value;
+    m_open = true;
+    return true;
+}
+
+void ProgressChannelWriter::Close() {
+    if (!m_open) {
+        return;
+    }
+#ifdef _WIN32
+    CloseHandle((HANDLE)m_handle);
+#else
+    close((int)m_handle);
+#endif
+    m_open = false;
+    m_handle = -1;
+}
+
+void ProgressChannelWriter::Send(const ProgressRecord& record) {
+    if (!m_open) {
+        return;
+    }
+
+    // A failed write means the reader went away; stop sending rather than fail training
+#ifdef _WIN32
+    DWORD written = 0;
+    if (!WriteFile((HANDLE)m_handle, &record, sizeof(record), &written, NULL) || written != sizeof(record)) {
+        Close();
+    }
+#else
+    if (write((int)m_handle, &record, sizeof(record)) != (ssize_t)sizeof(record)) {
+        Close();
+    }
+#endif
+}
+
+void ProgressRecordDecoder::appendPending(const char* data, size_t length) {
+    memcpy(m_buffer + m_pending, data, length);
+    m_pending += length;
+}
+
+bool ProgressRecordDecoder::takeRecord() {
+    uint32_t magic;
+    memcpy(&magic, m_buffer, sizeof(magic));
+    if (magic != PROGRESS_RECORD_MAGIC) {
+        memmove(m_buffer, m_buffer + 1, sizeof(m_buffer) - 1);
+        m_pending--;
+        return false;
+    }
+
+    memcpy(&m_record, m_buffer, sizeof(m_record));
+    m_pending = 0;
+    return true;
+}
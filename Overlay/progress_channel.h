@@ -0,0 +1,107 @@
+// progress_channel.h
+#ifndef PROGRESS_CHANNEL_H
+#define PROGRESS_CHANNEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Trainer -> overlay progress records. Human-readable logs stay on stdout; these go over
+// a dedicated pipe the overlay hands to the trainer with --progress-fd.
+
+enum class ProgressEvent : uint8_t {
+    Started = 1,    // configuration known: totalEpochs, totalBatches
+    EpochStarted,
+    Batch,          // loss = batch loss
+    EpochFinished,  // loss = epoch average training loss
+    Validation,     // loss = validation loss
+    Completed,      // model exported
+    Failed,
+    Telemetry,      // layer = parameter tensor index or -1 for the whole model
+};
+
+#define PROGRESS_RECORD_MAGIC 0x52504242u  // "BBPR"
+
+// Fixed-size record; both ends run on the same machine, so it is sent in native layout
+struct ProgressRecord {
+    uint32_t magic = PROGRESS_RECORD_MAGIC;
+    uint8_t event = 0;              // ProgressEvent
+    uint8_t reserved[3] = {0, 0, 0};
+    int32_t epoch = 0;              // 1-based; 0 during the online phase of --follow
+    int32_t totalEpochs = 0;        // upper bound; early stopping may end sooner
+    int32_t batch = 0;              // 1-based within the epoch
+    int32_t totalBatches = 0;
+    float loss = 0.0f;
+    float samplesPerSecond = 0.0f;
+    float etaSeconds = -1.0f;       // -1 when unknown
+    float elapsedSeconds = 0.0f;
+    int32_t layer = -1;             // Telemetry only
+    float parameterNorm = 0.0f;     // Telemetry: L2 norm of the parameters
+    float updateRatio = 0.0f;       // Telemetry: update norm / parameter norm per optimizer step
+};
+
+static_assert(sizeof(ProgressRecord) == 52, "ProgressRecord layout changed");
+
+/**
+ * @brief Writing end, used by the trainer
+ *
+ * Every record is a single write far below the pipe's atomic size, so a record is never
+ * interleaved or split by the writer. Without an open channel Send() does nothing.
+ */
+class ProgressChannelWriter {
+public:
+    ~ProgressChannelWriter();
+
+    // handle is the decimal file descriptor (POSIX) or HANDLE value (Windows) inherited
+    // from the parent
+    bool Open(const std::string& handle);
+    void Close();
+    bool IsOpen() const { return m_open; }
+
+    void Send(const ProgressRecord& record);
+
+private:
+    intptr_t m_handle = -1;
+    bool m_open = false;
+};
+
+/**
+ * @brief Reading end, used by the overlay
+ *
+ * Reassembles records from arbitrary pipe reads with a fixed-size staging buffer, so the
+ * cost per record is constant and reads that split a record are handled. Bytes that do
+ * not start with the record magic are skipped until the stream resynchronises.
+ */
+class ProgressRecordDecoder {
+public:
+    void Reset() { m_pending = 0; }
+
+    // Calls onRecord(const ProgressRecord&) for every complete record in data
+    template <typename Callback>
+    void Feed(const char* data, size_t length, Callback onRecord) {
+        while (length > 0) {
+            size_t take = sizeof(ProgressRecord) - m_pending;
+            if (take > length) {
+                take = length;
+            }
+            appendPending(data, take);
+            data += take;
+            length -= take;
+
+            if (m_pending == sizeof(ProgressRecord) && takeRecord()) {
+                onRecord(m_record);
+            }
+        }
+    }
+
+private:
+    void appendPending(const char* data, size_t length);
+    // Validates a full staging buffer; on a bad magic drops one byte and returns false
+    bool takeRecord();
+
+    unsigned char m_buffer[sizeof(ProgressRecord)];
+    size_t m_pending = 0;
+    ProgressRecord m_record;
+};
+
+#endif // PROGRESS_CHANNEL_H
@@ -0,0 +1,149 @@
+#!/usr/bin/env python3
+"""
+Static int8 quantisation of a trained eye tracking model.
+
+The trainer calls this after exporting the float model when run with --quantize. It
+writes three arrays next to the training artifacts:
+
+  <prefix>_calibration.npy    uint8 [N, 8, 128, 128] windows from the training split
+  <prefix>_heldout.npy        uint8 [M, 8, 128, 128] windows the model was not trained on
+  <prefix>_heldout_labels.npy float32 [M, 10] targets of the held-out windows
+
+Activation ranges are calibrated on the first set; the second is used to report how far
+the int8 model drifts from the float one, alongside size and single-frame CPU latency.
+
+Usage: python quantize_model.py model.onnx model_int8.onnx sample_prefix [max_drift]
+
+Exit code 0 on success, 1 on failure and 3 when the held-out error grew by more than
+max_drift (relative, default 0.1); the int8 model is still written in that case.
+"""
+
+import os
+import sys
+import time
+
+import numpy as np
+import onnxruntime as ort
+from onnxruntime.quantization import (CalibrationDataReader, CalibrationMethod, QuantFormat,
+                                      QuantType, quantize_static)
+
+PIXEL_SCALE = np.float32(1.0 / 255.0)  # same scaling as the trainer's batch loader
+
+
+def to_input(planes):
+    return planes.astype(np.float32) * PIXEL_SCALE
+
+
+class WindowReader(CalibrationDataReader):
+    """Feeds the calibration windows in small batches"""
+
+    def __init__(self, windows, input_name, batch_size=8):
+        self.windows = windows
+        self.input_name = input_name
+        self.batch_size = batch_size
+        self.position = 0
+
+    def get_next(self):
+        if self.position >= len(self.windows):
+            return None
+        batch = self.windows[self.position:self.position + self.batch_size]
+        self.position += self.batch_size
+        return {self.input_name: to_input(batch)}
+
+    def rewind(self):
+        self.position = 0
+
+
+def create_session(path, threads=1):
+    options = ort.SessionOptions()
+    options.intra_op_num_threads = threads
+    options.inter_op_num_threads = 1
+    options.graph_optimization_level = ort.GraphOptimizationLevel.ORT_ENABLE_ALL
+    return ort.InferenceSession(path, options, providers=["CPUExecutionProvider"])
+
+
+def predict(session, windows, batch_size=16):
+    input_name = session.get_inputs()[0].name
+    outputs = []
+    for start in range(0, len(windows), batch_size):
+        outputs.append(session.run(None, {input_name: to_input(windows[start:start + batch_size])})[0])
+    return np.concatenate(outputs)
+
+
+def frame_latency_ms(session, window, runs=100):
+    """Median single-window latency on one thread, as the overlay runs it per frame"""
+    input_name = session.get_inputs()[0].name
+    feed = {input_name: to_input(window[np.newaxis])}
+    for _ in range(10):
+        session.run(None, feed)
+    times = []
+    for _ in range(runs):
+        start = time.perf_counter()
+        session.run(None, feed)
+        times.append(time.perf_counter() - start)
+    return float(np.median(times)) * 1000.0
+
+
+def main():
+    if len(sys.argv) < 4:
+        print(__doc__)
+        return 1
+
+    float_path, int8_path, prefix = sys.argv[1:4]
+    max_drift = float(sys.argv[4]) if len(sys.argv) > 4 else 0.1
+
+    calibration = np.load(prefix + "_calibration.npy", mmap_mode="r")
+    heldout = np.load(prefix + "_heldout.npy", mmap_mode="r")
+    labels = np.load(prefix + "_heldout_labels.npy")
+    if len(calibration) == 0 or len(heldout) == 0:
+        print("Quantisation: no calibration or held-out windows")
+        return 1
+
+    float_session = create_session(float_path)
+    input_name = float_session.get_inputs()[0].name
+
+    # Per-channel int8 weights, uint8 activations, QDQ graph that ORT's CPU provider fuses
+    # into integer kernels
+    print(f"Quantisation: calibrating on {len(calibration)} windows")
+    quantize_static(
+        float_path,
+        int8_path,
+        WindowReader(calibration, input_name),
+        quant_format=QuantFormat.QDQ,
+        activation_type=QuantType.QUInt8,
+        weight_type=QuantType.QInt8,
+        per_channel=True,
+        calibrate_method=CalibrationMethod.MinMax,
+    )
+    int8_session = create_session(int8_path)
+
+    float_out = predict(float_session, heldout)
+    int8_out = predict(int8_session, heldout)
+
+    float_mse = float(np.mean((float_out - labels) ** 2))
+    int8_mse = float(np.mean((int8_out - labels) ** 2))
+    difference = np.abs(int8_out - float_out)
+    drift = (int8_mse - float_mse) / float_mse if float_mse > 0 else 0.0
+
+    float_size = os.path.getsize(float_path)
+    int8_size = os.path.getsize(int8_path)
+    float_ms = frame_latency_ms(float_session, heldout[0])
+    int8_ms = frame_latency_ms(int8_session, heldout[0])
+
+    print(f"Quantisation: {len(heldout)} held-out windows")
+    print(f"  Model size:      {float_size / 1024:.0f} KB -> {int8_size / 1024:.0f} KB "
+          f"({float_size / max(int8_size, 1):.1f}x smaller)")
+    print(f"  Frame latency:   {float_ms:.2f} ms -> {int8_ms:.2f} ms ({float_ms / max(int8_ms, 1e-6):.1f}x faster)")
+    print(f"  Held-out MSE:    {float_mse:.6f} -> {int8_mse:.6f} ({drift * 100:+.1f}%)")
+    print(f"  Output drift:    mean {difference.mean():.5f}, max {difference.max():.5f}")
+    print("  Per output mean: " + " ".join(f"{v:.4f}" for v in difference.mean(axis=0)))
+
+    if drift > max_drift:
+        print(f"Quantisation: held-out error grew by more than {max_drift * 100:.0f}%, "
+              f"prefer the float model")
+        return 3
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,216 @@
+#include "stage_sampler.h"
+#include "flags.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <utility>
+
+// Routine stage numbers as driven by RoutineController (see the stage switch in main.cpp)
+static StageClass classForStage(int stage) {
+    switch (stage) {
+        case 1: case 2: return StageClass::Gaze;
+        case 4: case 6: return StageClass::Lids;
+        case 8: case 10: return StageClass::Winks;
+        case 12: case 14: return StageClass::Brows;
+        case 16: return StageClass::Convergence;
+        case 18: case 20: case 22: return StageClass::Dilation;
+        default: return StageClass::Other;
+    }
+}
+
+const char* StageClassName(StageClass stageClass) {
+    switch (stageClass) {
+        case StageClass::Gaze: return "gaze";
+        case StageClass::Lids: return "lids";
+        case StageClass::Winks: return "winks";
+        case StageClass::Brows: return "brows";
+        case StageClass::Convergence: return "convergence";
+        case StageClass::Dilation: return "dilation";
+        default: return "other";
+    }
+}
+
+StageClass ClassifyStage(const AlignedFrame& frame) {
+    float pitch, yaw, distance, fovAdjust, leftLid, rightLid, browRaise, browAngry, widen, squint, dilate;
+    uint32_t state;
+    extract_label_data(frame, pitch, yaw, distance, fovAdjust, leftLid, rightLid, browRaise, browAngry,
+                       widen, squint, dilate, state);
+
+    const uint32_t stageBits = state & FLAG_ROUTINE_STAGE_MASK;
+    if (stageBits != 0) {
+        int stage = 0;
+        while (!(stageBits & FLAG_ROUTINE_STAGE(stage))) {
+            stage++;
+        }
+        return classForStage(stage);
+    }
+
+    // Older captures: the flags and labels tell most stages apart
+    if (state & FLAG_CONVERGENCE) {
+        return StageClass::Convergence;
+    }
+    if ((state & (FLAG_DILATION_BLACK | FLAG_DILATION_WHITE | FLAG_DILATION_GRADIENT)) || dilate > 0.0f) {
+        return StageClass::Dilation;
+    }
+    if (leftLid > 0.0f || rightLid > 0.0f) {
+        return leftLid == rightLid ? StageClass::Lids : StageClass::Winks;
+    }
+    if (browRaise > 0.0f || browAngry > 0.0f || widen > 0.0f || squint > 0.0f) {
+        return StageClass::Brows;
+    }
+    return StageClass::Gaze;
+}
+
+bool ParseStageWeights(const char* spec, float weights[STAGE_CLASS_COUNT]) {
+    std::string text = spec;
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t end = text.find(',', start);
+        if (end == std::string::npos) {
+            end = text.size();
+        }
+        const std::string item = text.substr(start, end - start);
+        const size_t equals = item.find('=');
+        if (equals == std::string::npos) {
+            return false;
+        }
+
+        const std::string name = item.substr(0, equals);
+        const char* value = item.c_str() + equals + 1;
+        char* valueEnd = nullptr;
+        const float weight = strtof(value, &valueEnd);
+        if (valueEnd == value || *valueEnd != '\0' || !(weight >= 0.0f)) {
+            return false;
+        }
+
+        int found = -1;
+        for (int c = 0; c < STAGE_CLASS_COUNT; c++) {
+            if (name == StageClassName((StageClass)c)) {
+                found = c;
+            }
+        }
+        if (found < 0) {
+            return false;
+        }
+        weights[found] = weight;
+        start = end + 1;
+    }
+    return true;
+}
+
+StageSampler::StageSampler(const float weights[STAGE_CLASS_COUNT], float maxRepeats)
+    : m_pools(STAGE_CLASS_COUNT + 1)
+    , m_maxRepeats(maxRepeats)
+{
+    for (int c = 0; c < STAGE_CLASS_COUNT; c++) {
+        m_pools[c].weight = weights[c];
+    }
+}
+
+void StageSampler::AddWindow(size_t window, StageClass stageClass) {
+    m_pools[(int)stageClass].windows.push_back(window);
+}
+
+void StageSampler::SetFixedPool(const std::vector<size_t>& windows, size_t perEpoch) {
+    Pool& pool = m_pools[STAGE_CLASS_COUNT];
+    pool.windows = windows;
+    pool.quota = std::min(perEpoch, windows.size());
+}
+
+size_t StageSampler::Plan(size_t epochSize) {
+    // Water-filling: classes that would exceed their repeat cap are fixed at the cap and
+    // the rest of the epoch is split again between the others
+    std::vector<int> open;
+    for (int c = 0; c < STAGE_CLASS_COUNT; c++) {
+        m_pools[c].quota = 0;
+        if (m_pools[c].weight > 0.0f && !m_pools[c].windows.empty()) {
+            open.push_back(c);
+        }
+    }
+
+    size_t remaining = epochSize;
+    bool capped = true;
+    while (capped && !open.empty()) {
+        capped = false;
+        double weightSum = 0.0;
+        for (int c : open) {
+            weightSum += m_pools[c].weight;
+        }
+        for (size_t i = 0; i < open.size(); i++) {
+            Pool& pool = m_pools[open[i]];
+            const size_t cap = std::max<size_t>(1, (size_t)(pool.windows.size() * m_maxRepeats));
+            if (remaining * pool.weight / weightSum > cap) {
+                pool.quota = cap;
+                remaining -= std::min(remaining, cap);
+                open.erase(open.begin() + i);
+                capped = true;
+                break;
+            }
+        }
+    }
+
+    // Largest remainder rounding of the uncapped shares
+    double weightSum = 0.0;
+    for (int c : open) {
+        weightSum += m_pools[c].weight;
+    }
+    std::vector<std::pair<double, int>> remainders;
+    size_t assigned = 0;
+    for (int c : open) {
+        const double share = remaining * m_pools[c].weight / weightSum;
+        m_pools[c].quota = (size_t)share;
+        assigned += m_pools[c].quota;
+        remainders.push_back(std::make_pair(share - std::floor(share), c));
+    }
+    std::sort(remainders.begin(), remainders.end(), std::greater<std::pair<double, int>>());
+    for (size_t i = 0; i < remainders.size() && assigned < remaining; i++, assigned++) {
+        m_pools[remainders[i].second].quota++;
+    }
+
+    size_t total = 0;
+    for (const Pool& pool : m_pools) {
+        total += pool.quota;
+    }
+    return total;
+}
+
+void StageSampler::DrawEpoch(std::mt19937& rng, std::vector<size_t>& order) {
+    // Each drawn window gets a sort key spread evenly over [0, 1) within its class, so
+    // sorting interleaves the classes in proportion to their quotas
+    std::uniform_real_distribution<double> jitter(0.0, 1.0);
+    std::vector<std::pair<double, size_t>> keyed;
+    for (Pool& pool : m_pools) {
+        for (size_t k = 0; k < pool.quota; k++) {
+            if (pool.cursor == 0) {
+                std::shuffle(pool.windows.begin(), pool.windows.end(), rng);
+            }
+            keyed.push_back(std::make_pair((k + jitter(rng)) / pool.quota, pool.windows[pool.cursor]));
+            pool.cursor = (pool.cursor + 1) % pool.windows.size();
+        }
+    }
+    std::sort(keyed.begin(), keyed.end());
+
+    order.resize(keyed.size());
+    for (size_t i = 0; i < keyed.size(); i++) {
+        order[i] = keyed[i].second;
+    }
+}
+
+void StageSampler::PrintPlan() const {
+    printf("Stage-balanced epochs:\n");
+    printf("  %-12s %8s %8s %10s %8s\n", "Class", "Windows", "Weight", "Per epoch", "Repeats");
+    for (size_t c = 0; c < m_pools.size(); c++) {
+        const Pool& pool = m_pools[c];
+        if (pool.windows.empty()) {
+            continue;
+        }
+        const char* name = c < (size_t)STAGE_CLASS_COUNT ? StageClassName((StageClass)c) : "replay";
+        printf("  %-12s %8zu %8.2f %10zu %8.2f\n", name, pool.windows.size(), c < (size_t)STAGE_CLASS_COUNT ? pool.weight : 0.0f,
+               pool.quota, (double)pool.quota / pool.windows.size());
+    }
+}
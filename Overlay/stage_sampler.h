@@ -0,0 +1,78 @@
+// stage_sampler.h
+#ifndef STAGE_SAMPLER_H
+#define STAGE_SAMPLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "capture_reader.h"
+
+// Groups of calibration routine stages the sampler balances
+enum class StageClass {
+    Gaze,         // horizontal and vertical sweeps
+    Lids,         // both eyes closed or half closed
+    Winks,        // one eye closed
+    Brows,        // widen, angry
+    Convergence,
+    Dilation,     // black, white and gradient screens
+    Other,
+    Count
+};
+
+static const int STAGE_CLASS_COUNT = (int)StageClass::Count;
+
+const char* StageClassName(StageClass stageClass);
+
+// Class of a frame from the stage bits in its routineState. Captures recorded before
+// the stage was stored are classified from the labels instead.
+StageClass ClassifyStage(const AlignedFrame& frame);
+
+// Parses "name=weight,..." over the class names above, e.g. "gaze=1,winks=2". Classes not
+// listed keep their weight; 0 leaves a class out of balanced epochs.
+bool ParseStageWeights(const char* spec, float weights[STAGE_CLASS_COUNT]);
+
+/**
+ * @brief Stage-balanced epochs over the training windows
+ *
+ * Every epoch draws a fixed number of windows per class, proportional to the class
+ * weights instead of to how long each stage ran, so the few seconds of lid, brow,
+ * convergence and dilation data are not drowned out by the gaze sweeps. A class gets at
+ * most maxRepeats times its window count per epoch; what it cannot use goes to the
+ * others. Each class is drawn from its own shuffled cycle, so a large class is covered
+ * without repeats over several epochs. The drawn windows are interleaved in proportion,
+ * so every batch holds roughly the planned mix.
+ */
+class StageSampler {
+public:
+    StageSampler(const float weights[STAGE_CLASS_COUNT], float maxRepeats);
+
+    void AddWindow(size_t window, StageClass stageClass);
+
+    // Windows drawn perEpoch at a time on top of the classes, e.g. replay windows
+    void SetFixedPool(const std::vector<size_t>& windows, size_t perEpoch);
+
+    // Splits about epochSize windows between the classes. Returns the actual epoch
+    // length including the fixed pool.
+    size_t Plan(size_t epochSize);
+
+    // Replaces order with the windows of the next epoch
+    void DrawEpoch(std::mt19937& rng, std::vector<size_t>& order);
+
+    void PrintPlan() const;
+
+private:
+    struct Pool {
+        std::vector<size_t> windows;
+        size_t cursor = 0;      // position in the current shuffled cycle
+        float weight = 0.0f;
+        size_t quota = 0;       // windows per epoch
+    };
+
+    // One pool per class, then the fixed pool
+    std::vector<Pool> m_pools;
+    float m_maxRepeats;
+};
+
+#endif // STAGE_SAMPLER_H
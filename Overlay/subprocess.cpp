@@ -24,17 +24,31 @@ bool spawnProcess(
     return ProcessRunner::spawnProcess(program, params, onStdOut, onStdErr, onComplete);
 }
 
+bool spawnProcessWithChannel(
+    const std::string& program,
+    const std::vector<std::string>& params,
+    const std::string& channelFlag,
+    std::function<void(const std::string&)> onStdOut,
+    std::function<void(const std::string&)> onStdErr,
+    std::function<void(const std::string&)> onChannel,
+    std::function<void(int)> onComplete
+) {
+    return ProcessRunner::spawnProcess(program, params, onStdOut, onStdErr, onComplete, channelFlag, onChannel);
+}
+
 bool ProcessRunner::spawnProcess(
     const std::string& program,
     const std::vector<std::string>& args,
     OutputCallback onStdOut,
     OutputCallback onStdErr,
-    CompletionCallback onComplete
+    CompletionCallback onComplete,
+    const std::string& channelFlag,
+    OutputCallback onChannel
 ) {
 #ifdef _WIN32
-    return spawnProcessWindows(program, args, onStdOut, onStdErr, onComplete);
+    return spawnProcessWindows(program, args, onStdOut, onStdErr, onComplete, channelFlag, onChannel);
 #else
-    return spawnProcessUnix(program, args, onStdOut, onStdErr, onComplete);
+    return spawnProcessUnix(program, args, onStdOut, onStdErr, onComplete, channelFlag, onChannel);
 #endif
 }
 
@@ -44,26 +58,44 @@ bool ProcessRunner::spawnProcessWindows(
     const std::vector<std::string>& args,
     OutputCallback onStdOut,
     OutputCallback onStdErr,
-    CompletionCallback onComplete
+    CompletionCallback onComplete,
+    const std::string& channelFlag,
+    OutputCallback onChannel
 ) {
-    // Build command line
-    std::string cmdLine = "\"" + program + "\"";
-    for (const auto& arg : args) {
-        cmdLine += " \"" + arg + "\"";
-    }
-
     // Set up security attributes for pipes
     SECURITY_ATTRIBUTES saAttr;
     saAttr.nLength = sizeof(SECURITY_ATTRIBUTES);
     saAttr.bInheritHandle = TRUE;
     saAttr.lpSecurityDescriptor = NULL;
 
+    // Optional data channel; the child gets the inherited write handle's value
+    HANDLE channelRead = NULL, channelWrite = NULL;
+    if (onChannel) {
+        if (!CreatePipe(&channelRead, &channelWrite, &saAttr, 0)) {
+            return false;
+        }
+        SetHandleInformation(channelRead, HANDLE_FLAG_INHERIT, 0);
+    }
+
+    // Build command line
+    std::string cmdLine = "\"" + program + "\"";
+    for (const auto& arg : args) {
+        cmdLine += " \"" + arg + "\"";
+    }
+    if (onChannel) {
+        cmdLine += " \"" + channelFlag + std::to_string((unsigned long long)(uintptr_t)channelWrite) + "\"";
+    }
+
     // Create pipes for stdout and stderr
     HANDLE stdoutRead, stdoutWrite;
     HANDLE stderrRead, stderrWrite;
 
     if (!CreatePipe(&stdoutRead, &stdoutWrite, &saAttr, 0) ||
         !CreatePipe(&stderrRead, &stderrWrite, &saAttr, 0)) {
+        if (onChannel) {
+            CloseHandle(channelRead);
+            CloseHandle(channelWrite);
+        }
         return false;
     }
 
@@ -106,15 +138,33 @@ bool ProcessRunner::spawnProcessWindows(
     // Close pipe write-ends as we don't need them
     CloseHandle(stdoutWrite);
     CloseHandle(stderrWrite);
+    if (onChannel) {
+        CloseHandle(channelWrite);
+    }
 
     if (!success) {
         DWORD error = GetLastError();
         printf("DEBUG: CreateProcessA failed with error code: %lu\n", error);
         CloseHandle(stdoutRead);
         CloseHandle(stderrRead);
+        if (onChannel) {
+            CloseHandle(channelRead);
+        }
         return false;
     }
 
+    if (onChannel) {
+        std::thread channelThread([channelRead, onChannel]() {
+            char buffer[4096];
+            DWORD bytesRead;
+            while (ReadFile(channelRead, buffer, sizeof(buffer), &bytesRead, NULL) && bytesRead > 0) {
+                onChannel(std::string(buffer, bytesRead));
+            }
+            CloseHandle(channelRead);
+        });
+        channelThread.detach();
+    }
+
     // Create threads to read from pipes
     std::thread stdoutThread([stdoutRead, onStdOut]() {
         printf("DEBUG: stdout reading thread started\n");
@@ -178,7 +228,9 @@ bool ProcessRunner::spawnProcessUnix(
     const std::vector<std::string>& args,
     OutputCallback onStdOut,
     OutputCallback onStdErr,
-    CompletionCallback onComplete
+    CompletionCallback onComplete,
+    const std::string& channelFlag,
+    OutputCallback onChannel
 ) {
     // Create pipes for stdout and stderr
     int stdoutPipe[2];
@@ -188,6 +240,16 @@ bool ProcessRunner::spawnProcessUnix(
         return false;
     }
     
+    // Optional data channel; the child keeps the write end open under its own number
+    int channelPipe[2] = {-1, -1};
+    if (onChannel && pipe(channelPipe) == -1) {
+        close(stdoutPipe[0]);
+        close(stdoutPipe[1]);
+        close(stderrPipe[0]);
+        close(stderrPipe[1]);
+        return false;
+    }
+    
     // Fork the process
     pid_t pid = fork();
     
@@ -197,6 +259,10 @@ bool ProcessRunner::spawnProcessUnix(
         close(stdoutPipe[1]);
         close(stderrPipe[0]);
         close(stderrPipe[1]);
+        if (onChannel) {
+            close(channelPipe[0]);
+            close(channelPipe[1]);
+        }
         return false;
     }
     
@@ -213,12 +279,21 @@ bool ProcessRunner::spawnProcessUnix(
         close(stderrPipe[0]);
         close(stderrPipe[1]);
         
+        std::string channelArg;
+        if (onChannel) {
+            close(channelPipe[0]);
+            channelArg = channelFlag + std::to_string(channelPipe[1]);
+        }
+        
         // Prepare arguments for exec
         std::vector<char*> cargs;
         cargs.push_back(const_cast<char*>(program.c_str()));
         for (const auto& arg : args) {
             cargs.push_back(const_cast<char*>(arg.c_str()));
         }
+        if (onChannel) {
+            cargs.push_back(const_cast<char*>(channelArg.c_str()));
+        }
         cargs.push_back(nullptr);  // Null-terminate the array
         
         // Execute the program
@@ -233,6 +308,24 @@ bool ProcessRunner::spawnProcessUnix(
     // Close write ends of pipes
     close(stdoutPipe[1]);
     close(stderrPipe[1]);
+    if (onChannel) {
+        close(channelPipe[1]);
+        
+        // Blocking reads are fine here: the thread has nothing else to do
+        std::thread channelThread([channelPipe, onChannel]() {
+            char buffer[4096];
+            ssize_t bytesRead;
+            while ((bytesRead = read(channelPipe[0], buffer, sizeof(buffer))) != 0) {
+                if (bytesRead > 0) {
+                    onChannel(std::string(buffer, bytesRead));
+                } else if (errno != EINTR) {
+                    break;
+                }
+            }
+            close(channelPipe[0]);
+        });
+        channelThread.detach();
+    }
     
     // Set non-blocking mode for the pipes
     fcntl(stdoutPipe[0], F_SETFL, O_NONBLOCK);
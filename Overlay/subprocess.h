@@ -26,6 +26,27 @@ bool spawnProcess(
     std::function<void(int)> onComplete
 );
 
+/**
+ * @brief Spawns a child process with an extra one-way data channel
+ * 
+ * Like spawnProcess, plus a third pipe whose write end the child inherits. The child
+ * learns where it is through one extra argument, channelFlag followed by the file
+ * descriptor (POSIX) or handle value (Windows). Whatever the child writes there is
+ * delivered to onChannel, separate from stdout and stderr.
+ * 
+ * @param channelFlag Argument prefix naming the channel, e.g. "--progress-fd="
+ * @param onChannel Callback function that receives channel data as it becomes available
+ */
+bool spawnProcessWithChannel(
+    const std::string& program,
+    const std::vector<std::string>& params,
+    const std::string& channelFlag,
+    std::function<void(const std::string&)> onStdOut,
+    std::function<void(const std::string&)> onStdErr,
+    std::function<void(const std::string&)> onChannel,
+    std::function<void(int)> onComplete
+);
+
 /**
  * @brief ProcessRunner class that handles the details of spawning and managing processes
  * 
@@ -45,6 +66,8 @@ public:
      * @param onStdOut Callback function for stdout output
      * @param onStdErr Callback function for stderr output
      * @param onComplete Callback function for process completion
+     * @param channelFlag Argument prefix passing the data channel to the child
+     * @param onChannel Callback function for channel data; no channel is created if empty
      * @return true if the process was started successfully, false otherwise
      */
     static bool spawnProcess(
@@ -52,7 +75,9 @@ public:
         const std::vector<std::string>& args,
         OutputCallback onStdOut,
         OutputCallback onStdErr,
-        CompletionCallback onComplete
+        CompletionCallback onComplete,
+        const std::string& channelFlag = std::string(),
+        OutputCallback onChannel = OutputCallback()
     );
 
 private:
@@ -62,7 +87,9 @@ private:
         const std::vector<std::string>& args,
         OutputCallback onStdOut,
         OutputCallback onStdErr,
-        CompletionCallback onComplete
+        CompletionCallback onComplete,
+        const std::string& channelFlag,
+        OutputCallback onChannel
     );
 #else
     static bool spawnProcessUnix(
@@ -70,7 +97,9 @@ private:
         const std::vector<std::string>& args,
         OutputCallback onStdOut,
         OutputCallback onStdErr,
-        CompletionCallback onComplete
+        CompletionCallback onComplete,
+        const std::string& channelFlag,
+        OutputCallback onChannel
     );
 #endif
 };
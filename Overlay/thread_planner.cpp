@@ -0,0 +1,472 @@
+#include "thread_planner.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <thread>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#undef max
+#undef min
+#elif defined(__APPLE__)
+#include <sys/types.h>
+#include <sys/sysctl.h>
+#elif defined(__linux__)
+#include <sched.h>
+#endif
+
+int CpuTopology::PerformanceCoreCount() const {
+    int count = 0;
+    for (const CpuCore& core : cores) {
+        count += core.efficiency ? 0 : 1;
+    }
+    return count;
+}
+
+int CpuTopology::EfficiencyCoreCount() const {
+    return (int)cores.size() - PerformanceCoreCount();
+}
+
+// Performance cores first, each class by its lowest CPU id
+static void sortCores(CpuTopology& topology) {
+    std::sort(topology.cores.begin(), topology.cores.end(), [](const CpuCore& a, const CpuCore& b) {
+        if (a.efficiency != b.efficiency) {
+            return !a.efficiency;
+        }
+        return a.cpus.front() < b.cpus.front();
+    });
+    topology.logicalCount = 0;
+    for (const CpuCore& core : topology.cores) {
+        topology.logicalCount += (int)core.cpus.size();
+    }
+}
+
+// One core per hardware thread, with made-up CPU ids
+static CpuTopology fallbackTopology() {
+    CpuTopology topology;
+    const int count = std::max<int>(std::thread::hardware_concurrency(), 1);
+    for (int cpu = 0; cpu < count; cpu++) {
+        CpuCore core;
+        core.cpus.push_back(cpu);
+        topology.cores.push_back(core);
+    }
+    sortCores(topology);
+    return topology;
+}
+
+#if defined(__linux__)
+static bool readSysfsLine(const std::string& path, std::string& out) {
+    FILE* file = fopen(path.c_str(), "r");
+    if (file == NULL) {
+        return false;
+    }
+    char line[4096];
+    const bool ok = fgets(line, sizeof(line), file) != NULL;
+    fclose(file);
+    if (ok) {
+        out = line;
+    }
+    return ok;
+}
+
+static int readSysfsInt(const std::string& path, int fallback) {
+    std::string line;
+    if (!readSysfsLine(path, line)) {
+        return fallback;
+    }
+    char* end = nullptr;
+    const long value = strtol(line.c_str(), &end, 10);
+    return end == line.c_str() ? fallback : (int)value;
+}
+
+// Parses a CPU list such as "0-3,8,10-11"
+static std::vector<int> parseCpuList(const std::string& text) {
+    std::vector<int> cpus;
+    const char* cursor = text.c_str();
+    while (*cursor) {
+        char* end = nullptr;
+        const long first = strtol(cursor, &end, 10);
+        if (end == cursor) {
+            break;
+        }
+        long last = first;
+        cursor = end;
+        if (*cursor == '-') {
+            last = strtol(cursor + 1, &end, 10);
+            cursor = end;
+        }
+        for (long cpu = first; cpu <= last; cpu++) {
+            cpus.push_back((int)cpu);
+        }
+        if (*cursor != ',') {
+            break;
+        }
+        cursor++;
+    }
+    return cpus;
+}
+
+static CpuTopology detectTopology() {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        return fallbackTopology();
+    }
+
+    // Intel hybrid CPUs list their E cores under a separate PMU; elsewhere a lower
+    // capacity marks the LITTLE cores
+    std::string atomList;
+    std::vector<int> atomCpus;
+    if (readSysfsLine("/sys/devices/cpu_atom/cpus", atomList)) {
+        atomCpus = parseCpuList(atomList);
+    }
+
+    CpuTopology topology;
+    std::map<std::pair<int, int>, size_t> coreIndex;   // (package, core id) -> core
+    std::vector<int> capacities;                        // per core
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, &allowed)) {
+            continue;
+        }
+        const std::string base = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+        const int package = readSysfsInt(base + "/topology/physical_package_id", 0);
+        int coreId = readSysfsInt(base + "/topology/core_id", -1);
+        if (coreId < 0) {
+            coreId = -1 - cpu;   // unknown: a core of its own
+        }
+
+        auto inserted = coreIndex.insert(std::make_pair(std::make_pair(package, coreId), topology.cores.size()));
+        if (inserted.second) {
+            topology.cores.push_back(CpuCore());
+            capacities.push_back(0);
+        }
+        const size_t index = inserted.first->second;
+        topology.cores[index].cpus.push_back(cpu);
+        capacities[index] = std::max(capacities[index], readSysfsInt(base + "/cpu_capacity", 0));
+        if (std::find(atomCpus.begin(), atomCpus.end(), cpu) != atomCpus.end()) {
+            topology.cores[index].efficiency = true;
+        }
+    }
+    if (topology.cores.empty()) {
+        return fallbackTopology();
+    }
+
+    if (atomCpus.empty()) {
+        const int maxCapacity = *std::max_element(capacities.begin(), capacities.end());
+        for (size_t c = 0; c < topology.cores.size(); c++) {
+            topology.cores[c].efficiency = capacities[c] > 0 && capacities[c] < maxCapacity;
+        }
+    }
+
+    topology.affinitySupported = true;
+    topology.source = "sysfs";
+    sortCores(topology);
+    return topology;
+}
+#elif defined(_WIN32)
+static CpuTopology detectTopology() {
+    DWORD length = 0;
+    GetLogicalProcessorInformationEx(RelationProcessorCore, NULL, &length);
+    std::vector<char> buffer(length);
+    if (length == 0 ||
+        !GetLogicalProcessorInformationEx(RelationProcessorCore,
+                                          (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*)buffer.data(), &length)) {
+        return fallbackTopology();
+    }
+    DWORD_PTR processMask = 0, systemMask = 0;
+    if (!GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask)) {
+        processMask = ~(DWORD_PTR)0;
+    }
+
+    // Thread affinity masks only reach processor group 0, which holds every CPU of a
+    // desktop machine. A higher EfficiencyClass means a faster core.
+    CpuTopology topology;
+    std::vector<BYTE> classes;
+    for (DWORD offset = 0; offset < length;) {
+        const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX* entry =
+            (const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*)(buffer.data() + offset);
+        offset += entry->Size;
+        if (entry->Relationship != RelationProcessorCore) {
+            continue;
+        }
+        CpuCore core;
+        for (WORD g = 0; g < entry->Processor.GroupCount; g++) {
+            if (entry->Processor.GroupMask[g].Group != 0) {
+                continue;
+            }
+            const KAFFINITY mask = entry->Processor.GroupMask[g].Mask & processMask;
+            for (int bit = 0; bit < (int)(sizeof(KAFFINITY) * 8); bit++) {
+                if (mask & ((KAFFINITY)1 << bit)) {
+                    core.cpus.push_back(bit);
+                }
+            }
+        }
+        if (!core.cpus.empty()) {
+            topology.cores.push_back(core);
+            classes.push_back(entry->Processor.EfficiencyClass);
+        }
+    }
+    if (topology.cores.empty()) {
+        return fallbackTopology();
+    }
+
+    const BYTE maxClass = *std::max_element(classes.begin(), classes.end());
+    for (size_t c = 0; c < topology.cores.size(); c++) {
+        topology.cores[c].efficiency = classes[c] < maxClass;
+    }
+
+    topology.affinitySupported = true;
+    topology.source = "GetLogicalProcessorInformationEx";
+    sortCores(topology);
+    return topology;
+}
+#elif defined(__APPLE__)
+static int sysctlInt(const char* name) {
+    int value = 0;
+    size_t size = sizeof(value);
+    return sysctlbyname(name, &value, &size, NULL, 0) == 0 ? value : 0;
+}
+
+// macOS has no thread affinity; the layout still sets the budgets
+static CpuTopology detectTopology() {
+    CpuTopology topology;
+    int nextCpu = 0;
+    auto addCores = [&](int physical, int logical, bool efficiency) {
+        const int perCore = physical > 0 ? std::max(logical / physical, 1) : 1;
+        for (int c = 0; c < physical; c++) {
+            CpuCore core;
+            core.efficiency = efficiency;
+            for (int t = 0; t < perCore; t++) {
+                core.cpus.push_back(nextCpu++);
+            }
+            topology.cores.push_back(core);
+        }
+    };
+
+    const int levels = sysctlInt("hw.nperflevels");
+    if (levels >= 2) {
+        addCores(sysctlInt("hw.perflevel0.physicalcpu"), sysctlInt("hw.perflevel0.logicalcpu"), false);
+        addCores(sysctlInt("hw.perflevel1.physicalcpu"), sysctlInt("hw.perflevel1.logicalcpu"), true);
+    } else {
+        addCores(sysctlInt("hw.physicalcpu"), sysctlInt("hw.logicalcpu"), false);
+    }
+    if (topology.cores.empty()) {
+        return fallbackTopology();
+    }
+
+    topology.source = "sysctl";
+    sortCores(topology);
+    return topology;
+}
+#else
+static CpuTopology detectTopology() {
+    return fallbackTopology();
+}
+#endif
+
+CpuTopology DetectCpuTopology() {
+    return detectTopology();
+}
+
+static void appendCpus(std::vector<int>& out, const CpuCore& core, size_t first = 0) {
+    for (size_t t = first; t < core.cpus.size(); t++) {
+        out.push_back(core.cpus[t]);
+    }
+}
+
+ThreadPlan PlanThreads(const CpuTopology& topology, const ThreadPlanOptions& options) {
+    std::vector<const CpuCore*> performance, efficiency;
+    for (const CpuCore& core : topology.cores) {
+        (core.efficiency ? efficiency : performance).push_back(&core);
+    }
+    if (performance.empty()) {
+        performance.swap(efficiency);
+    }
+
+    ThreadPlan plan;
+    plan.pinned = options.pin && topology.affinitySupported;
+
+    // Reserve for the overlay, keeping at least one core for ORT
+    const int performanceCount = (int)performance.size();
+    int reserve = options.reserveCores;
+    if (reserve < 0) {
+        reserve = performanceCount >= 6 ? 2 : (performanceCount >= 3 ? 1 : 0);
+    }
+    reserve = std::min(reserve, performanceCount - 1);
+    plan.reservedCores = reserve;
+    for (int c = 0; c < reserve; c++) {
+        appendCpus(plan.reservedCpus, *performance[c]);
+    }
+    std::vector<const CpuCore*> ortCores(performance.begin() + reserve, performance.end());
+
+    const int usableLogical = topology.logicalCount - (int)plan.reservedCpus.size();
+    plan.loaderWorkers = options.loaderWorkers > 0 ? options.loaderWorkers : std::max(1, std::min(4, usableLogical / 4));
+
+    // Loaders: efficiency cores, else SMT siblings, else cores taken from the top of ORT's
+    for (const CpuCore* core : efficiency) {
+        appendCpus(plan.loaderCpus, *core);
+    }
+    if (plan.loaderCpus.empty()) {
+        for (const CpuCore* core : ortCores) {
+            appendCpus(plan.loaderCpus, *core, 1);
+        }
+    }
+    if (plan.loaderCpus.empty()) {
+        const int taken = std::min(plan.loaderWorkers, (int)ortCores.size() - 1);
+        for (int c = 0; c < taken; c++) {
+            appendCpus(plan.loaderCpus, *ortCores.back());
+            ortCores.pop_back();
+        }
+    }
+    if (plan.loaderCpus.empty()) {
+        appendCpus(plan.loaderCpus, *ortCores.front());
+    }
+
+    // One intra-op thread per physical core; more than that fill the SMT siblings the
+    // loaders do not use, then share ORT's CPUs
+    std::vector<int> ortCpus;
+    for (const CpuCore* core : ortCores) {
+        ortCpus.push_back(core->cpus.front());
+    }
+    for (const CpuCore* core : ortCores) {
+        for (size_t t = 1; t < core->cpus.size(); t++) {
+            if (std::find(plan.loaderCpus.begin(), plan.loaderCpus.end(), core->cpus[t]) == plan.loaderCpus.end()) {
+                ortCpus.push_back(core->cpus[t]);
+            }
+        }
+    }
+    plan.intraOpThreads = options.intraOpThreads > 0 ? options.intraOpThreads : (int)ortCores.size();
+    for (int t = 0; t < plan.intraOpThreads; t++) {
+        plan.intraOpCpus.push_back(ortCpus[t % ortCpus.size()]);
+    }
+    plan.interOpThreads = options.interOpThreads > 0 ? options.interOpThreads : 1;
+
+    for (size_t c = reserve; c < performance.size(); c++) {
+        appendCpus(plan.decodeCpus, *performance[c]);
+    }
+    for (const CpuCore* core : efficiency) {
+        appendCpus(plan.decodeCpus, *core);
+    }
+    plan.decodeWorkers = options.decodeWorkers > 0 ? options.decodeWorkers : (int)plan.decodeCpus.size();
+
+    std::sort(plan.loaderCpus.begin(), plan.loaderCpus.end());
+    std::sort(plan.decodeCpus.begin(), plan.decodeCpus.end());
+    return plan;
+}
+
+std::string ThreadPlan::IntraOpAffinities() const {
+    std::string value;
+    if (!pinned) {
+        return value;
+    }
+    // Logical processor ids start at 1 here
+    for (size_t t = 1; t < intraOpCpus.size(); t++) {
+        if (!value.empty()) {
+            value += ';';
+        }
+        value += std::to_string(intraOpCpus[t] + 1);
+    }
+    return value;
+}
+
+// "0-3,8" style list of a set of CPUs
+static std::string formatCpuList(std::vector<int> cpus) {
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    std::string text;
+    for (size_t i = 0; i < cpus.size();) {
+        size_t j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) {
+            j++;
+        }
+        if (!text.empty()) {
+            text += ',';
+        }
+        text += std::to_string(cpus[i]);
+        if (j > i) {
+            text += '-' + std::to_string(cpus[j]);
+        }
+        i = j + 1;
+    }
+    return text.empty() ? "-" : text;
+}
+
+void ThreadPlan::Print(const CpuTopology& topology) const {
+    printf("CPU topology (%s): %d performance cores, %d efficiency cores, %d logical CPUs\n", topology.source,
+           topology.PerformanceCoreCount(), topology.EfficiencyCoreCount(), topology.logicalCount);
+    printf("Thread plan:\n");
+    printf("  %-24s %3d cores    CPUs %s\n", "Reserved for the overlay", reservedCores,
+           formatCpuList(reservedCpus).c_str());
+    printf("  %-24s %3d threads  CPUs %s\n", "ORT intra-op", intraOpThreads, formatCpuList(intraOpCpus).c_str());
+    printf("  %-24s %3d threads\n", "ORT inter-op", interOpThreads);
+    printf("  %-24s %3d threads  CPUs %s\n", "Batch loaders", loaderWorkers, formatCpuList(loaderCpus).c_str());
+    printf("  %-24s %3d threads  CPUs %s\n", "Decode workers", decodeWorkers, formatCpuList(decodeCpus).c_str());
+    std::vector<int> shared;
+    for (int cpu : loaderCpus) {
+        if (std::find(intraOpCpus.begin(), intraOpCpus.end(), cpu) != intraOpCpus.end()) {
+            shared.push_back(cpu);
+        }
+    }
+    if (!shared.empty()) {
+        printf("  WARNING: ORT intra-op and loader threads share CPUs %s\n", formatCpuList(shared).c_str());
+    }
+    std::vector<int> distinct(intraOpCpus);
+    std::sort(distinct.begin(), distinct.end());
+    distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+    if (distinct.size() < intraOpCpus.size()) {
+        printf("  WARNING: %d intra-op threads on %zu CPUs\n", intraOpThreads, distinct.size());
+    }
+    if (pinned) {
+        printf("  Threads pinned to their CPUs\n");
+    } else if (topology.affinitySupported) {
+        printf("  CPU placement left to the OS (--pin-threads to pin)\n");
+    } else {
+        printf("  CPU placement left to the OS (no thread affinity here)\n");
+    }
+}
+
+static ThreadPlan g_threadPlan;
+
+void SetThreadPlan(const ThreadPlan& plan) {
+    g_threadPlan = plan;
+}
+
+const ThreadPlan& GetThreadPlan() {
+    return g_threadPlan;
+}
+
+void PinWorkerThread(ThreadRole role) {
+    if (!g_threadPlan.pinned) {
+        return;
+    }
+    PinCurrentThread(role == ThreadRole::Loader ? g_threadPlan.loaderCpus : g_threadPlan.decodeCpus);
+}
+
+bool PinCurrentThread(const std::vector<int>& cpus) {
+#if defined(_WIN32)
+    DWORD_PTR mask = 0;
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < (int)(sizeof(DWORD_PTR) * 8)) {
+            mask |= (DWORD_PTR)1 << cpu;
+        }
+    }
+    return mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    bool any = false;
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+            any = true;
+        }
+    }
+    return any && sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    (void)cpus;
+    return false;
+#endif
+}
@@ -0,0 +1,87 @@
+// thread_planner.h
+#ifndef THREAD_PLANNER_H
+#define THREAD_PLANNER_H
+
+#include <string>
+#include <vector>
+
+// One physical core and the logical CPUs (SMT siblings) it runs
+struct CpuCore {
+    std::vector<int> cpus;     // logical CPU ids, lowest first
+    bool efficiency = false;   // E core of a hybrid CPU, or a LITTLE core
+};
+
+struct CpuTopology {
+    std::vector<CpuCore> cores;       // performance cores first, each class by CPU id
+    int logicalCount = 0;
+    bool affinitySupported = false;   // CPU ids are real and threads can be pinned to them
+    const char* source = "fallback";  // where the layout came from
+
+    int PerformanceCoreCount() const;
+    int EfficiencyCoreCount() const;
+};
+
+// Cores, SMT siblings and core classes of the CPUs this process may run on. Falls back
+// to one core per hardware thread, without affinity, where the layout is unknown.
+CpuTopology DetectCpuTopology();
+
+// Explicit settings of the plan; -1 or 0 leaves the choice to PlanThreads
+struct ThreadPlanOptions {
+    int reserveCores = -1;    // performance cores kept free for the overlay and the VR runtime
+    int intraOpThreads = 0;
+    int interOpThreads = 0;
+    int loaderWorkers = 0;
+    int decodeWorkers = 0;
+    bool pin = false;         // also set CPU affinities where the OS allows it
+};
+
+// Thread budgets of the trainer's pools and, when pinned, the CPUs each may use
+struct ThreadPlan {
+    int reservedCores = 0;
+    int intraOpThreads = 1;
+    int interOpThreads = 1;
+    int loaderWorkers = 1;
+    int decodeWorkers = 1;
+    std::vector<int> reservedCpus;
+    std::vector<int> intraOpCpus;   // one per thread; the first is left to the training thread
+    std::vector<int> loaderCpus;
+    std::vector<int> decodeCpus;
+    bool pinned = false;
+
+    // Value of ORT's session.intra_op_thread_affinities for the pool threads besides the
+    // training thread; empty when not pinned or with a single thread
+    std::string IntraOpAffinities() const;
+
+    void Print(const CpuTopology& topology) const;
+};
+
+/**
+ * @brief Splits the CPUs between the overlay and the trainer's thread pools
+ *
+ * A few performance cores, the lowest numbered where the system does most of its own
+ * work, are left to the overlay and the VR runtime: two on CPUs with six or more, one
+ * on three to five. ORT's intra-op pool gets one thread per remaining physical
+ * performance core, since GEMM threads sharing a core through SMT mostly slow each other
+ * down, and the inter-op pool a single thread as the training graph runs sequentially.
+ * Batch loaders go to the efficiency cores, or else the SMT siblings of ORT's cores, or
+ * else cores taken from ORT. Decoding runs before training and uses every logical CPU
+ * outside the reserve.
+ */
+ThreadPlan PlanThreads(const CpuTopology& topology, const ThreadPlanOptions& options);
+
+// Which pool a worker thread belongs to
+enum class ThreadRole {
+    Loader,
+    Decode,
+};
+
+// Makes the plan the process-wide one; call before any worker starts
+void SetThreadPlan(const ThreadPlan& plan);
+const ThreadPlan& GetThreadPlan();
+
+// Pins the calling thread to the CPUs of its role when the plan is pinned
+void PinWorkerThread(ThreadRole role);
+// Pins the calling thread to the given CPUs; false where unsupported or refused
+bool PinCurrentThread(const std::vector<int>& cpus);
+
+#endif // THREAD_PLANNER_H
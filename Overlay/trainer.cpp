@@ -10,11 +10,31 @@
 #include <random>
 #include <algorithm>
 #include <numeric>
+#include <iterator>
 #include <chrono>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <cstdlib>
 
 #include "capture_data.h"
 #include "capture_reader.h"
+#include "capture_set.h"
 #include "flags.h"
+#include "batch_loader.h"
+#include "frame_cache.h"
+#include "augmentation.h"
+#include "stage_sampler.h"
+#include "frame_dedup.h"
+#include "gather_kernels.h"
+#include "numpy_io.h"
+#include "lr_schedule.h"
+#include "memory_tracker.h"
+#include "phase_profiler.h"
+#include "progress_channel.h"
+#include "thread_planner.h"
+#include "training_telemetry.h"
+#include "trainer_options.h"
 
 #define STD_MIN(a, b) ((a) < (b) ? (a) : (b))
 
@@ -22,6 +42,9 @@
 #define TRAIN_RESOLUTION 128
 #define NUM_FRAMES 4  // Updated for new model (current frame + 3 previous frames)
 #define NUM_CLASSES 10  // Updated for all eye tracking parameters (excluding fovAdjustDistance)
+#define ONLINE_ROUND_BATCHES 50  // batches per round of online training (--follow)
+#define ONLINE_AUGMENT_STREAM (1ULL << 32)  // augmentation streams of online rounds start here
+#define MEMORY_CHECK_BATCHES 50  // batches between resident set checks against --memory-budget
 #define ENABLE_CUDA 0  // Set to 1 to enable CUDA, 0 to use CPU only
 
 
@@ -32,27 +55,9 @@
 #undef min  // If you also have min issues
 #else
 #include <unistd.h>
+#include <sys/wait.h>
 #endif
 
-int get_cpu_thread_count() {
-    int num_threads = 0;
-    
-    #ifdef _WIN32
-        SYSTEM_INFO sysinfo;
-        GetSystemInfo(&sysinfo);
-        num_threads = sysinfo.dwNumberOfProcessors;
-    #else
-        #ifdef _SC_NPROCESSORS_ONLN
-            num_threads = sysconf(_SC_NPROCESSORS_ONLN);
-        #else
-            num_threads = sysconf(_SC_NPROCESSORS_CONF);
-        #endif
-    #endif
-    
-    // Fallback to at least 1 if detection failed
-    return (num_threads > 0) ? num_threads : 1;
-}
-
 // Convert RGBA uint32_t to float
 float rgba_to_float(uint32_t rgba) {
     // Extract the red channel (or use a more sophisticated conversion)
@@ -69,51 +74,325 @@ std::wstring to_wstring(const std::string& str) {
     return result;
 }
 
-// Structure to hold a temporal sequence of frames with pre-processed images
+// A temporal window into the shared frame array. Frames start, start + stride, ...,
+// start + (length - 1) * stride form the window, oldest first; no frame data is copied.
 struct TemporalSequence {
-    std::vector<AlignedFrame> frames;  // Changed to AlignedFrame to match what read_capture_file returns
-    bool is_valid;
-    // Pre-processed image data to avoid repeated JPEG decoding
-    std::vector<std::vector<float>> preprocessed_images;  // [frame_idx][pixel_data]
+    size_t start;
+    uint32_t stride;
+    uint32_t length;
+
+    size_t frameIndex(uint32_t j) const { return start + (size_t)j * stride; }
+    size_t lastFrameIndex() const { return frameIndex(length - 1); }
 };
 
-// Function to extract temporal sequences from frames - updated to use AlignedFrame
-std::vector<TemporalSequence> createTemporalSequences(const std::vector<AlignedFrame>& frames, int num_frames) {
+// Appends the windows starting in frames[begin, end) that fit before end, quietly
+void appendTemporalSequences(const std::vector<AlignedFrame>& frames, int num_frames, int stride,
+                             size_t begin, size_t end, std::vector<TemporalSequence>& sequences) {
+    end = std::min(end, frames.size());
+    const size_t span = (size_t)(num_frames - 1) * stride + 1;
+    for (size_t i = begin; i + span <= end; i++) {
+        TemporalSequence seq;
+        seq.start = i;
+        seq.stride = (uint32_t)stride;
+        seq.length = (uint32_t)num_frames;
+        
+        // Only keep windows whose most recent frame has FLAG_GOOD_DATA set
+        if (std::get<11>(frames[seq.lastFrameIndex()].label_data) & FLAG_GOOD_DATA) {
+            sequences.push_back(seq);
+        }
+    }
+}
+
+// Function to extract temporal sequences from frames[begin, end), e.g. one session
+std::vector<TemporalSequence> createTemporalSequences(const std::vector<AlignedFrame>& frames, int num_frames, int stride = 1,
+                                                      size_t begin = 0, size_t end = SIZE_MAX) {
     std::vector<TemporalSequence> sequences;
     
-    if (frames.size() < num_frames) {
+    end = std::min(end, frames.size());
+    const size_t span = (size_t)(num_frames - 1) * stride + 1;
+    if (end < begin + span) {
         printf("Not enough frames to create sequences\n");
         return sequences;
     }
     
-    for (size_t i = 0; i <= frames.size() - num_frames; i++) {
-        TemporalSequence seq;
-        
-        // Get the most recent frame first to check if it's safe
-        const auto& latest_frame = frames[i + num_frames - 1];
-        
-        // Check if the most recent frame has FLAG_GOOD_DATA set
-        if (std::get<11>(latest_frame.label_data) & FLAG_GOOD_DATA) {
-            seq.is_valid = true;
-            
-            // Collect all frames in the sequence
-            for (int j = 0; j < num_frames; j++) {
-                seq.frames.push_back(frames[i + j]);
+    sequences.reserve(end - begin - span + 1);
+    appendTemporalSequences(frames, num_frames, stride, begin, end, sequences);
+    
+    printf("Created %zu valid temporal sequences from %zu frames\n", 
+           sequences.size(), end - begin);
+    return sequences;
+}
+
+// Hold out the tail of each of VALIDATION_BLOCKS equal stretches of the capture as
+// validation windows. Contiguous blocks keep near-identical neighbouring frames from landing
+// in both sets while every stage of the routine stays represented. Training windows that
+// share any frame with a validation window are dropped as well.
+#define VALIDATION_BLOCKS 10
+
+void splitValidationSequences(std::vector<TemporalSequence>& sequences, size_t frame_count, float fraction,
+                              std::vector<TemporalSequence>& validation) {
+    validation.clear();
+    const size_t total = sequences.size();
+    if (fraction <= 0.0f || total < VALIDATION_BLOCKS) {
+        return;
+    }
+    
+    std::vector<uint8_t> held_out(total, 0);
+    for (size_t block = 0; block < VALIDATION_BLOCKS; block++) {
+        const size_t begin = total * block / VALIDATION_BLOCKS;
+        const size_t end = total * (block + 1) / VALIDATION_BLOCKS;
+        const size_t count = std::min(end - begin, (size_t)((end - begin) * fraction + 0.5f));
+        for (size_t i = end - count; i < end; i++) {
+            held_out[i] = 1;
+        }
+    }
+    
+    // used[f + 1] counts validation frames up to and including frame f
+    std::vector<size_t> used(frame_count + 1, 0);
+    for (size_t i = 0; i < total; i++) {
+        if (held_out[i]) {
+            for (size_t f = sequences[i].start; f <= sequences[i].lastFrameIndex(); f++) {
+                used[f + 1] = 1;
             }
-            
-            sequences.push_back(seq);
         }
     }
+    for (size_t f = 0; f < frame_count; f++) {
+        used[f + 1] += used[f];
+    }
     
-    printf("Created %zu valid temporal sequences from %zu frames\n", 
-           sequences.size(), frames.size());
-    return sequences;
+    std::vector<TemporalSequence> training;
+    for (size_t i = 0; i < total; i++) {
+        const TemporalSequence& seq = sequences[i];
+        if (held_out[i]) {
+            validation.push_back(seq);
+        } else if (used[seq.lastFrameIndex() + 1] == used[seq.start]) {
+            training.push_back(seq);
+        }
+    }
+    sequences.swap(training);
+}
+
+// A capture followed while it is recorded has no final length to divide into blocks, so
+// its hold-out is fixed by frame position instead: the tail of every
+// FOLLOW_VALIDATION_BLOCK frames. A window's side never changes as the capture grows,
+// which lets the online rounds leave the held-out frames alone from the start.
+#define FOLLOW_VALIDATION_BLOCK 600
+
+// Whether a window starting at frame start is held out
+static bool heldOutByPosition(size_t start, float fraction) {
+    const size_t tail = (size_t)(FOLLOW_VALIDATION_BLOCK * fraction + 0.5f);
+    return start % FOLLOW_VALIDATION_BLOCK >= FOLLOW_VALIDATION_BLOCK - std::min<size_t>(tail, FOLLOW_VALIDATION_BLOCK);
 }
 
-// Function to print parameter info and check for gradient flow
+// Whether a window may be trained on: neither held out nor sharing a frame with a
+// window that could be
+static bool trainableByPosition(const TemporalSequence& seq, float fraction) {
+    const size_t span = seq.lastFrameIndex() - seq.start + 1;
+    for (size_t start = seq.start >= span - 1 ? seq.start - (span - 1) : 0; start <= seq.lastFrameIndex(); start++) {
+        if (heldOutByPosition(start, fraction)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void splitValidationByPosition(std::vector<TemporalSequence>& sequences, float fraction,
+                               std::vector<TemporalSequence>& validation) {
+    validation.clear();
+    if (fraction <= 0.0f) {
+        return;
+    }
+    std::vector<TemporalSequence> training;
+    for (const TemporalSequence& seq : sequences) {
+        if (heldOutByPosition(seq.start, fraction)) {
+            validation.push_back(seq);
+        } else if (trainableByPosition(seq, fraction)) {
+            training.push_back(seq);
+        }
+    }
+    sequences.swap(training);
+}
+
+// Convert a frame's label data into the NUM_CLASSES training targets.
+// Returns false if any of them is not finite.
+bool extractTrainingLabels(const AlignedFrame& frame, float* labels) {
+    // Eye tracking parameters (pitch, yaw, distance) - excluding fovAdjustDistance
+    float pitch = ((std::get<0>(frame.label_data) / 32.0f) + 1.0f) / 2.0f;  // Convert from [-1,1] to [0,1]
+    float yaw = ((std::get<1>(frame.label_data) / 32.0f) + 1.0f) / 2.0f;    // Convert from [-1,1] to [0,1]
+    float distance = std::get<2>(frame.label_data);  // routineDistance
+    // Skip fovAdjustDistance (std::get<3>) - used for internal normalization only
+    
+    // Lid/brow parameters (routineLeftLid, routineRightLid, routineBrowRaise, routineBrowAngry, routineWiden, routineSquint)
+    float leftLid = std::get<4>(frame.label_data);     // routineLeftLid
+    float rightLid = std::get<5>(frame.label_data);    // routineRightLid
+    float browRaise = std::get<6>(frame.label_data);   // routineBrowRaise
+    float browAngry = std::get<7>(frame.label_data);   // routineBrowAngry
+    float widen = std::get<8>(frame.label_data);       // routineWiden
+    float squint = std::get<9>(frame.label_data);      // routineSquint
+    float dilate = std::get<10>(frame.label_data);     // routineDilate
+    
+    float all_params[NUM_CLASSES] = {pitch, yaw, distance, leftLid, rightLid, browRaise, browAngry, widen, squint, dilate};
+    bool valid = true;
+    for (int p = 0; p < NUM_CLASSES; p++) {
+        if (!std::isfinite(all_params[p])) {
+            valid = false;
+        }
+        labels[p] = all_params[p];
+    }
+    return valid;
+}
+
+// Fill one training sample from the frame cache: NUM_FRAMES x (left, right) planes, most
+// recent frame first, plus the labels of the most recent frame. Runs on batch loader
+// threads. With an augmenter the planes are augmented as they are converted, keyed by
+// stream and the window's last frame. Returns false if the labels are not usable.
+bool fillTrainingSample(const FrameTensorCache& cache, const TemporalSequence& sequence,
+                        float* images, float* labels,
+                        const PlaneAugmenter* augmenter = NULL, uint64_t stream = 0) {
+    // Use the last frame for labels (most recent)
+    const size_t last_frame = sequence.lastFrameIndex();
+    if (!cache.LabelsValid(last_frame)) {
+        return false;
+    }
+    memcpy(labels, cache.Labels(last_frame), NUM_CLASSES * sizeof(float));
+    
+    // Gather all frames in the sequence (most recent frame first), left then right plane
+    const uint8_t* planes[NUM_FRAMES * 2];
+    for (int frame_idx = 0; frame_idx < NUM_FRAMES; frame_idx++) {
+        const size_t frame = sequence.frameIndex(NUM_FRAMES - 1 - frame_idx);
+        planes[frame_idx * 2 + 0] = cache.Plane(frame, 0);
+        planes[frame_idx * 2 + 1] = cache.Plane(frame, 1);
+    }
+    if (augmenter != NULL) {
+        augmenter->GatherAugmentPlanes(planes, NUM_FRAMES * 2, 2, stream, last_frame, images);
+    } else {
+        GatherNormalizePlanes(planes, NUM_FRAMES * 2, cache.GetPlaneSize(), 1.0f / 255.0f, images);
+    }
+    
+    return true;
+}
+
+// Write evenly spaced windows from candidates as uint8 planes [count, 2 * NUM_FRAMES, R, R]
+// in fillTrainingSample's order, plus their labels unless labels_path is empty. Windows
+// with unusable labels are skipped. Returns the number written.
+size_t saveSampleWindows(const FrameTensorCache& cache, const std::vector<TemporalSequence>& sequences,
+                         const std::vector<size_t>& candidates, size_t count,
+                         const std::string& images_path, const std::string& labels_path) {
+    const size_t plane_size = cache.GetPlaneSize();
+    const size_t step = std::max<size_t>(1, candidates.size() / std::max<size_t>(count, 1));
+    std::vector<uint8_t> images;
+    std::vector<float> labels;
+    size_t written = 0;
+    
+    for (size_t i = 0; i < candidates.size() && written < count; i += step) {
+        const TemporalSequence& sequence = sequences[candidates[i]];
+        const size_t last_frame = sequence.lastFrameIndex();
+        if (!cache.LabelsValid(last_frame)) {
+            continue;
+        }
+        for (int frame_idx = 0; frame_idx < NUM_FRAMES; frame_idx++) {
+            const size_t frame = sequence.frameIndex(NUM_FRAMES - 1 - frame_idx);
+            images.insert(images.end(), cache.Plane(frame, 0), cache.Plane(frame, 0) + plane_size);
+            images.insert(images.end(), cache.Plane(frame, 1), cache.Plane(frame, 1) + plane_size);
+        }
+        labels.insert(labels.end(), cache.Labels(last_frame), cache.Labels(last_frame) + NUM_CLASSES);
+        written++;
+    }
+    
+    const size_t resolution = (size_t)cache.GetResolution();
+    if (!NumPyIO::SaveArrayToNumpy(images_path, images.data(), {written, 2 * NUM_FRAMES, resolution, resolution},
+                                   NumPyDataType::UINT8) ||
+        (!labels_path.empty() && !NumPyIO::SaveFloatArrayToNumpy(labels_path, labels.data(), {written, NUM_CLASSES}))) {
+        return 0;
+    }
+    return written;
+}
+
+// Wrap caller-owned floats in an OrtValue without copying. Returns NULL on error.
+OrtValue* createFloatTensorView(const OrtApi* g_ort_api, const OrtMemoryInfo* memory_info,
+                                float* data, const int64_t* shape, size_t rank) {
+    size_t element_count = 1;
+    for (size_t i = 0; i < rank; i++) {
+        element_count *= (size_t)shape[i];
+    }
+    
+    OrtValue* tensor = NULL;
+    OrtStatus* status = g_ort_api->CreateTensorWithDataAsOrtValue(
+        memory_info,
+        data,
+        element_count * sizeof(float),
+        shape,
+        rank,
+        ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT,
+        &tensor
+    );
+    
+    if (status != NULL) {
+        const char* error_message = g_ort_api->GetErrorMessage(status);
+        fprintf(stderr, "Error creating tensor: %s\n", error_message);
+        g_ort_api->ReleaseStatus(status);
+        return NULL;
+    }
+    return tensor;
+}
+
+// Input and label tensors bound to one pooled batch buffer, one pair for each batch size
+// that occurs: full batches and the ragged last batches of the training and validation passes
+struct BatchTensorViews {
+    std::vector<size_t> sizes;
+    std::vector<OrtValue*> inputs;
+    std::vector<OrtValue*> labels;
+};
+
+void releaseBatchTensorViews(const OrtApi* g_ort_api, BatchTensorViews& views) {
+    for (size_t i = 0; i < views.sizes.size(); i++) {
+        if (views.inputs[i] != NULL) {
+            g_ort_api->ReleaseValue(views.inputs[i]);
+        }
+        if (views.labels[i] != NULL) {
+            g_ort_api->ReleaseValue(views.labels[i]);
+        }
+    }
+    views.sizes.clear();
+    views.inputs.clear();
+    views.labels.clear();
+}
+
+// Zero and duplicate sizes are skipped
+bool createBatchTensorViews(const OrtApi* g_ort_api, const OrtMemoryInfo* memory_info, TrainingBatch& batch,
+                            const std::vector<size_t>& sizes, BatchTensorViews& views) {
+    for (size_t size : sizes) {
+        if (size == 0 || std::find(views.sizes.begin(), views.sizes.end(), size) != views.sizes.end()) {
+            continue;
+        }
+        const int64_t input_shape[] = {(int64_t)size, 2 * NUM_FRAMES, TRAIN_RESOLUTION, TRAIN_RESOLUTION};
+        const int64_t label_shape[] = {(int64_t)size, NUM_CLASSES};
+        views.sizes.push_back(size);
+        views.inputs.push_back(createFloatTensorView(g_ort_api, memory_info, batch.images.data(), input_shape, 4));
+        views.labels.push_back(createFloatTensorView(g_ort_api, memory_info, batch.labels.data(), label_shape, 2));
+        if (views.inputs.back() == NULL || views.labels.back() == NULL) {
+            releaseBatchTensorViews(g_ort_api, views);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Tensors bound for a batch of count samples; false if that size was not bound
+bool findBatchTensors(const BatchTensorViews& views, size_t count, OrtValue*& input, OrtValue*& label) {
+    for (size_t i = 0; i < views.sizes.size(); i++) {
+        if (views.sizes[i] == count) {
+            input = views.inputs[i];
+            label = views.labels[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+// Prints trainable and frozen parameter counts; values are left to TrainingTelemetry
 void printParameterInfo(OrtTrainingSession* training_session, const OrtApi* g_ort_api, 
-                       const OrtTrainingApi* g_ort_training_api, 
-                       std::vector<float>* prev_params = nullptr) {
+                       const OrtTrainingApi* g_ort_training_api) {
     
     // Get size of all parameters (both trainable and non-trainable)
     size_t all_params_size = 0;
@@ -144,124 +423,368 @@ void printParameterInfo(OrtTrainingSession* training_session, const OrtApi* g_or
            (float)trainable_params_size / all_params_size * 100.0f);
     printf("Frozen parameters: %zu (%.2f%%)\n", non_trainable_params_size, 
            (float)non_trainable_params_size / all_params_size * 100.0f);
+    printf("================================\n");
+}
+
+// Sizes ORT's thread pools from the plan and, when it is pinned, gives the intra-op pool
+// threads their CPUs. The training thread runs its own share of every parallel section
+// on the first one, which the pool threads leave free.
+void configureOrtThreads(const OrtApi* g_ort_api, OrtSessionOptions* session_options, const ThreadPlan& plan) {
+    g_ort_api->SetIntraOpNumThreads(session_options, plan.intraOpThreads);
+    g_ort_api->SetInterOpNumThreads(session_options, plan.interOpThreads);
     
-    // Create memory info for parameter tensor
-    OrtMemoryInfo* memory_info = nullptr;
-    status = g_ort_api->CreateCpuMemoryInfo(OrtArenaAllocator, OrtMemTypeDefault, &memory_info);
-    if (status != NULL) {
-        const char* error_message = g_ort_api->GetErrorMessage(status);
-        fprintf(stderr, "Error creating memory info: %s\n", error_message);
-        g_ort_api->ReleaseStatus(status);
-        return;
+    const std::string affinities = plan.IntraOpAffinities();
+    if (!affinities.empty()) {
+        OrtStatus* status = g_ort_api->AddSessionConfigEntry(session_options, "session.intra_op_thread_affinities",
+                                                             affinities.c_str());
+        if (status != NULL) {
+            fprintf(stderr, "Could not pin the ORT threads: %s\n", g_ort_api->GetErrorMessage(status));
+            g_ort_api->ReleaseStatus(status);
+        }
     }
-    
-    // Get current parameter values
-    std::vector<float> current_params(trainable_params_size);
-    const int64_t shape[] = {(int64_t)trainable_params_size};
-    OrtValue* params_tensor = nullptr;
-    
-    status = g_ort_api->CreateTensorWithDataAsOrtValue(
-        memory_info,
-        current_params.data(),
-        current_params.size() * sizeof(float),
-        shape,
-        1,
-        ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT,
-        &params_tensor
-    );
-    
-    if (status != NULL) {
-        const char* error_message = g_ort_api->GetErrorMessage(status);
-        fprintf(stderr, "Error creating parameter tensor: %s\n", error_message);
-        g_ort_api->ReleaseStatus(status);
-        g_ort_api->ReleaseMemoryInfo(memory_info);
-        return;
+    if (plan.pinned && !plan.intraOpCpus.empty()) {
+        PinCurrentThread(std::vector<int>(1, plan.intraOpCpus[0]));
     }
+    printf("Using %d intra-op and %d inter-op CPU threads\n", plan.intraOpThreads, plan.interOpThreads);
+}
+
+// Loads the capture, trains and exports the model. Returns the process exit code.
+int runTraining(const TrainerOptions& options, ProgressChannelWriter& progress, PhaseProfiler& profiler,
+                MemoryTracker& memory) {
+    printf("Batch assembly kernel: %s\n", KernelLevelName(GetKernelLevel()));
     
-    // Copy parameters to our buffer
-    status = g_ort_training_api->CopyParametersToBuffer(
-        training_session,
-        params_tensor,
-        true  // Only trainable parameters
-    );
+    const std::string& onnx_model_path = options.outputModel;
     
-    if (status != NULL) {
-        const char* error_message = g_ort_api->GetErrorMessage(status);
-        fprintf(stderr, "Error copying parameters to buffer: %s\n", error_message);
-        g_ort_api->ReleaseStatus(status);
-        g_ort_api->ReleaseValue(params_tensor);
-        g_ort_api->ReleaseMemoryInfo(memory_info);
-        return;
+    // Every capture is one session; patterns are expanded here so they also work where
+    // the shell does not expand them
+    std::vector<std::string> capture_files;
+    std::vector<std::string> capture_patterns(1, options.captureFile);
+    capture_patterns.insert(capture_patterns.end(), options.extraCaptures.begin(), options.extraCaptures.end());
+    for (const std::string& pattern : capture_patterns) {
+        std::vector<std::string> matched = ExpandCapturePattern(pattern);
+        if (matched.empty()) {
+            fprintf(stderr, "No capture files match %s\n", pattern.c_str());
+            return 1;
+        }
+        capture_files.insert(capture_files.end(), matched.begin(), matched.end());
     }
-    
-    // Print sample of parameters
-    printf("Parameter samples: ");
-    for (size_t i = 0; i < 5 && i < trainable_params_size; i++) {
-        printf("%g ", current_params[i]);
+    if (options.follow && capture_files.size() != 1) {
+        fprintf(stderr, "--follow trains on a single capture, got %zu\n", capture_files.size());
+        return 1;
     }
-    printf("...\n");
-    
-    // Check if parameters have changed from previous values
-    if (prev_params != nullptr && prev_params->size() == trainable_params_size) {
-        float total_diff = 0.0f;
-        int changed_count = 0;
-        
-        for (size_t i = 0; i < trainable_params_size; i++) {
-            float diff = std::abs(current_params[i] - (*prev_params)[i]);
-            total_diff += diff;
-            if (diff > 1e-6) {
-                changed_count++;
-            }
-        }
-        
-        printf("Gradient movement: %g (%.2f%% of parameters changed)\n", 
-               total_diff, (float)changed_count / trainable_params_size * 100.0f);
-        
-        // Update previous parameters
-        *prev_params = current_params;
-    } else if (prev_params != nullptr) {
-        // First time storing parameters
-        *prev_params = current_params;
+    if (!options.sessionWeights.empty() && options.sessionWeights.size() != capture_files.size()) {
+        fprintf(stderr, "--session-weights has %zu weights for %zu captures\n",
+                options.sessionWeights.size(), capture_files.size());
+        return 1;
     }
+    const std::string& capture_file = capture_files[0];
     
-    // Clean up
-    g_ort_api->ReleaseValue(params_tensor);
-    g_ort_api->ReleaseMemoryInfo(memory_info);
+    // Heap bytes of the aligned frames, for the memory report
+    std::vector<AlignedFrame> frames;
+    auto capture_bytes = [&frames]() {
+        size_t bytes = frames.capacity() * sizeof(AlignedFrame);
+        for (const AlignedFrame& frame : frames) {
+            bytes += frame.GetMemoryBytes();
+        }
+        return bytes;
+    };
     
-    printf("================================\n");
-}
-
-int main(int argc, char* argv[]) {
-    // Default file paths
-    std::string capture_file = "capture(2).bin";
-    std::string onnx_model_path = "tuned_temporal_eye_tracking.onnx";
+    // Thread budgets planned in main from the CPU topology
+    const ThreadPlan& thread_plan = GetThreadPlan();
+    const int loader_workers = thread_plan.loaderWorkers;
+    const size_t decode_workers = (size_t)thread_plan.decodeWorkers;
     
-    // Check if command line arguments are provided
-    if (argc >= 2) {
-        capture_file = argv[1];  // First argument is the capture file
-    }
+    // Decode every frame once at training resolution; windows and epochs share the result.
+    // The sessions follow each other in frames and the cache, session_starts holding the
+    // first frame of each.
+    FrameTensorCache frame_cache;
+    std::vector<size_t> session_starts;
+    double bake_seconds = 0.0;
     
-    if (argc >= 3) {
-        onnx_model_path = argv[2];   // Second argument is the output file
+    // In follow mode the capture is still being recorded: start from what is there and
+    // pick up the rest while training
+    CaptureFollower follower;
+    if (options.follow) {
+        if (!follower.Open(capture_file)) {
+            fprintf(stderr, "Failed to open capture file: %s\n", capture_file.c_str());
+            return 1;
+        }
+        follower.Poll(frames);
+        session_starts.push_back(0);
+        
+        auto bake_start_time = std::chrono::steady_clock::now();
+        frame_cache.Build(frames, TRAIN_RESOLUTION, NUM_CLASSES, extractTrainingLabels, decode_workers,
+                          options.resampleMode);
+        bake_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - bake_start_time).count();
+        profiler.Record(TrainerPhase::Decode, bake_seconds, frame_cache.GetFrameCount());
+    } else {
+        // The reader holds every record in its maps while aligning and then copies the
+        // images into the frames, so it peaks at about three times the file size
+        std::vector<size_t> read_peaks;
+        for (const std::string& file : capture_files) {
+            std::ifstream capture_stream(file, std::ios::binary | std::ios::ate);
+            read_peaks.push_back(capture_stream ? (size_t)capture_stream.tellg() * 3 : 0);
+        }
+        
+        // Each file is read while the previous session is decoded when the budget has room
+        // for both, and after it otherwise. JPEG payloads are dropped once decoded, so at
+        // most two sessions are ever held as JPEG.
+        CaptureSetReader capture_reader(capture_files);
+        std::vector<AlignedFrame> session_frames;
+        CaptureReadTiming read_timing;
+        printf("Loading %zu capture file%s\n", capture_files.size(), capture_files.size() == 1 ? "" : "s");
+        while (capture_reader.GetFilesRead() < capture_files.size()) {
+            const size_t file_index = capture_reader.GetFilesRead();
+            if (!capture_reader.IsReading() &&
+                !memory.Reserve(("reading " + capture_files[file_index]).c_str(), read_peaks[file_index])) {
+                return 1;
+            }
+            capture_reader.Next(session_frames, read_timing);
+            profiler.Record(TrainerPhase::ReadCapture, read_timing.readSeconds, session_frames.size());
+            profiler.Record(TrainerPhase::Align, read_timing.alignSeconds, session_frames.size());
+            if (session_frames.empty()) {
+                fprintf(stderr, "No frames loaded from capture file %s\n", capture_reader.GetFile().c_str());
+                return 1;
+            }
+            printf("Loaded %zu frames from %s\n", session_frames.size(), capture_reader.GetFile().c_str());
+            // The cache grows by this session's chunks; the label arrays and the frame list
+            // are copied as they grow, so their old and new storage briefly coexist
+            const size_t append_bytes =
+                FrameTensorCache::GetAppendBytes(frames.size(), session_frames.size(), TRAIN_RESOLUTION, NUM_CLASSES) +
+                (frames.size() + session_frames.size()) * sizeof(AlignedFrame);
+            if (!memory.Reserve("the frame cache", append_bytes)) {
+                return 1;
+            }
+            
+            // The read ahead runs alongside the decode, so its peak counts on top of the cache
+            const size_t next_file = file_index + 1;
+            if (next_file < capture_files.size()) {
+                if (memory.Fits(append_bytes + read_peaks[next_file])) {
+                    capture_reader.ReadAhead();
+                } else {
+                    printf("Reading %s after this session is decoded to stay within the memory budget\n",
+                           capture_files[next_file].c_str());
+                }
+            }
+            
+            const size_t first_frame = frames.size();
+            session_starts.push_back(first_frame);
+            frames.reserve(first_frame + session_frames.size());
+            frames.insert(frames.end(), std::make_move_iterator(session_frames.begin()),
+                          std::make_move_iterator(session_frames.end()));
+            session_frames.clear();
+            
+            auto bake_start_time = std::chrono::steady_clock::now();
+            if (first_frame == 0) {
+                frame_cache.Build(frames, TRAIN_RESOLUTION, NUM_CLASSES, extractTrainingLabels, decode_workers,
+                                  options.resampleMode);
+            } else {
+                frame_cache.Append(frames, decode_workers);
+            }
+            const double session_bake_seconds =
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - bake_start_time).count();
+            profiler.Record(TrainerPhase::Decode, session_bake_seconds, frames.size() - first_frame);
+            bake_seconds += session_bake_seconds;
+            
+            for (size_t i = first_frame; i < frames.size(); i++) {
+                std::vector<uint8_t>().swap(frames[i].left_image);
+                std::vector<uint8_t>().swap(frames[i].right_image);
+            }
+            memory.Set(MemoryCategory::Capture, capture_bytes());
+            memory.Set(MemoryCategory::FrameCache, frame_cache.GetMemoryBytes());
+            if (!memory.Snapshot("session " + std::to_string(session_starts.size()))) {
+                return 1;
+            }
+        }
     }
-    
-    printf("Loading capture file: %s\n", capture_file.c_str());
-    
-    // Load the capture file
-    auto frames = read_capture_file(capture_file);
-    
-    if (frames.empty()) {
-        fprintf(stderr, "No frames loaded from capture file\n");
+    memory.Set(MemoryCategory::Capture, capture_bytes());
+    memory.Set(MemoryCategory::FrameCache, frame_cache.GetMemoryBytes());
+    if (!memory.Snapshot("decode")) {
         return 1;
     }
+    printf("Baked %zu frames at %dx%d (%s, %.1f MB) in %.2fs\n", frame_cache.GetFrameCount(),
+           TRAIN_RESOLUTION, TRAIN_RESOLUTION, ResampleModeName(options.resampleMode),
+           frame_cache.GetMemoryBytes() / (1024.0 * 1024.0), bake_seconds);
     
-    printf("Loaded %zu frames from capture file\n", frames.size());
-    
-    // Create temporal sequences
-    auto sequences = createTemporalSequences(frames, NUM_FRAMES);
+    // Augmentation of training windows on the loader threads. augment_stream changes
+    // every epoch (and online round) so each pass sees different augmentations.
+    std::unique_ptr<PlaneAugmenter> augmenter;
+    std::atomic<uint64_t> augment_stream(0);
+    if (options.augment.enabled) {
+        augmenter.reset(new PlaneAugmenter(options.augment, TRAIN_RESOLUTION, 1.0f / 255.0f));
+        printf("Augmentation: brightness %.2f, gamma %.2f, noise %.1f, shift %d px, blur %.0f%%, seed %llu\n",
+               options.augment.brightness, options.augment.gamma, options.augment.noise, options.augment.shift,
+               options.augment.blur * 100.0f, (unsigned long long)options.augment.seed);
+    }
     
-    if (sequences.empty()) {
-        fprintf(stderr, "No valid temporal sequences created\n");
+    // Training windows of the complete capture: sequences holds the training windows, then
+    // the validation windows, then the replay windows. Runs before training, or once the
+    // capture is complete in follow mode. Returns false if nothing is left to train on.
+    std::vector<TemporalSequence> sequences;
+    size_t num_train_sequences = 0;
+    bool has_validation = false;
+    size_t replay_begin = 0;
+    size_t replay_per_epoch = 0;
+    auto prepare_windows = [&]() {
+        // Create temporal sequences per session so none spans two recordings
+        const size_t session_frames_end = frames.size();
+        auto session_end = [&](size_t session) {
+            return session + 1 < session_starts.size() ? session_starts[session + 1] : session_frames_end;
+        };
+        sequences.clear();
+        for (size_t session = 0; session < session_starts.size(); session++) {
+            std::vector<TemporalSequence> session_sequences =
+                createTemporalSequences(frames, NUM_FRAMES, 1, session_starts[session], session_end(session));
+            sequences.insert(sequences.end(), session_sequences.begin(), session_sequences.end());
+        }
+        
+        if (sequences.empty()) {
+            fprintf(stderr, "No valid temporal sequences created\n");
+            return false;
+        }
+        
+        // Older capture replayed during fine-tuning. Its frames go after the new capture's
+        // and its windows are built separately so none spans both recordings.
+        std::vector<TemporalSequence> replay_sequences;
+        if (!options.replayCapture.empty()) {
+            CaptureReadTiming read_timing;
+            auto replay_frames = read_capture_file(options.replayCapture, &read_timing);
+            profiler.Record(TrainerPhase::ReadCapture, read_timing.readSeconds, replay_frames.size());
+            profiler.Record(TrainerPhase::Align, read_timing.alignSeconds, replay_frames.size());
+            replay_sequences = createTemporalSequences(replay_frames, NUM_FRAMES);
+            for (TemporalSequence& seq : replay_sequences) {
+                seq.start += frames.size();
+            }
+            frames.insert(frames.end(), std::make_move_iterator(replay_frames.begin()),
+                          std::make_move_iterator(replay_frames.end()));
+            {
+                ScopedPhase phase(profiler, TrainerPhase::Decode, frames.size() - frame_cache.GetFrameCount());
+                frame_cache.Append(frames, decode_workers);
+            }
+            printf("Replay capture %s: %zu windows\n", options.replayCapture.c_str(), replay_sequences.size());
+        }
+        if (frame_cache.GetDecodeFailures() > 0) {
+            printf("WARNING: %zu eye images failed to decode and were left black\n", frame_cache.GetDecodeFailures());
+        }
+        
+        // Drop windows whose labels are not finite
+        size_t invalid_sequences = 0;
+        auto labels_invalid = [&](const TemporalSequence& seq) {
+            bool invalid = !frame_cache.LabelsValid(seq.lastFrameIndex());
+            invalid_sequences += invalid ? 1 : 0;
+            return invalid;
+        };
+        sequences.erase(std::remove_if(sequences.begin(), sequences.end(), labels_invalid), sequences.end());
+        replay_sequences.erase(std::remove_if(replay_sequences.begin(), replay_sequences.end(), labels_invalid),
+                               replay_sequences.end());
+        if (invalid_sequences > 0) {
+            printf("ERROR: Skipping %zu sequences with invalid label values\n", invalid_sequences);
+        }
+        if (sequences.empty()) {
+            fprintf(stderr, "No valid temporal sequences created\n");
+            return false;
+        }
+        
+        // The JPEG payloads are no longer needed
+        for (auto& frame : frames) {
+            std::vector<uint8_t>().swap(frame.left_image);
+            std::vector<uint8_t>().swap(frame.right_image);
+        }
+        
+        // Hold out time blocks of every session for validation. The validation windows are
+        // appended after the training windows so one batch loader serves both passes.
+        std::vector<TemporalSequence> validation_sequences;
+        const size_t candidate_sequences = sequences.size();
+        std::vector<TemporalSequence> training_sequences;
+        auto session_begin = sequences.begin();
+        for (size_t session = 0; session < session_starts.size(); session++) {
+            auto session_stop = std::partition_point(session_begin, sequences.end(),
+                [&](const TemporalSequence& seq) { return seq.start < session_end(session); });
+            std::vector<TemporalSequence> session_training(session_begin, session_stop);
+            std::vector<TemporalSequence> session_validation;
+            if (options.follow) {
+                splitValidationByPosition(session_training, options.validationFraction, session_validation);
+            } else {
+                splitValidationSequences(session_training, frames.size(), options.validationFraction, session_validation);
+            }
+            training_sequences.insert(training_sequences.end(), session_training.begin(), session_training.end());
+            validation_sequences.insert(validation_sequences.end(), session_validation.begin(), session_validation.end());
+            session_begin = session_stop;
+        }
+        sequences.swap(training_sequences);
+        num_train_sequences = sequences.size();
+        has_validation = !validation_sequences.empty();
+        if (has_validation) {
+            printf("Validation split: %zu training, %zu validation windows (%zu dropped at block edges)\n",
+                   num_train_sequences, validation_sequences.size(),
+                   candidate_sequences - num_train_sequences - validation_sequences.size());
+        } else {
+            printf("Validation disabled, selecting the best checkpoint by training loss\n");
+        }
+        
+        // Drop training windows that nearly repeat the one kept before them (rests and holds)
+        if (options.dedupThreshold > 0.0f && !sequences.empty()) {
+            auto dedup_start = std::chrono::steady_clock::now();
+            FrameSignatures signatures;
+            signatures.Build(frame_cache, decode_workers);
+            std::vector<size_t> first_frames(sequences.size());
+            std::vector<size_t> last_frames(sequences.size());
+            for (size_t i = 0; i < sequences.size(); i++) {
+                first_frames[i] = sequences[i].frameIndex(0);
+                last_frames[i] = sequences[i].lastFrameIndex();
+            }
+            DedupStats dedup_stats;
+            std::vector<char> keep = PruneNearDuplicates(frame_cache, signatures, first_frames, last_frames,
+                options.dedupThreshold, options.dedupLabelTolerance, options.dedupKeepEvery, dedup_stats);
+            
+            size_t class_before[STAGE_CLASS_COUNT] = {};
+            size_t class_after[STAGE_CLASS_COUNT] = {};
+            size_t kept_count = 0;
+            for (size_t i = 0; i < sequences.size(); i++) {
+                const int stage_class = (int)ClassifyStage(frames[last_frames[i]]);
+                class_before[stage_class]++;
+                if (keep[i]) {
+                    class_after[stage_class]++;
+                    sequences[kept_count++] = sequences[i];
+                }
+            }
+            sequences.resize(kept_count);
+            num_train_sequences = sequences.size();
+            
+            std::chrono::duration<double> dedup_duration = std::chrono::steady_clock::now() - dedup_start;
+            printf("Near-duplicate pruning: removed %zu of %zu training windows (%.1f%%) in %.2fs\n",
+                   dedup_stats.removed, dedup_stats.windows,
+                   dedup_stats.windows > 0 ? 100.0 * dedup_stats.removed / dedup_stats.windows : 0.0,
+                   dedup_duration.count());
+            printf("  image threshold %.1f levels, label tolerance %g (largest label change pruned: %g)\n",
+                   options.dedupThreshold, options.dedupLabelTolerance, dedup_stats.maxLabelDistance);
+            for (int c = 0; c < STAGE_CLASS_COUNT; c++) {
+                if (class_before[c] > 0) {
+                    printf("  %-12s %8zu -> %zu\n", StageClassName((StageClass)c), class_before[c], class_after[c]);
+                }
+            }
+        }
+        if (num_train_sequences == 0) {
+            fprintf(stderr, "No training sequences left after the validation split\n");
+            return false;
+        }
+        sequences.insert(sequences.end(), validation_sequences.begin(), validation_sequences.end());
+        
+        // Replay windows come last; each epoch draws a fresh random subset of them
+        replay_begin = sequences.size();
+        sequences.insert(sequences.end(), replay_sequences.begin(), replay_sequences.end());
+        replay_per_epoch = std::min(replay_sequences.size(),
+            (size_t)(num_train_sequences * options.replayFraction / (1.0f - options.replayFraction) + 0.5f));
+        if (!replay_sequences.empty()) {
+            printf("Replaying %zu of %zu older windows per epoch\n", replay_per_epoch, replay_sequences.size());
+        }
+        
+        memory.Set(MemoryCategory::Capture, capture_bytes());
+        memory.Set(MemoryCategory::FrameCache, frame_cache.GetMemoryBytes());
+        memory.Set(MemoryCategory::Windows, sequences.capacity() * sizeof(TemporalSequence));
+        return memory.Snapshot("windows");
+    };
+    if (!options.follow && !prepare_windows()) {
         return 1;
     }
     
@@ -325,12 +848,7 @@ int main(int argc, char* argv[]) {
         
         printf("DEBUG: Setting up CPU threading...\n");
         fflush(stdout);
-        uint32_t threads = get_cpu_thread_count() - 1;  // Leave one core free
-        if(threads < 1) threads = 1;
-        
-        g_ort_api->SetIntraOpNumThreads(session_options, threads);
-        g_ort_api->SetInterOpNumThreads(session_options, threads);
-        printf("Using %u CPU threads\n", threads);
+        configureOrtThreads(g_ort_api, session_options, thread_plan);
     } else {
         printf("Using CUDA GPU acceleration\n");
     }
@@ -341,12 +859,7 @@ int main(int argc, char* argv[]) {
     
     printf("DEBUG: Setting up CPU threading...\n");
     fflush(stdout);
-    uint32_t threads = get_cpu_thread_count() - 1;  // Leave one core free
-    if(threads < 1) threads = 1;
-    
-    g_ort_api->SetIntraOpNumThreads(session_options, threads);
-    g_ort_api->SetInterOpNumThreads(session_options, threads);
-    printf("Using %u CPU threads\n", threads);
+    configureOrtThreads(g_ort_api, session_options, thread_plan);
 #endif
     printf("DEBUG: Execution provider setup complete\n");
     fflush(stdout);
@@ -357,6 +870,13 @@ int main(int argc, char* argv[]) {
     std::string eval_model_path = "onnx_artifacts/training/eval_model.onnx";
     std::string optimizer_model_path = "onnx_artifacts/training/optimizer_model.onnx";
     
+    // Warm start from the user's previous checkpoint when given. The graphs stay the same,
+    // so the export below is unchanged.
+    if (!options.resumeCheckpoint.empty()) {
+        checkpoint_path = options.resumeCheckpoint;
+        printf("Resuming from checkpoint: %s%s\n", checkpoint_path.c_str(), options.fineTune ? " (fine-tuning)" : "");
+    }
+    
     // Load checkpoint
     OrtCheckpointState* checkpoint_state = NULL;
     status = g_ort_training_api->LoadCheckpoint(to_wstring(checkpoint_path).c_str(), &checkpoint_state);
@@ -403,15 +923,32 @@ int main(int argc, char* argv[]) {
     printf("Training session created successfully!\n");
     fflush(stdout);
     
-    // Vector to track parameter changes
-    std::vector<float> previous_params;
+    // Parameters and gradients plus the two AdamW moments of every trainable parameter.
+    // Activations live in ORT's arenas and show up as untracked.
+    size_t session_params = 0;
+    size_t session_trainable = 0;
+    OrtStatus* size_status = g_ort_training_api->GetParametersSize(training_session, &session_params, false);
+    if (size_status == NULL) {
+        size_status = g_ort_training_api->GetParametersSize(training_session, &session_trainable, true);
+    }
+    if (size_status != NULL) {
+        g_ort_api->ReleaseStatus(size_status);
+    }
+    memory.Set(MemoryCategory::OrtState, (session_params + 3 * session_trainable) * sizeof(float));
+    if (!memory.Snapshot("session")) {
+        g_ort_training_api->ReleaseTrainingSession(training_session);
+        g_ort_training_api->ReleaseCheckpointState(checkpoint_state);
+        g_ort_api->ReleaseSessionOptions(session_options);
+        g_ort_api->ReleaseEnv(env);
+        return 1;
+    }
     
     // Print initial parameter info
     printf("Initial parameter information:\n");
-    printParameterInfo(training_session, g_ort_api, g_ort_training_api, &previous_params);
+    printParameterInfo(training_session, g_ort_api, g_ort_training_api);
     
     // Set learning rate
-    float learning_rate = 1e-4f;  // Match the learning rate from Python trainer
+    float learning_rate = options.learningRate;  // 1e-4 by default, matching the Python trainer
     status = g_ort_training_api->SetLearningRate(training_session, learning_rate);
     if (status != NULL) {
         const char* error_message = g_ort_api->GetErrorMessage(status);
@@ -446,323 +983,702 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
-    // Create indices for shuffling
-    std::vector<size_t> indices(sequences.size());
-    std::iota(indices.begin(), indices.end(), 0);  // Fill with 0, 1, 2, ...
+    // Micro-batch per TrainStep (16 matches the Python trainer). Gradients of
+    // accumulate_steps micro-batches are summed before each OptimizerStep, so the effective
+    // batch grows without growing ORT's activation memory. AdamW normalises the update by
+    // the gradient's magnitude, so the sum needs no rescaling to a mean.
+    const size_t batch_size = (size_t)options.batchSize;
+    const int accumulate_steps = options.accumulateSteps;
+    const size_t sample_image_floats = 2 * NUM_FRAMES * TRAIN_RESOLUTION * TRAIN_RESOLUTION;
+    
+    // Online phase: while the capture is still being recorded, train rounds on random
+    // windows of everything aligned so far, outside the validation hold-out, at the base
+    // learning rate. Only the regular (short) schedule over the complete capture remains
+    // once the routine has ended.
+    if (options.follow) {
+        printf("Online training while %s is recorded\n", capture_file.c_str());
+        std::vector<TemporalSequence> online_sequences;
+        size_t online_next_start = 0;  // first window start not yet considered
+        BatchLoader online_loader(sample_image_floats, NUM_CLASSES, batch_size, loader_workers, options.prefetchBatches,
+            [&frame_cache, &online_sequences, &augmenter, &augment_stream](size_t sample, float* images, float* labels) {
+                return fillTrainingSample(frame_cache, online_sequences[sample], images, labels,
+                                          augmenter.get(), augment_stream.load());
+            });
+        memory.Set(MemoryCategory::Batches, online_loader.GetMemoryBytes());
+        std::vector<BatchTensorViews> online_views(online_loader.GetPoolSize());
+        for (size_t slot = 0; slot < online_views.size(); slot++) {
+            createBatchTensorViews(g_ort_api, memory_info, online_loader.GetPoolBatch(slot), {batch_size}, online_views[slot]);
+        }
+        float online_loss = 0.0f;
+        const int64_t online_loss_shape[] = {1};  // unused for a scalar
+        OrtValue* online_loss_tensor = createFloatTensorView(g_ort_api, memory_info, &online_loss, online_loss_shape, 0);
+        
+        std::mt19937 online_rng(std::random_device{}());
+        std::vector<size_t> online_indices;
+        auto online_start_time = std::chrono::steady_clock::now();
+        int online_rounds = 0;
+        size_t online_steps = 0;
+        bool memory_exceeded = false;
+        
+        // Epoch 0 marks the online phase; it also tells the overlay that training is under way
+        ProgressRecord online_started;
+        online_started.event = (uint8_t)ProgressEvent::EpochStarted;
+        online_started.totalEpochs = options.epochs;
+        progress.Send(online_started);
+        
+        while (online_loss_tensor != NULL) {
+            const size_t first_new = frames.size();
+            follower.Poll(frames);
+            if (frames.size() > first_new) {
+                {
+                    ScopedPhase phase(profiler, TrainerPhase::Decode, frames.size() - first_new);
+                    frame_cache.Append(frames, decode_workers);
+                }
+                for (size_t i = first_new; i < frames.size(); i++) {
+                    std::vector<uint8_t>().swap(frames[i].left_image);
+                    std::vector<uint8_t>().swap(frames[i].right_image);
+                }
+                // Only windows that now fit are new; earlier ones stay as they are
+                const size_t known_sequences = online_sequences.size();
+                appendTemporalSequences(frames, NUM_FRAMES, 1, online_next_start, frames.size(), online_sequences);
+                online_next_start = std::max(online_next_start, frames.size() - std::min<size_t>(frames.size(), NUM_FRAMES - 1));
+                online_sequences.erase(std::remove_if(online_sequences.begin() + known_sequences, online_sequences.end(),
+                    [&](const TemporalSequence& seq) {
+                        return !frame_cache.LabelsValid(seq.lastFrameIndex()) ||
+                               (options.validationFraction > 0.0f && !trainableByPosition(seq, options.validationFraction));
+                    }),
+                    online_sequences.end());
+                
+                memory.Set(MemoryCategory::Capture, capture_bytes());
+                memory.Set(MemoryCategory::FrameCache, frame_cache.GetMemoryBytes());
+                memory.Set(MemoryCategory::Windows, online_sequences.capacity() * sizeof(TemporalSequence));
+                if (!memory.Check("online round " + std::to_string(online_rounds + 1))) {
+                    memory_exceeded = true;
+                    break;
+                }
+            }
+            if (follower.Finished()) {
+                break;
+            }
+            if (follower.IdleSeconds() > options.followTimeout) {
+                printf("Capture has not grown for %d seconds, treating it as complete\n", options.followTimeout);
+                follower.ForceComplete();
+                continue;
+            }
+            
+            const size_t round_windows = std::min(online_sequences.size(), ONLINE_ROUND_BATCHES * batch_size) / batch_size * batch_size;
+            if (round_windows == 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(500));
+                continue;
+            }
+            online_indices.resize(online_sequences.size());
+            std::iota(online_indices.begin(), online_indices.end(), 0);
+            std::shuffle(online_indices.begin(), online_indices.end(), online_rng);
+            online_indices.resize(round_windows);
+            augment_stream = ONLINE_AUGMENT_STREAM + online_rounds;
+            online_loader.StartEpoch(online_indices);
+            
+            double round_loss_sum = 0.0;
+            size_t round_batches = 0;
+            int round_accumulated = 0;
+            auto online_update = [&]() {
+                OrtStatus* update_status;
+                {
+                    ScopedPhase phase(profiler, TrainerPhase::OptimizerStep);
+                    update_status = g_ort_training_api->OptimizerStep(training_session, NULL);
+                }
+                if (update_status == NULL) {
+                    ScopedPhase phase(profiler, TrainerPhase::LazyResetGrad);
+                    update_status = g_ort_training_api->LazyResetGrad(training_session);
+                }
+                if (update_status != NULL) {
+                    fprintf(stderr, "Error in online optimizer step: %s\n", g_ort_api->GetErrorMessage(update_status));
+                    g_ort_api->ReleaseStatus(update_status);
+                }
+                round_accumulated = 0;
+            };
+            while (TrainingBatch* batch = online_loader.Next()) {
+                profiler.Record(TrainerPhase::BatchWait, batch->waitSeconds);
+                profiler.Record(TrainerPhase::BatchAssembly, batch->fillSeconds, batch->count);
+                BatchTensorViews one_off;
+                OrtValue* input_tensor = NULL;
+                OrtValue* label_tensor = NULL;
+                if (batch->count > 0 &&
+                    (findBatchTensors(online_views[batch->slot], batch->count, input_tensor, label_tensor) ||
+                     (createBatchTensorViews(g_ort_api, memory_info, *batch, {batch->count}, one_off) &&
+                      findBatchTensors(one_off, batch->count, input_tensor, label_tensor)))) {
+                    OrtValue* input_values[] = {input_tensor, label_tensor};
+                    OrtValue* output_values[] = {online_loss_tensor};
+                    {
+                        ScopedPhase phase(profiler, TrainerPhase::TrainStep, batch->count);
+                        status = g_ort_training_api->TrainStep(training_session, NULL, 2, input_values, 1, output_values);
+                    }
+                    if (status != NULL) {
+                        fprintf(stderr, "Error in online training step: %s\n", g_ort_api->GetErrorMessage(status));
+                        g_ort_api->ReleaseStatus(status);
+                    } else {
+                        round_loss_sum += online_loss;
+                        round_batches++;
+                        if (++round_accumulated == accumulate_steps) {
+                            online_update();
+                        }
+                    }
+                }
+                releaseBatchTensorViews(g_ort_api, one_off);
+                online_loader.Release(batch);
+            }
+            if (round_accumulated > 0) {
+                online_update();
+            }
+            
+            online_rounds++;
+            online_steps += round_batches;
+            const float round_loss = round_batches > 0 ? (float)(round_loss_sum / round_batches) : 0.0f;
+            printf("Online round %d: %zu windows recorded, %zu steps, loss %.6f\n",
+                   online_rounds, online_sequences.size(), round_batches, round_loss);
+            fflush(stdout);
+            
+            // Reported as epoch 0 so the overlay shows the loss before the regular epochs
+            ProgressRecord record;
+            record.event = (uint8_t)ProgressEvent::Batch;
+            record.totalEpochs = options.epochs;
+            record.batch = (int32_t)online_steps;
+            record.loss = round_loss;
+            record.elapsedSeconds = (float)std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - online_start_time).count();
+            progress.Send(record);
+        }
+        
+        for (BatchTensorViews& views : online_views) {
+            releaseBatchTensorViews(g_ort_api, views);
+        }
+        if (online_loss_tensor != NULL) {
+            g_ort_api->ReleaseValue(online_loss_tensor);
+        }
+        std::chrono::duration<double> online_duration = std::chrono::steady_clock::now() - online_start_time;
+        printf("Online phase: %d rounds, %zu steps in %.1fs; %zu frames recorded\n",
+               online_rounds, online_steps, online_duration.count(), frames.size());
+        memory.Set(MemoryCategory::Batches, 0);
+        
+        if (memory_exceeded || !prepare_windows()) {
+            g_ort_api->ReleaseMemoryInfo(memory_info);
+            g_ort_training_api->ReleaseTrainingSession(training_session);
+            g_ort_training_api->ReleaseCheckpointState(checkpoint_state);
+            g_ort_api->ReleaseSessionOptions(session_options);
+            g_ort_api->ReleaseEnv(env);
+            return 1;
+        }
+    }
+    
+    // Parameter statistics sampled one tensor at a time instead of copying the whole model
+    TrainingTelemetry telemetry;
+    if (telemetry.Init(g_ort_api, g_ort_training_api, training_session, checkpoint_state, memory_info,
+                       "onnx_artifacts/training/trainable_params.txt", options.telemetryInterval)) {
+        printf("Telemetry: %zu parameter tensors, model norm %g, every %d steps\n",
+               telemetry.GetCount(), telemetry.ModelNorm(), options.telemetryInterval);
+    }
+    
+    // Per-session weights set each session's share of the training windows of an epoch
+    SessionSampler session_sampler(options.sessionWeights);
+    size_t train_per_epoch = num_train_sequences;
+    const bool session_weighting = !options.sessionWeights.empty();
+    if (session_weighting) {
+        for (size_t i = 0; i < num_train_sequences; i++) {
+            const size_t session = std::upper_bound(session_starts.begin(), session_starts.end(), sequences[i].start) -
+                                   session_starts.begin() - 1;
+            session_sampler.AddWindow(i, session);
+        }
+        session_sampler.PrintPlan(capture_files);
+        train_per_epoch = session_sampler.GetEpochSize();
+        if (options.balance) {
+            printf("WARNING: --session-weights is ignored by --balance epochs\n");
+        } else if (train_per_epoch == 0) {
+            fprintf(stderr, "Session weights leave no training windows\n");
+            g_ort_api->ReleaseMemoryInfo(memory_info);
+            g_ort_training_api->ReleaseTrainingSession(training_session);
+            g_ort_training_api->ReleaseCheckpointState(checkpoint_state);
+            g_ort_api->ReleaseSessionOptions(session_options);
+            g_ort_api->ReleaseEnv(env);
+            return 1;
+        }
+    }
+    
+    // Create indices for shuffling; refilled every epoch with the training windows and
+    // that epoch's replay sample
+    std::vector<size_t> indices(train_per_epoch + replay_per_epoch);
+    std::vector<size_t> replay_indices(sequences.size() - replay_begin);
+    std::iota(replay_indices.begin(), replay_indices.end(), replay_begin);
+    
+    // Stage-balanced epochs draw a planned number of windows per routine stage class
+    // instead of every training window once
+    StageSampler stage_sampler(options.stageWeights, options.balanceMaxRepeats);
+    if (options.balance) {
+        for (size_t i = 0; i < num_train_sequences; i++) {
+            stage_sampler.AddWindow(i, ClassifyStage(frames[sequences[i].lastFrameIndex()]));
+        }
+        const size_t balanced_windows = std::max(batch_size, (size_t)(num_train_sequences * options.balanceEpoch + 0.5f));
+        if (replay_per_epoch > 0) {
+            replay_per_epoch = std::min(replay_indices.size(),
+                (size_t)(balanced_windows * options.replayFraction / (1.0f - options.replayFraction) + 0.5f));
+            stage_sampler.SetFixedPool(replay_indices, replay_per_epoch);
+        }
+        indices.resize(stage_sampler.Plan(balanced_windows));
+        stage_sampler.PrintPlan();
+        if (indices.empty()) {
+            fprintf(stderr, "Stage weights leave no training windows\n");
+            g_ort_api->ReleaseMemoryInfo(memory_info);
+            g_ort_training_api->ReleaseTrainingSession(training_session);
+            g_ort_training_api->ReleaseCheckpointState(checkpoint_state);
+            g_ort_api->ReleaseSessionOptions(session_options);
+            g_ort_api->ReleaseEnv(env);
+            return 1;
+        }
+    }
+    
+    // Validation windows follow the training windows and are evaluated in order
+    std::vector<size_t> validation_order(replay_begin - num_train_sequences);
+    std::iota(validation_order.begin(), validation_order.end(), num_train_sequences);
     
     // Training configuration
-    const int num_epochs = 16;  // Increased from 2 to 5
-    const size_t batch_size = 16;  // Match Python trainer
-    const size_t check_interval = 500;  // Check parameters every N batches (reduced frequency)
+    const int num_epochs = options.epochs;
     const size_t save_interval = 16;    // Save checkpoint every N epochs
     
-    printf("Starting training with %zu sequences, %d epochs, batch size %zu\n", 
-           sequences.size(), num_epochs, (size_t)batch_size);
+    const float min_improvement = 1e-3f;  // relative loss drop that counts as progress
+    
+    printf("Starting training with %zu sequences, up to %d epochs, batch size %zu\n", 
+           num_train_sequences, num_epochs, (size_t)batch_size);
+    if (accumulate_steps > 1) {
+        printf("Accumulating gradients over %d micro-batches, effective batch size %zu\n",
+               accumulate_steps, batch_size * accumulate_steps);
+    }
+    
+    // Learning rate schedule over the optimizer steps of the full epoch budget. The linear
+    // schedule runs inside ORT; the others set the rate from here before each step. An
+    // epoch's last optimizer step may cover fewer micro-batches.
+    const int64_t batches_per_epoch = (int64_t)((indices.size() + batch_size - 1) / batch_size);
+    const int64_t steps_per_epoch = (batches_per_epoch + accumulate_steps - 1) / accumulate_steps;
+    LRSchedule lr_schedule;
+    lr_schedule.type = options.lrSchedule;
+    lr_schedule.baseRate = learning_rate;
+    lr_schedule.totalSteps = std::max<int64_t>(steps_per_epoch * num_epochs, 1);
+    lr_schedule.stepInterval = steps_per_epoch * options.lrStepEpochs;
+    lr_schedule.gamma = options.lrGamma;
+    if (options.warmupSteps >= 0) {
+        lr_schedule.warmupSteps = options.warmupSteps;
+    } else if (lr_schedule.type == LRScheduleType::Linear || lr_schedule.type == LRScheduleType::Cosine) {
+        lr_schedule.warmupSteps = lr_schedule.totalSteps / 20;
+    }
+    
+    bool ort_lr_scheduler = false;
+    bool host_lr_schedule = lr_schedule.type != LRScheduleType::Constant || lr_schedule.warmupSteps > 0;
+    if (lr_schedule.type == LRScheduleType::Linear) {
+        status = g_ort_training_api->RegisterLinearLRScheduler(
+            training_session, lr_schedule.warmupSteps, lr_schedule.totalSteps, learning_rate);
+        if (status != NULL) {
+            const char* error_message = g_ort_api->GetErrorMessage(status);
+            fprintf(stderr, "Error registering linear LR scheduler, setting rates from the trainer: %s\n", error_message);
+            g_ort_api->ReleaseStatus(status);
+        } else {
+            ort_lr_scheduler = true;
+            host_lr_schedule = false;
+        }
+    }
+    printf("Learning rate schedule: %s, base %g, %lld warmup steps, %lld total steps\n",
+           LRScheduleName(lr_schedule.type), learning_rate,
+           (long long)lr_schedule.warmupSteps, (long long)lr_schedule.totalSteps);
+    int64_t optimizer_step = 0;
     
     // Track overall stats
     float best_loss = std::numeric_limits<float>::max();
+    int best_epoch = 0;
+    int evals_without_improvement = 0;
+    
+    // Batches are assembled on loader threads while the previous one trains
+    BatchLoader loader(sample_image_floats, NUM_CLASSES, batch_size, loader_workers, options.prefetchBatches,
+        [&frame_cache, &sequences, &augmenter, &augment_stream, &num_train_sequences, &replay_begin](
+            size_t sample, float* images, float* labels) {
+            // Validation windows are evaluated as recorded
+            const bool validation = sample >= num_train_sequences && sample < replay_begin;
+            return fillTrainingSample(frame_cache, sequences[sample], images, labels,
+                                      validation ? NULL : augmenter.get(), augment_stream.load());
+        });
+    printf("Batch loader: %zu workers, %zu batches in flight\n", loader.GetWorkerCount(), loader.GetPoolSize());
+    memory.Set(MemoryCategory::Batches, loader.GetMemoryBytes());
+    memory.Set(MemoryCategory::Windows, sequences.capacity() * sizeof(TemporalSequence) +
+               (indices.capacity() + replay_indices.capacity() + validation_order.capacity()) * sizeof(size_t));
+    
+    // Bind input/label tensors to every pooled batch buffer and the loss output to a
+    // single float once, so training steps create and release no OrtValues. The MSE loss
+    // graph from mkmodel7.py outputs a scalar.
+    const std::vector<size_t> bound_batch_sizes = {
+        batch_size, indices.size() % batch_size, validation_order.size() % batch_size
+    };
+    std::vector<BatchTensorViews> batch_views(loader.GetPoolSize());
+    bool views_created = true;
+    for (size_t slot = 0; slot < batch_views.size() && views_created; slot++) {
+        views_created = createBatchTensorViews(g_ort_api, memory_info, loader.GetPoolBatch(slot),
+                                               bound_batch_sizes, batch_views[slot]);
+    }
+    float loss_value = 0.0f;
+    const int64_t loss_shape[] = {1};  // unused for a scalar
+    OrtValue* loss_tensor = views_created ?
+        createFloatTensorView(g_ort_api, memory_info, &loss_value, loss_shape, 0) : NULL;
+    if (loss_tensor == NULL) {
+        fprintf(stderr, "Error binding batch tensors\n");
+        for (BatchTensorViews& views : batch_views) {
+            releaseBatchTensorViews(g_ort_api, views);
+        }
+        g_ort_api->ReleaseMemoryInfo(memory_info);
+        g_ort_training_api->ReleaseTrainingSession(training_session);
+        g_ort_training_api->ReleaseCheckpointState(checkpoint_state);
+        g_ort_api->ReleaseSessionOptions(session_options);
+        g_ort_api->ReleaseEnv(env);
+        return 1;
+    }
     
-    // Pre-allocate batch tensors to avoid repeated allocations
-    std::vector<float> batch_images(batch_size * 2 * NUM_FRAMES * TRAIN_RESOLUTION * TRAIN_RESOLUTION);
-    std::vector<float> batch_labels(batch_size * NUM_CLASSES);
+    // Pick the tensors bound to a batch's buffers. A batch that lost samples to the
+    // filler has an unexpected size and gets one-off views, released by the caller.
+    auto bind_batch = [&](TrainingBatch* batch, BatchTensorViews& one_off,
+                          OrtValue*& input_tensor, OrtValue*& label_tensor) {
+        if (findBatchTensors(batch_views[batch->slot], batch->count, input_tensor, label_tensor)) {
+            return true;
+        }
+        return createBatchTensorViews(g_ort_api, memory_info, *batch, {batch->count}, one_off) &&
+               findBatchTensors(one_off, batch->count, input_tensor, label_tensor);
+    };
+    
+    // Mean loss of the eval graph over all validation windows; NaN if nothing was evaluated
+    auto evaluate_validation = [&]() {
+        loader.StartEpoch(validation_order);
+        double loss_sum = 0.0;
+        size_t sample_count = 0;
+        
+        while (TrainingBatch* batch = loader.Next()) {
+            BatchTensorViews one_off;
+            OrtValue* input_tensor = NULL;
+            OrtValue* label_tensor = NULL;
+            if (batch->count > 0 && bind_batch(batch, one_off, input_tensor, label_tensor)) {
+                const OrtValue* input_values[] = {input_tensor, label_tensor};
+                OrtValue* output_values[] = {loss_tensor};
+                OrtStatus* eval_status = g_ort_training_api->EvalStep(
+                    training_session, NULL, 2, input_values, 1, output_values);
+                if (eval_status != NULL) {
+                    fprintf(stderr, "Error in eval step: %s\n", g_ort_api->GetErrorMessage(eval_status));
+                    g_ort_api->ReleaseStatus(eval_status);
+                } else {
+                    // The loss is a batch mean; weight it so a ragged batch counts correctly
+                    loss_sum += (double)loss_value * batch->count;
+                    sample_count += batch->count;
+                }
+            }
+            releaseBatchTensorViews(g_ort_api, one_off);
+            loader.Release(batch);
+        }
+        
+        return sample_count > 0 ? (float)(loss_sum / sample_count) : std::numeric_limits<float>::quiet_NaN();
+    };
+    
+    // Snapshot of the trainable parameters at the best validation loss, restored before
+    // export when training continued past it
+    std::vector<float> best_params;
+    OrtValue* best_params_tensor = NULL;
+    if (has_validation) {
+        size_t trainable_params_size = 0;
+        status = g_ort_training_api->GetParametersSize(training_session, &trainable_params_size, true);
+        if (status != NULL) {
+            fprintf(stderr, "Error getting trainable parameters size: %s\n", g_ort_api->GetErrorMessage(status));
+            g_ort_api->ReleaseStatus(status);
+        } else {
+            best_params.resize(trainable_params_size);
+            memory.Set(MemoryCategory::OrtState, memory.Get(MemoryCategory::OrtState) + best_params.size() * sizeof(float));
+            const int64_t params_shape[] = {(int64_t)trainable_params_size};
+            best_params_tensor = createFloatTensorView(g_ort_api, memory_info, best_params.data(), params_shape, 1);
+        }
+    }
     
     // Training loop
     auto training_start_time = std::chrono::steady_clock::now();
+    int epochs_run = 0;
+    bool memory_exceeded = false;
+    size_t samples_trained = 0;
+    
+    // Structured progress for the overlay; totals, throughput and ETA are filled in here
+    auto make_progress = [&](ProgressEvent event, int epoch, size_t batch, float loss) {
+        const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - training_start_time).count();
+        const int64_t total_steps = batches_per_epoch * num_epochs;
+        const int64_t steps_done = std::max<int64_t>((int64_t)epoch - 1, 0) * batches_per_epoch + (int64_t)batch;
+        
+        ProgressRecord record;
+        record.event = (uint8_t)event;
+        record.epoch = epoch;
+        record.totalEpochs = num_epochs;
+        record.batch = (int32_t)batch;
+        record.totalBatches = (int32_t)batches_per_epoch;
+        record.loss = loss;
+        record.elapsedSeconds = (float)elapsed;
+        record.samplesPerSecond = elapsed > 0.0 ? (float)(samples_trained / elapsed) : 0.0f;
+        record.etaSeconds = steps_done > 0 ? (float)(elapsed / steps_done * (total_steps - steps_done)) : -1.0f;
+        return record;
+    };
+    auto send_progress = [&](ProgressEvent event, int epoch, size_t batch, float loss) {
+        if (progress.IsOpen()) {
+            progress.Send(make_progress(event, epoch, batch, loss));
+        }
+    };
+    // layer -1 reports the whole-model estimates
+    auto send_telemetry = [&](int epoch, size_t batch, int layer) {
+        if (!progress.IsOpen() || layer >= (int)telemetry.GetCount()) {
+            return;
+        }
+        ProgressRecord record = make_progress(ProgressEvent::Telemetry, epoch, batch, 0.0f);
+        record.layer = layer;
+        if (layer >= 0) {
+            record.parameterNorm = telemetry.GetStats(layer).norm;
+            record.updateRatio = telemetry.GetStats(layer).updateRatio;
+        } else {
+            record.parameterNorm = telemetry.ModelNorm();
+            record.updateRatio = telemetry.ModelUpdateRatio();
+        }
+        progress.Send(record);
+    };
+    send_progress(ProgressEvent::Started, 0, 0, 0.0f);
     
     for (int epoch = 0; epoch < num_epochs; epoch++) {
         auto epoch_start_time = std::chrono::steady_clock::now();
         printf("\n=== Epoch %d/%d ===\n", epoch + 1, num_epochs);
+        send_progress(ProgressEvent::EpochStarted, epoch + 1, 0, 0.0f);
         
         // Shuffle data for this epoch
         std::random_device rd;
         std::mt19937 g(rd());
-        std::shuffle(indices.begin(), indices.end(), g);
+        if (options.balance) {
+            stage_sampler.DrawEpoch(g, indices);
+        } else {
+            if (session_weighting) {
+                session_sampler.DrawEpoch(g, indices.data());
+            } else {
+                std::iota(indices.begin(), indices.begin() + num_train_sequences, 0);  // Fill with 0, 1, 2, ...
+            }
+            if (replay_per_epoch > 0) {
+                std::shuffle(replay_indices.begin(), replay_indices.end(), g);
+                std::copy(replay_indices.begin(), replay_indices.begin() + replay_per_epoch,
+                          indices.begin() + train_per_epoch);
+            }
+            std::shuffle(indices.begin(), indices.end(), g);
+        }
+        augment_stream = epoch + 1;
+        loader.StartEpoch(indices);
         
         // Track metrics
         float epoch_loss_sum = 0.0f;
         size_t batch_count = 0;
         
-        // Process data in batches
-        for (size_t batch_start = 0; batch_start < sequences.size(); batch_start += batch_size) {
-            // Determine actual batch size (may be smaller for the last batch)
-            size_t current_batch_size = STD_MIN(batch_size, sequences.size() - batch_start);
-            
-            // Resize pre-allocated batch vectors instead of creating new ones
-            size_t required_image_size = current_batch_size * 2 * NUM_FRAMES * TRAIN_RESOLUTION * TRAIN_RESOLUTION;
-            size_t required_label_size = current_batch_size * NUM_CLASSES;
-            
-            if (batch_images.size() != required_image_size) {
-                batch_images.resize(required_image_size);
+        // Micro-batches whose gradients wait for the next optimizer step
+        int accumulated = 0;
+        auto optimizer_update = [&](size_t batch_number) {
+            // Run optimizer step - CRITICAL for weight updates
+            {
+                ScopedPhase phase(profiler, TrainerPhase::OptimizerStep);
+                status = g_ort_training_api->OptimizerStep(training_session, NULL);
             }
-            if (batch_labels.size() != required_label_size) {
-                batch_labels.resize(required_label_size);
+            if (status != NULL) {
+                const char* error_message = g_ort_api->GetErrorMessage(status);
+                fprintf(stderr, "\nError in optimizer step: %s\n", error_message);
+                g_ort_api->ReleaseStatus(status);
             }
             
-            // Fill batch with data
-            for (size_t i = 0; i < current_batch_size; i++) {
-                const auto& sequence = sequences[indices[batch_start + i]];
-                
-                // Use the last frame for labels (most recent)
-                const auto& last_frame = sequence.frames.back();
-                
-                // DEBUG: Check frame validity
-                //printf("Processing sequence %zu, frame timestamp: %llu\n", 
-                //       indices[batch_start + i], last_frame.label_timestamp);
-                
-                // Extract all eye tracking parameters from capture_data.h structure
-                // Eye tracking parameters (pitch, yaw, distance) - excluding fovAdjustDistance
-                float pitch = ((std::get<0>(last_frame.label_data) / 32.0f) + 1.0f) / 2.0f;  // Convert from [-1,1] to [0,1]
-                float yaw = ((std::get<1>(last_frame.label_data) / 32.0f) + 1.0f) / 2.0f;    // Convert from [-1,1] to [0,1]
-                float distance = std::get<2>(last_frame.label_data);  // routineDistance
-                // Skip fovAdjustDistance (std::get<3>) - used for internal normalization only
-                
-                // Lid/brow parameters (routineLeftLid, routineRightLid, routineBrowRaise, routineBrowAngry, routineWiden, routineSquint)
-                float leftLid = std::get<4>(last_frame.label_data);     // routineLeftLid
-                float rightLid = std::get<5>(last_frame.label_data);    // routineRightLid
-                float browRaise = std::get<6>(last_frame.label_data);   // routineBrowRaise
-                float browAngry = std::get<7>(last_frame.label_data);   // routineBrowAngry
-                float widen = std::get<8>(last_frame.label_data);       // routineWiden
-                float squint = std::get<9>(last_frame.label_data);      // routineSquint
-                float dilate = std::get<10>(last_frame.label_data);     // routineDilate
-                
-                // DEBUG: Check for invalid values
-                float all_params[] = {pitch, yaw, distance, leftLid, rightLid, browRaise, browAngry, widen, squint, dilate};
-                bool has_invalid = false;
-                for (int p = 0; p < 10; p++) {
-                    if (!std::isfinite(all_params[p])) {
-                        printf("ERROR: Invalid value at param %d: %f\n", p, all_params[p]);
-                        has_invalid = true;
-                    }
-                }
-                //if (i == 0) {
-                //    printf("Sample %zu labels: pitch=%.3f yaw=%.3f dist=%.3f lid=%.3f,%.3f brow=%.3f,%.3f other=%.3f,%.3f,%.3f\n",
-                //           i, pitch, yaw, distance, leftLid, rightLid, browRaise, browAngry, widen, squint, dilate);
-                //}
-                if (has_invalid) {
-                    printf("Skipping batch due to invalid values\n");
-                    continue;
-                }
-                
-                // Fill batch labels with 10 parameters (excluding fovAdjustDistance)
-                batch_labels[i * NUM_CLASSES + 0] = pitch;
-                batch_labels[i * NUM_CLASSES + 1] = yaw;
-                batch_labels[i * NUM_CLASSES + 2] = distance;
-                batch_labels[i * NUM_CLASSES + 3] = leftLid;
-                batch_labels[i * NUM_CLASSES + 4] = rightLid;
-                batch_labels[i * NUM_CLASSES + 5] = browRaise;
-                batch_labels[i * NUM_CLASSES + 6] = browAngry;
-                batch_labels[i * NUM_CLASSES + 7] = widen;
-                batch_labels[i * NUM_CLASSES + 8] = squint;
-                batch_labels[i * NUM_CLASSES + 9] = dilate;
-                
-                // Process all frames in the sequence (most recent frame first)
-                for (int frame_idx = 0; frame_idx < NUM_FRAMES; frame_idx++) {
-                    // Get frame from sequence (most recent to oldest)
-                    const auto& frame = sequence.frames[NUM_FRAMES - 1 - frame_idx];
-                    
-                    // Get eye images (reuse vectors to avoid allocations)
-                    static thread_local std::vector<uint32_t> left_eye_data;
-                    static thread_local std::vector<uint32_t> right_eye_data;
-                    int left_width, left_height, right_width, right_height;
-                    
-                    // Decode eye images (uses existing caching)
-                    frame.DecodeImageLeft(left_eye_data, left_width, left_height);
-                    frame.DecodeImageRight(right_eye_data, right_width, right_height);
-                    
-                    // Calculate offsets in the batch tensor
-                    size_t frame_offset = i * 2 * NUM_FRAMES * TRAIN_RESOLUTION * TRAIN_RESOLUTION + 
-                                          frame_idx * 2 * TRAIN_RESOLUTION * TRAIN_RESOLUTION;
-                    
-                    // Process left eye with optimized scaling
-                    const float x_scale = (float)left_width / TRAIN_RESOLUTION;
-                    const float y_scale = (float)left_height / TRAIN_RESOLUTION;
-                    
-                    for (int y = 0; y < TRAIN_RESOLUTION; y++) {
-                        const int src_y = std::max(0, std::min((int)(y * y_scale), left_height - 1));
-                        const int src_row_offset = src_y * left_width;
-                        const size_t target_row_offset = frame_offset + y * TRAIN_RESOLUTION;
-                        
-                        for (int x = 0; x < TRAIN_RESOLUTION; x++) {
-                            const int src_x = std::max(0, std::min((int)(x * x_scale), left_width - 1));
-                            const uint32_t pixel = left_eye_data[src_row_offset + src_x];
-                            batch_images[target_row_offset + x] = (pixel & 0xFF) * (1.0f / 255.0f);
-                        }
-                    }
-                    
-                    // Process right eye with optimized scaling (offset by TRAIN_RESOLUTION * TRAIN_RESOLUTION)
-                    const float x_scale_r = (float)right_width / TRAIN_RESOLUTION;
-                    const float y_scale_r = (float)right_height / TRAIN_RESOLUTION;
-                    const size_t right_eye_offset = frame_offset + TRAIN_RESOLUTION * TRAIN_RESOLUTION;
-                    
-                    for (int y = 0; y < TRAIN_RESOLUTION; y++) {
-                        const int src_y = std::max(0, std::min((int)(y * y_scale_r), right_height - 1));
-                        const int src_row_offset = src_y * right_width;
-                        const size_t target_row_offset = right_eye_offset + y * TRAIN_RESOLUTION;
-                        
-                        for (int x = 0; x < TRAIN_RESOLUTION; x++) {
-                            const int src_x = std::max(0, std::min((int)(x * x_scale_r), right_width - 1));
-                            const uint32_t pixel = right_eye_data[src_row_offset + src_x];
-                            batch_images[target_row_offset + x] = (pixel & 0xFF) * (1.0f / 255.0f);
-                        }
-                    }
+            // Advance the learning rate schedule
+            if (ort_lr_scheduler) {
+                status = g_ort_training_api->SchedulerStep(training_session);
+                if (status != NULL) {
+                    const char* error_message = g_ort_api->GetErrorMessage(status);
+                    fprintf(stderr, "\nError in scheduler step: %s\n", error_message);
+                    g_ort_api->ReleaseStatus(status);
                 }
             }
+            optimizer_step++;
             
-            // DEBUG: Print tensor shapes before creation
-            //printf("Creating tensors - batch_size: %zu, input_shape: [%lld, %lld, %lld, %lld]\n",
-            //       current_batch_size, (int64_t)current_batch_size, (int64_t)(2 * NUM_FRAMES), 
-            //       (int64_t)TRAIN_RESOLUTION, (int64_t)TRAIN_RESOLUTION);
-            
-            // Create input tensor for images
-            const int64_t input_shape[] = {(int64_t)current_batch_size, 2 * NUM_FRAMES, TRAIN_RESOLUTION, TRAIN_RESOLUTION};
-            OrtValue* input_tensor = NULL;
-            
-            status = g_ort_api->CreateTensorWithDataAsOrtValue(
-                memory_info,
-                batch_images.data(),
-                batch_images.size() * sizeof(float),
-                input_shape,
-                4,
-                ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT,
-                &input_tensor
-            );
+            int sampled_layer = telemetry.AfterStep(optimizer_step);
+            if (sampled_layer >= 0) {
+                send_telemetry(epoch + 1, batch_number, sampled_layer);
+            }
             
+            // Reset gradients AFTER optimizer step
+            {
+                ScopedPhase phase(profiler, TrainerPhase::LazyResetGrad);
+                status = g_ort_training_api->LazyResetGrad(training_session);
+            }
             if (status != NULL) {
                 const char* error_message = g_ort_api->GetErrorMessage(status);
-                fprintf(stderr, "Error creating input tensor: %s\n", error_message);
+                fprintf(stderr, "\nError resetting gradients: %s\n", error_message);
                 g_ort_api->ReleaseStatus(status);
-                continue;  // Skip this batch
+            }
+            accumulated = 0;
+        };
+        
+        // Process data in batches
+        while (TrainingBatch* batch = loader.Next()) {
+            // ORT's arenas grow over the first steps; stop before the machine starts swapping
+            if (batch_count % MEMORY_CHECK_BATCHES == 0 && !memory.Check("epoch " + std::to_string(epoch + 1))) {
+                memory_exceeded = true;
+                loader.Release(batch);
+                break;
+            }
+            const size_t current_batch_size = batch->count;
+            profiler.Record(TrainerPhase::BatchWait, batch->waitSeconds);
+            profiler.Record(TrainerPhase::BatchAssembly, batch->fillSeconds, current_batch_size);
+            if (current_batch_size == 0) {
+                loader.Release(batch);
+                continue;
             }
             
-            //printf("Input tensor created successfully\n");
-            
-            // Create label tensor
-            const int64_t label_shape[] = {(int64_t)current_batch_size, NUM_CLASSES};
+            BatchTensorViews one_off;
+            OrtValue* input_tensor = NULL;
             OrtValue* label_tensor = NULL;
-            //printf("Creating label tensor with shape: [%lld, %lld]\n", label_shape[0], label_shape[1]);
-            
-            status = g_ort_api->CreateTensorWithDataAsOrtValue(
-                memory_info,
-                batch_labels.data(),
-                batch_labels.size() * sizeof(float),
-                label_shape,
-                2,
-                ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT,
-                &label_tensor
-            );
+            bind_batch(batch, one_off, input_tensor, label_tensor);
             
-            if (status != NULL) {
-                const char* error_message = g_ort_api->GetErrorMessage(status);
-                fprintf(stderr, "Error creating label tensor: %s\n", error_message);
-                g_ort_api->ReleaseStatus(status);
-                g_ort_api->ReleaseValue(input_tensor);
+            if (input_tensor == NULL || label_tensor == NULL) {
+                releaseBatchTensorViews(g_ort_api, one_off);
+                loader.Release(batch);
                 continue;  // Skip this batch
             }
             
-            //printf("Label tensor created successfully\n");
+            if (host_lr_schedule && accumulated == 0) {
+                status = g_ort_training_api->SetLearningRate(training_session, lr_schedule.RateAt(optimizer_step));
+                if (status != NULL) {
+                    const char* error_message = g_ort_api->GetErrorMessage(status);
+                    fprintf(stderr, "\nError setting learning rate: %s\n", error_message);
+                    g_ort_api->ReleaseStatus(status);
+                }
+            }
             
             // Setup inputs and outputs for training step
             OrtValue* input_values[] = {input_tensor, label_tensor};
-            OrtValue* output_values[1] = {NULL};
+            OrtValue* output_values[] = {loss_tensor};
             
             //printf("About to call TrainStep for batch %zu...\n", batch_count);
             //fflush(stdout);
             
             // Run training step
-            status = g_ort_training_api->TrainStep(
-                training_session,
-                NULL,
-                2,
-                input_values,
-                1,
-                output_values
-            );
+            {
+                ScopedPhase phase(profiler, TrainerPhase::TrainStep, current_batch_size);
+                status = g_ort_training_api->TrainStep(
+                    training_session,
+                    NULL,
+                    2,
+                    input_values,
+                    1,
+                    output_values
+                );
+            }
+            releaseBatchTensorViews(g_ort_api, one_off);
             
             if (status != NULL) {
                 const char* error_message = g_ort_api->GetErrorMessage(status);
                 fprintf(stderr, "Error in training step: %s\n", error_message);
                 g_ort_api->ReleaseStatus(status);
-                g_ort_api->ReleaseValue(input_tensor);
-                g_ort_api->ReleaseValue(label_tensor);
+                loader.Release(batch);
                 continue;  // Skip this batch
             }
             
             //printf("TrainStep completed successfully for batch %zu\n", batch_count);
             
-            // Get loss value
-            float batch_loss = 0.0f;
-            if (output_values[0] != NULL) {
-                float* loss_data = NULL;
-                status = g_ort_api->GetTensorMutableData(output_values[0], (void**)&loss_data);
-                if (status == NULL) {
-                    batch_loss = loss_data[0];
-                    epoch_loss_sum += batch_loss;
-                    
-                    // Print batch progress
-                    printf("\rBatch %zu/%zu, Loss: %.6f", 
-                           batch_count + 1, 
-                           (sequences.size() + batch_size - 1) / batch_size, 
-                           batch_loss);
-                    fflush(stdout);
-                } else {
-                    const char* error_message = g_ort_api->GetErrorMessage(status);
-                    fprintf(stderr, "Error getting loss data: %s\n", error_message);
-                    g_ort_api->ReleaseStatus(status);
-                }
-            }
-            
-            // Run optimizer step - CRITICAL for weight updates
-            status = g_ort_training_api->OptimizerStep(training_session, NULL);
-            if (status != NULL) {
-                const char* error_message = g_ort_api->GetErrorMessage(status);
-                fprintf(stderr, "\nError in optimizer step: %s\n", error_message);
-                g_ort_api->ReleaseStatus(status);
-            }
+            // Get loss value (written straight into loss_value)
+            float batch_loss = loss_value;
+            epoch_loss_sum += batch_loss;
+            samples_trained += current_batch_size;
+            send_progress(ProgressEvent::Batch, epoch + 1, batch_count + 1, batch_loss);
             
-            // Reset gradients AFTER optimizer step
-            status = g_ort_training_api->LazyResetGrad(training_session);
-            if (status != NULL) {
-                const char* error_message = g_ort_api->GetErrorMessage(status);
-                fprintf(stderr, "\nError resetting gradients: %s\n", error_message);
-                g_ort_api->ReleaseStatus(status);
-            }
+            // Print batch progress
+            printf("\rBatch %zu/%zu, Loss: %.6f", 
+                   batch_count + 1, 
+                   loader.GetBatchCount(), 
+                   batch_loss);
+            fflush(stdout);
             
-            // Check parameter changes periodically
-            if (batch_count % check_interval == 0) {
-                printf("\n");  // Add line break after batch progress
-                printParameterInfo(training_session, g_ort_api, g_ort_training_api, &previous_params);
+            // Run optimizer step once the gradients of accumulate_steps micro-batches are summed
+            if (++accumulated == accumulate_steps) {
+                optimizer_update(batch_count + 1);
             }
             
-            // Clean up batch resources
-            if (output_values[0] != NULL) {
-                g_ort_api->ReleaseValue(output_values[0]);
-            }
-            g_ort_api->ReleaseValue(input_tensor);
-            g_ort_api->ReleaseValue(label_tensor);
+            // Hand the buffers back; the bound tensors stay valid for the next use of this slot
+            loader.Release(batch);
             
             batch_count++;
         }
+        if (memory_exceeded) {
+            break;
+        }
+        if (accumulated > 0) {
+            optimizer_update(batch_count);
+        }
         
         // Print epoch summary
         auto epoch_end_time = std::chrono::steady_clock::now();
         std::chrono::duration<double> epoch_duration = epoch_end_time - epoch_start_time;
         
         float epoch_avg_loss = epoch_loss_sum / batch_count;
-        printf("\nEpoch %d/%d completed in %.2fs. Average loss: %.6f\n", 
-               epoch + 1, num_epochs, epoch_duration.count(), epoch_avg_loss);
+        float epoch_lr = 0.0f;
+        status = g_ort_training_api->GetLearningRate(training_session, &epoch_lr);
+        if (status != NULL) {
+            g_ort_api->ReleaseStatus(status);
+        }
+        printf("\nEpoch %d/%d completed in %.2fs. Average loss: %.6f, learning rate: %g\n", 
+               epoch + 1, num_epochs, epoch_duration.count(), epoch_avg_loss, epoch_lr);
+        epochs_run = epoch + 1;
+        send_progress(ProgressEvent::EpochFinished, epoch + 1, batch_count, epoch_avg_loss);
+        
+        if (telemetry.IsEnabled()) {
+            telemetry.EndEpoch(optimizer_step);
+            printf("Parameter norm: %g, update ratio per step: %g\n",
+                   telemetry.ModelNorm(), telemetry.ModelUpdateRatio());
+            send_telemetry(epoch + 1, batch_count, -1);
+        }
+        
+        // Select the best checkpoint by validation loss when a validation set exists,
+        // otherwise by training loss
+        float selection_loss = epoch_avg_loss;
+        bool check_best = true;
+        bool stop_early = false;
+        if (has_validation) {
+            check_best = (epoch + 1) % options.evalInterval == 0 || epoch == num_epochs - 1;
+            if (check_best) {
+                auto eval_start_time = std::chrono::steady_clock::now();
+                selection_loss = evaluate_validation();
+                std::chrono::duration<double> eval_duration = std::chrono::steady_clock::now() - eval_start_time;
+                profiler.Record(TrainerPhase::Validation, eval_duration.count(), validation_order.size());
+                printf("Validation loss: %.6f (%zu windows, %.2fs)\n", selection_loss,
+                       validation_order.size(), eval_duration.count());
+                send_progress(ProgressEvent::Validation, epoch + 1, batch_count, selection_loss);
+                check_best = std::isfinite(selection_loss);
+            }
+        }
         
         // Check if this is the best loss so far
-        if (epoch_avg_loss < best_loss) {
-            best_loss = epoch_avg_loss;
-            printf("New best loss achieved!\n");
+        if (check_best && selection_loss < best_loss * (1.0f - min_improvement)) {
+            best_loss = selection_loss;
+            best_epoch = epoch + 1;
+            evals_without_improvement = 0;
+            printf("New best %s loss achieved!\n", has_validation ? "validation" : "training");
+            
+            if (best_params_tensor != NULL) {
+                status = g_ort_training_api->CopyParametersToBuffer(training_session, best_params_tensor, true);
+                if (status != NULL) {
+                    fprintf(stderr, "Error saving best parameters: %s\n", g_ort_api->GetErrorMessage(status));
+                    g_ort_api->ReleaseStatus(status);
+                }
+            }
             
             // Save best model checkpoint
             std::string best_checkpoint_path = "onnx_artifacts/training/checkpoint_best";
-            status = g_ort_training_api->SaveCheckpoint(
-                checkpoint_state,
-                to_wstring(best_checkpoint_path).c_str(),
-                true  // Include optimizer state
-            );
+            {
+                ScopedPhase phase(profiler, TrainerPhase::Checkpoint);
+                status = g_ort_training_api->SaveCheckpoint(
+                    checkpoint_state,
+                    to_wstring(best_checkpoint_path).c_str(),
+                    true  // Include optimizer state
+                );
+            }
             
             if (status != NULL) {
                 const char* error_message = g_ort_api->GetErrorMessage(status);
@@ -771,16 +1687,26 @@ int main(int argc, char* argv[]) {
             } else {
                 printf("Best checkpoint saved to %s\n", best_checkpoint_path.c_str());
             }
+        } else if (check_best && has_validation) {
+            evals_without_improvement++;
+            if (options.patience > 0 && evals_without_improvement >= options.patience) {
+                printf("Validation loss has not improved for %d evaluations, stopping after epoch %d\n",
+                       evals_without_improvement, epoch + 1);
+                stop_early = true;
+            }
         }
         
         // Save checkpoint periodically
-        if ((epoch + 1) % save_interval == 0 || epoch == num_epochs - 1) {
+        if ((epoch + 1) % save_interval == 0 || epoch == num_epochs - 1 || stop_early) {
             std::string checkpoint_save_path = "onnx_artifacts/training/checkpoint_epoch" + std::to_string(epoch + 1);
-            status = g_ort_training_api->SaveCheckpoint(
-                checkpoint_state,
-                to_wstring(checkpoint_save_path).c_str(),
-                true  // Include optimizer state
-            );
+            {
+                ScopedPhase phase(profiler, TrainerPhase::Checkpoint);
+                status = g_ort_training_api->SaveCheckpoint(
+                    checkpoint_state,
+                    to_wstring(checkpoint_save_path).c_str(),
+                    true  // Include optimizer state
+                );
+            }
             
             if (status != NULL) {
                 const char* error_message = g_ort_api->GetErrorMessage(status);
@@ -790,16 +1716,56 @@ int main(int argc, char* argv[]) {
                 printf("Checkpoint saved to %s\n", checkpoint_save_path.c_str());
             }
         }
+        
+        // The first epoch shows the steady state once ORT's arenas have grown
+        if (epoch == 0 && !memory.Snapshot("epoch 1")) {
+            memory_exceeded = true;
+            break;
+        }
+        
+        if (stop_early) {
+            break;
+        }
     }
     
-    // Print final parameter info
-    printf("\nFinal parameter information:\n");
-    printParameterInfo(training_session, g_ort_api, g_ort_training_api, &previous_params);
+    if (memory_exceeded) {
+        fprintf(stderr, "Training stopped: memory budget of %zu MB exceeded\n", memory.GetBudget() / (1024 * 1024));
+        for (BatchTensorViews& views : batch_views) {
+            releaseBatchTensorViews(g_ort_api, views);
+        }
+        g_ort_api->ReleaseValue(loss_tensor);
+        if (best_params_tensor != NULL) {
+            g_ort_api->ReleaseValue(best_params_tensor);
+        }
+        g_ort_api->ReleaseMemoryInfo(memory_info);
+        g_ort_training_api->ReleaseTrainingSession(training_session);
+        g_ort_training_api->ReleaseCheckpointState(checkpoint_state);
+        g_ort_api->ReleaseSessionOptions(session_options);
+        g_ort_api->ReleaseEnv(env);
+        return 1;
+    }
+    memory.Snapshot("training");
+    
+    // Export the weights of the best validation epoch rather than the last one
+    if (best_params_tensor != NULL && best_epoch > 0 && best_epoch != epochs_run) {
+        status = g_ort_training_api->CopyBufferToParameters(training_session, best_params_tensor, true);
+        if (status != NULL) {
+            fprintf(stderr, "Error restoring best parameters: %s\n", g_ort_api->GetErrorMessage(status));
+            g_ort_api->ReleaseStatus(status);
+        } else {
+            printf("\nRestored parameters from epoch %d (validation loss %.6f)\n", best_epoch, best_loss);
+        }
+    }
     
     // Calculate total training time
     auto training_end_time = std::chrono::steady_clock::now();
     std::chrono::duration<double> total_training_time = training_end_time - training_start_time;
+    
+    // Per-tensor summary of the sampled statistics
+    printf("\n");
+    telemetry.PrintSummary(total_training_time.count());
     printf("Total training time: %.2f seconds\n", total_training_time.count());
+    printf("Time spent waiting for batches: %.2f seconds\n", loader.GetWaitSeconds());
     
     // Export the model
     std::wstring wide_onnx_path = to_wstring(onnx_model_path);
@@ -808,12 +1774,15 @@ int main(int argc, char* argv[]) {
     const char* output_names[] = {"output"}; 
     
     // Export the model
-    status = g_ort_training_api->ExportModelForInferencing(
-        training_session,
-        wide_onnx_path.c_str(),
-        1,  // Number of outputs
-        output_names
-    );
+    {
+        ScopedPhase phase(profiler, TrainerPhase::Export);
+        status = g_ort_training_api->ExportModelForInferencing(
+            training_session,
+            wide_onnx_path.c_str(),
+            1,  // Number of outputs
+            output_names
+        );
+    }
     
     if (status != NULL) {
         const char* error_message = g_ort_api->GetErrorMessage(status);
@@ -821,9 +1790,67 @@ int main(int argc, char* argv[]) {
         g_ort_api->ReleaseStatus(status);
     } else {
         printf("Model successfully exported to ONNX at: %s\n", onnx_model_path.c_str());
+        
+        // Static int8 model calibrated on this capture, next to the float one. Held-out
+        // windows come from the validation split when there is one.
+        if (options.quantize) {
+            std::string int8_path = onnx_model_path;
+            size_t extension = int8_path.rfind(".onnx");
+            int8_path.insert(extension == std::string::npos ? int8_path.size() : extension, "_int8");
+            if (extension == std::string::npos) {
+                int8_path += ".onnx";
+            }
+            
+            const std::string sample_prefix = "onnx_artifacts/quantize";
+            std::vector<size_t> train_windows(num_train_sequences);
+            std::iota(train_windows.begin(), train_windows.end(), 0);
+            if (!has_validation) {
+                printf("Quantisation: no validation split, drift is measured on training windows\n");
+            }
+            
+            size_t calibration_count = saveSampleWindows(frame_cache, sequences, train_windows,
+                options.quantizeSamples, sample_prefix + "_calibration.npy", "");
+            size_t heldout_count = saveSampleWindows(frame_cache, sequences,
+                has_validation ? validation_order : train_windows, options.quantizeSamples,
+                sample_prefix + "_heldout.npy", sample_prefix + "_heldout_labels.npy");
+            
+            if (calibration_count == 0 || heldout_count == 0) {
+                fprintf(stderr, "Error writing quantisation samples\n");
+            } else {
+                std::string command = "\"" + options.pythonExecutable + "\" quantize_model.py \"" +
+                    onnx_model_path + "\" \"" + int8_path + "\" \"" + sample_prefix + "\"";
+#ifdef _WIN32
+                command = "\"" + command + "\"";  // cmd.exe strips the outer pair
+#endif
+                // The child inherits the training thread's affinity, a single CPU when pinned
+                if (thread_plan.pinned) {
+                    PinCurrentThread(thread_plan.decodeCpus);
+                }
+                fflush(stdout);
+                int result = std::system(command.c_str());
+#ifndef _WIN32
+                if (result != -1 && WIFEXITED(result)) {
+                    result = WEXITSTATUS(result);
+                }
+#endif
+                if (result == 0) {
+                    printf("Quantised model exported to %s\n", int8_path.c_str());
+                } else {
+                    fprintf(stderr, "Quantisation %s (exit code %d); keep using the float model %s\n",
+                            result == 3 ? "drifted too far" : "failed", result, onnx_model_path.c_str());
+                }
+            }
+        }
     }
     
     // Clean up resources
+    for (BatchTensorViews& views : batch_views) {
+        releaseBatchTensorViews(g_ort_api, views);
+    }
+    g_ort_api->ReleaseValue(loss_tensor);
+    if (best_params_tensor != NULL) {
+        g_ort_api->ReleaseValue(best_params_tensor);
+    }
     g_ort_api->ReleaseMemoryInfo(memory_info);
     g_ort_training_api->ReleaseTrainingSession(training_session);
     g_ort_training_api->ReleaseCheckpointState(checkpoint_state);
@@ -832,4 +1859,63 @@ int main(int argc, char* argv[]) {
     
     printf("Training completed successfully!\n");
     return 0;
+}
+
+int main(int argc, char* argv[]) {
+    TrainerOptions options;
+    if (!parseTrainerOptions(argc, argv, options)) {
+        return 1;
+    }
+    
+    // Pick the batch assembly kernel before any worker uses it
+    if (options.kernelLevel >= 0) {
+        SetKernelLevel((KernelLevel)options.kernelLevel);
+    }
+    if (options.benchKernels) {
+        bool ok = RunGatherBenchmark(16, 2 * NUM_FRAMES, TRAIN_RESOLUTION * TRAIN_RESOLUTION, 200);
+        RunAugmentBenchmark(options.augment, 2 * NUM_FRAMES, TRAIN_RESOLUTION, 2000);
+        ok = RunResampleBenchmark(2 * TRAIN_RESOLUTION, TRAIN_RESOLUTION, 500) && ok;
+        ok = RunResampleBenchmark(4 * TRAIN_RESOLUTION, TRAIN_RESOLUTION, 200) && ok;
+        ok = RunResampleBenchmark(400, TRAIN_RESOLUTION, 200) && ok;
+        return ok ? 0 : 1;
+    }
+    
+    // Split the CPUs between the overlay and the trainer's pools before any worker starts
+    ThreadPlanOptions plan_options;
+    plan_options.reserveCores = options.reserveCores;
+    plan_options.intraOpThreads = options.intraOpThreads;
+    plan_options.interOpThreads = options.interOpThreads;
+    plan_options.loaderWorkers = options.loaderWorkers;
+    plan_options.decodeWorkers = options.decodeWorkers;
+    plan_options.pin = options.pinThreads;
+    const CpuTopology topology = DetectCpuTopology();
+    const ThreadPlan thread_plan = PlanThreads(topology, plan_options);
+    thread_plan.Print(topology);
+    SetThreadPlan(thread_plan);
+    
+    ProgressChannelWriter progress;
+    if (!options.progressFd.empty() && !progress.Open(options.progressFd)) {
+        fprintf(stderr, "Invalid progress channel: %s\n", options.progressFd.c_str());
+    }
+    
+    PhaseProfiler profiler;
+    MemoryTracker memory((size_t)options.memoryBudgetMB * 1024 * 1024);
+    int result = runTraining(options, progress, profiler, memory);
+    
+    // Printed for failed runs too, which is when they are most useful
+    printf("\n");
+    profiler.PrintSummary();
+    memory.PrintReport();
+    if (!options.profileReport.empty()) {
+        if (profiler.WriteReport(options.profileReport)) {
+            printf("Profile report written to %s\n", options.profileReport.c_str());
+        } else {
+            fprintf(stderr, "Failed to write profile report: %s\n", options.profileReport.c_str());
+        }
+    }
+    
+    ProgressRecord record;
+    record.event = (uint8_t)(result == 0 ? ProgressEvent::Completed : ProgressEvent::Failed);
+    progress.Send(record);
+    return result;
 }
\ No newline at end of file
@@ -0,0 +1,292 @@
+#include "trainer_options.h"
+#include "capture_set.h"
+#include "gather_kernels.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+
+static void printUsage(const char* program) {
+    printf("Usage: %s [capture_file_or_pattern] [output_model.onnx] [options]\n", program);
+    printf("\n");
+    printf("Options:\n");
+    printf("  --capture=PATTERN   Another capture file or pattern (e.g. sessions/*.bin); each file is a session\n");
+    printf("  --session-weights=LIST Share of each session per epoch, e.g. 1,0.5,2 in capture order (default: 1 each)\n");
+    printf("  --resume=PATH       Warm-start from a previous checkpoint, e.g. onnx_artifacts/training/checkpoint_best\n");
+    printf("  --fine-tune         Short fine-tuning schedule for --resume (4 epochs, cosine, lr 3e-5)\n");
+    printf("  --replay=FILE       Older capture replayed alongside the new one\n");
+    printf("  --replay-fraction=F Share of each epoch drawn from --replay (default: 0.25)\n");
+    printf("  --follow            Start training while the capture is still being recorded\n");
+    printf("  --follow-timeout=N  Seconds without new data before --follow gives up waiting (default: 120)\n");
+    printf("  --dedup[=T]         Prune near-duplicate training windows, T = image distance in levels (default: 2)\n");
+    printf("  --dedup-labels=F    Largest label change between pruned windows (default: 0.01)\n");
+    printf("  --dedup-keep-every=N Keep one window in N of a duplicate run instead of only the first\n");
+    printf("  --epochs=N          Maximum training epochs (default: 16)\n");
+    printf("  --batch-size=N      Samples per training step; sets the activation memory (default: 16)\n");
+    printf("  --accumulate=K      Sum the gradients of K batches per optimizer step (default: 1)\n");
+    printf("  --balance           Draw stage-balanced epochs instead of every window once\n");
+    printf("  --balance-epoch=F   Balanced epoch length as a share of the training windows (default: 0.5)\n");
+    printf("  --balance-max-repeats=F Most times a window is drawn per balanced epoch (default: 4)\n");
+    printf("  --stage-weights=LIST Per-class weights, e.g. gaze=1,lids=2 over gaze, lids, winks, brows,\n");
+    printf("                      convergence, dilation and other (default: 1 each)\n");
+    printf("  --lr=F              Base learning rate (default: 0.0001)\n");
+    printf("  --lr-schedule=NAME  constant, linear (warmup + decay), cosine or step (default: constant)\n");
+    printf("  --warmup=N          Warmup optimizer steps (default: 5%% of steps for linear and cosine)\n");
+    printf("  --lr-step=N         Epochs between decays of the step schedule (default: 4)\n");
+    printf("  --lr-gamma=F        Decay factor of the step schedule (default: 0.5)\n");
+    printf("  --val-fraction=F    Share of the capture held out for validation, 0 to disable (default: 0.1)\n");
+    printf("  --eval-interval=N   Evaluate the validation set every N epochs (default: 1)\n");
+    printf("  --patience=N        Stop after N evaluations without improvement, 0 to disable (default: 3)\n");
+    printf("  --workers=N         Batch assembly threads (default: auto)\n");
+    printf("  --prefetch=N        Pre-allocated batches in flight (default: workers + 2)\n");
+    printf("  --threads=N         ORT intra-op threads (default: one per performance core outside the reserve)\n");
+    printf("  --inter-threads=N   ORT inter-op threads (default: 1)\n");
+    printf("  --decode-workers=N  Frame decoding threads (default: every CPU outside the reserve)\n");
+    printf("  --reserve-cores=N   Performance cores left to the overlay and VR runtime (default: 2 from 6 cores, 1 from 3)\n");
+    printf("  --pin-threads       Pin ORT, loader and decode threads to their planned CPUs\n");
+    printf("  --resample=MODE     Frame downscaling filter: area, bilinear or nearest (default: area)\n");
+    printf("  --simd=LEVEL        Batch assembly kernel: auto, scalar, sse2 or avx2 (default: auto)\n");
+    printf("  --bench-kernels     Benchmark the batch assembly and resample kernels and exit\n");
+    printf("  --augment           Augment training windows while assembling batches\n");
+    printf("  --augment-seed=N    Seed of the augmentations; the same seed gives the same ones (default: 1)\n");
+    printf("  --aug-brightness=F  Maximum relative brightness change (default: 0.2)\n");
+    printf("  --aug-gamma=F       Gamma drawn from [1/(1+F), 1+F] (default: 0.25)\n");
+    printf("  --aug-noise=F       Sensor noise sigma in 8-bit levels (default: 2)\n");
+    printf("  --aug-shift=N       Maximum translation in pixels (default: 4)\n");
+    printf("  --aug-blur=F        Probability of blurring a window (default: 0.2)\n");
+    printf("  --quantize          Also export an int8 model calibrated on this capture (needs Python onnxruntime)\n");
+    printf("  --quantize-samples=N Calibration and held-out windows for --quantize (default: 128)\n");
+    printf("  --python=PATH       Python interpreter for --quantize (default: python3)\n");
+    printf("  --telemetry-interval=N Steps between parameter statistics samples, 0 to disable (default: 10)\n");
+    printf("  --profile-report=FILE Also write the phase timing profile as JSON\n");
+    printf("  --memory-budget=MB  Stop with a memory breakdown once the trainer would use more (default: none)\n");
+    printf("  --progress-fd=N     Write progress records to this inherited pipe (used by the overlay)\n");
+    printf("  --help              Show this message\n");
+}
+
+// Parses a non-negative integer flag value
+static bool parseCount(const char* value, int& out) {
+    char* end = nullptr;
+    long parsed = strtol(value, &end, 10);
+    if (end == value || *end != '\0' || parsed < 0) {
+        return false;
+    }
+    out = (int)parsed;
+    return true;
+}
+
+// Parses a flag value in [0, 1)
+static bool parseFraction(const char* value, float& out) {
+    char* end = nullptr;
+    float parsed = strtof(value, &end);
+    if (end == value || *end != '\0' || !(parsed >= 0.0f && parsed < 1.0f)) {
+        return false;
+    }
+    out = parsed;
+    return true;
+}
+
+// Parses a flag value greater than 0
+static bool parsePositive(const char* value, float& out) {
+    char* end = nullptr;
+    float parsed = strtof(value, &end);
+    if (end == value || *end != '\0' || !(parsed > 0.0f)) {
+        return false;
+    }
+    out = parsed;
+    return true;
+}
+
+// Parses a flag value of at least 0
+static bool parseNonNegative(const char* value, float& out) {
+    char* end = nullptr;
+    float parsed = strtof(value, &end);
+    if (end == value || *end != '\0' || !(parsed >= 0.0f)) {
+        return false;
+    }
+    out = parsed;
+    return true;
+}
+
+bool parseTrainerOptions(int argc, char* argv[], TrainerOptions& options) {
+    int positional = 0;
+    std::set<std::string> given;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+
+        if (strncmp(arg, "--", 2) != 0) {
+            if (positional == 0) {
+                options.captureFile = arg;
+            } else if (positional == 1) {
+                options.outputModel = arg;
+            } else {
+                fprintf(stderr, "Unexpected argument: %s\n", arg);
+                printUsage(argv[0]);
+                return false;
+            }
+            positional++;
+            continue;
+        }
+
+        const char* equals = strchr(arg, '=');
+        std::string name = equals ? std::string(arg + 2, equals - arg - 2) : std::string(arg + 2);
+        const char* value = equals ? equals + 1 : "";
+
+        given.insert(name);
+        bool ok = true;
+        if (name == "help") {
+            printUsage(argv[0]);
+            return false;
+        } else if (name == "resume") {
+            options.resumeCheckpoint = value;
+            ok = !options.resumeCheckpoint.empty();
+        } else if (name == "fine-tune") {
+            options.fineTune = true;
+        } else if (name == "capture") {
+            options.extraCaptures.push_back(value);
+            ok = !options.extraCaptures.back().empty();
+        } else if (name == "session-weights") {
+            ok = ParseSessionWeights(value, options.sessionWeights);
+        } else if (name == "replay") {
+            options.replayCapture = value;
+            ok = !options.replayCapture.empty();
+        } else if (name == "replay-fraction") {
+            ok = parseFraction(value, options.replayFraction);
+        } else if (name == "follow") {
+            options.follow = true;
+        } else if (name == "follow-timeout") {
+            ok = parseCount(value, options.followTimeout) && options.followTimeout > 0;
+        } else if (name == "epochs") {
+            ok = parseCount(value, options.epochs) && options.epochs > 0;
+        } else if (name == "batch-size") {
+            ok = parseCount(value, options.batchSize) && options.batchSize > 0;
+        } else if (name == "accumulate") {
+            ok = parseCount(value, options.accumulateSteps) && options.accumulateSteps > 0;
+        } else if (name == "dedup") {
+            options.dedupThreshold = 2.0f;
+            ok = !equals || parsePositive(value, options.dedupThreshold);
+        } else if (name == "dedup-labels") {
+            ok = parseNonNegative(value, options.dedupLabelTolerance);
+        } else if (name == "dedup-keep-every") {
+            ok = parseCount(value, options.dedupKeepEvery);
+        } else if (name == "balance") {
+            options.balance = true;
+        } else if (name == "balance-epoch") {
+            ok = parsePositive(value, options.balanceEpoch);
+        } else if (name == "balance-max-repeats") {
+            ok = parsePositive(value, options.balanceMaxRepeats);
+        } else if (name == "stage-weights") {
+            ok = ParseStageWeights(value, options.stageWeights);
+        } else if (name == "lr") {
+            ok = parsePositive(value, options.learningRate);
+        } else if (name == "lr-schedule") {
+            ok = ParseLRSchedule(value, options.lrSchedule);
+        } else if (name == "warmup") {
+            ok = parseCount(value, options.warmupSteps);
+        } else if (name == "lr-step") {
+            ok = parseCount(value, options.lrStepEpochs) && options.lrStepEpochs > 0;
+        } else if (name == "lr-gamma") {
+            ok = parsePositive(value, options.lrGamma) && options.lrGamma <= 1.0f;
+        } else if (name == "val-fraction") {
+            ok = parseFraction(value, options.validationFraction);
+        } else if (name == "eval-interval") {
+            ok = parseCount(value, options.evalInterval) && options.evalInterval > 0;
+        } else if (name == "patience") {
+            ok = parseCount(value, options.patience);
+        } else if (name == "workers") {
+            ok = parseCount(value, options.loaderWorkers);
+        } else if (name == "prefetch") {
+            ok = parseCount(value, options.prefetchBatches);
+        } else if (name == "threads") {
+            ok = parseCount(value, options.intraOpThreads) && options.intraOpThreads > 0;
+        } else if (name == "inter-threads") {
+            ok = parseCount(value, options.interOpThreads) && options.interOpThreads > 0;
+        } else if (name == "decode-workers") {
+            ok = parseCount(value, options.decodeWorkers) && options.decodeWorkers > 0;
+        } else if (name == "reserve-cores") {
+            ok = parseCount(value, options.reserveCores);
+        } else if (name == "pin-threads") {
+            options.pinThreads = true;
+        } else if (name == "resample") {
+            ok = ParseResampleMode(value, options.resampleMode);
+        } else if (name == "simd") {
+            std::string level = value;
+            if (level == "auto") {
+                options.kernelLevel = -1;
+            } else if (level == "scalar") {
+                options.kernelLevel = (int)KernelLevel::Scalar;
+            } else if (level == "sse2") {
+                options.kernelLevel = (int)KernelLevel::SSE2;
+            } else if (level == "avx2") {
+                options.kernelLevel = (int)KernelLevel::AVX2;
+            } else {
+                ok = false;
+            }
+        } else if (name == "bench-kernels") {
+            options.benchKernels = true;
+        } else if (name == "augment") {
+            options.augment.enabled = true;
+        } else if (name == "augment-seed") {
+            char* end = nullptr;
+            options.augment.seed = strtoull(value, &end, 10);
+            ok = end != value && *end == '\0';
+        } else if (name == "aug-brightness") {
+            ok = parseFraction(value, options.augment.brightness);
+        } else if (name == "aug-gamma") {
+            ok = parseNonNegative(value, options.augment.gamma);
+        } else if (name == "aug-noise") {
+            ok = parseNonNegative(value, options.augment.noise);
+        } else if (name == "aug-shift") {
+            ok = parseCount(value, options.augment.shift);
+        } else if (name == "aug-blur") {
+            ok = parseNonNegative(value, options.augment.blur) && options.augment.blur <= 1.0f;
+        } else if (name == "quantize") {
+            options.quantize = true;
+        } else if (name == "quantize-samples") {
+            ok = parseCount(value, options.quantizeSamples) && options.quantizeSamples > 0;
+        } else if (name == "python") {
+            options.pythonExecutable = value;
+            ok = !options.pythonExecutable.empty();
+        } else if (name == "telemetry-interval") {
+            ok = parseCount(value, options.telemetryInterval);
+        } else if (name == "profile-report") {
+            options.profileReport = value;
+            ok = !options.profileReport.empty();
+        } else if (name == "memory-budget") {
+            ok = parseCount(value, options.memoryBudgetMB);
+        } else if (name == "progress-fd") {
+            options.progressFd = value;
+            ok = !options.progressFd.empty();
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", arg);
+            printUsage(argv[0]);
+            return false;
+        }
+
+        if (!ok) {
+            fprintf(stderr, "Invalid value for --%s: '%s'\n", name.c_str(), value);
+            return false;
+        }
+    }
+
+    if (options.fineTune) {
+        if (options.resumeCheckpoint.empty()) {
+            fprintf(stderr, "--fine-tune needs a checkpoint to start from (--resume=PATH)\n");
+            return false;
+        }
+        if (!given.count("epochs")) options.epochs = 4;
+        if (!given.count("lr")) options.learningRate = 3e-5f;
+        if (!given.count("lr-schedule")) options.lrSchedule = LRScheduleType::Cosine;
+        if (!given.count("patience")) options.patience = 2;
+    }
+    if (options.follow) {
+        // Most of the steps already happened online at the base rate
+        if (!given.count("epochs")) options.epochs = 4;
+        if (!given.count("lr-schedule")) options.lrSchedule = LRScheduleType::Cosine;
+        if (!given.count("warmup")) options.warmupSteps = 0;
+    }
+
+    return true;
+}
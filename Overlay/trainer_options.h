@@ -0,0 +1,128 @@
+// trainer_options.h
+#ifndef TRAINER_OPTIONS_H
+#define TRAINER_OPTIONS_H
+
+#include <string>
+#include <vector>
+
+#include "augmentation.h"
+#include "stage_sampler.h"
+#include "image_resample.h"
+#include "lr_schedule.h"
+
+// Run configuration of calibration_runner. The two positional arguments keep their
+// historical meaning; everything else is an optional --name=value flag.
+struct TrainerOptions {
+    // A capture file or a pattern with * and ?; extraCaptures (--capture) adds more. Each
+    // file is one session, and sessionWeights scales each one's share of an epoch.
+    std::string captureFile = "capture(2).bin";
+    std::string outputModel = "tuned_temporal_eye_tracking.onnx";
+    std::vector<std::string> extraCaptures;
+    std::vector<float> sessionWeights;
+
+    // Warm start from a previous run's checkpoint instead of the generic one. fineTune
+    // switches to a short schedule (4 epochs, cosine from 3e-5, patience 2) for any of
+    // those settings not given explicitly. replayCapture mixes windows of an older capture
+    // into each epoch, replayFraction being their share of the epoch.
+    std::string resumeCheckpoint;
+    bool fineTune = false;
+    std::string replayCapture;
+    float replayFraction = 0.25f;
+
+    // Train online while the capture is still being recorded, then finish with a short
+    // schedule (4 epochs, cosine, no warmup unless given) on the complete capture.
+    // followTimeout ends the online phase when the file stops growing without the writer
+    // marking it complete.
+    bool follow = false;
+    int followTimeout = 120;
+
+    // Near-duplicate pruning of training windows: signature distance in 8-bit levels
+    // (0 = off), largest label change, and one window kept per dedupKeepEvery of a run
+    // (0 = keep only the first)
+    float dedupThreshold = 0.0f;
+    float dedupLabelTolerance = 0.01f;
+    int dedupKeepEvery = 0;
+
+    // Upper bound on epochs; early stopping usually ends training sooner
+    int epochs = 16;
+
+    // Samples per TrainStep, and micro-batches whose gradients are summed per
+    // OptimizerStep. Peak memory follows batchSize, the effective batch is the product.
+    int batchSize = 16;
+    int accumulateSteps = 1;
+
+    // Stage-balanced epochs of balanceEpoch times the training windows, split between
+    // the routine stage classes by stageWeights. A window appears at most
+    // balanceMaxRepeats times per epoch.
+    bool balance = false;
+    float balanceEpoch = 0.5f;
+    float balanceMaxRepeats = 4.0f;
+    float stageWeights[STAGE_CLASS_COUNT] = {1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f};
+
+    // Learning rate schedule. warmupSteps of -1 uses 5% of the optimizer steps for the
+    // linear and cosine schedules; the step schedule multiplies by lrGamma every
+    // lrStepEpochs epochs.
+    float learningRate = 1e-4f;
+    LRScheduleType lrSchedule = LRScheduleType::Constant;
+    int warmupSteps = -1;
+    int lrStepEpochs = 4;
+    float lrGamma = 0.5f;
+
+    // Share of the capture held out for validation (0 disables validation and early
+    // stopping), how often to evaluate it in epochs, and how many evaluations without
+    // improvement end training (0 = never stop early)
+    float validationFraction = 0.1f;
+    int evalInterval = 1;
+    int patience = 3;
+
+    // Batch assembly (0 = pick automatically)
+    int loaderWorkers = 0;
+    int prefetchBatches = 0;
+
+    // Thread budgets of the ORT pools and frame decoding (0 = planned from the CPU
+    // topology), performance cores left to the overlay (-1 = automatic), and whether to
+    // pin each pool to its planned CPUs
+    int intraOpThreads = 0;
+    int interOpThreads = 0;
+    int decodeWorkers = 0;
+    int reserveCores = -1;
+    bool pinThreads = false;
+
+    // Filter used when baking frames down to training resolution
+    ResampleMode resampleMode = ResampleMode::Area;
+
+    // Gather kernel instruction set: -1 = auto, otherwise a KernelLevel value
+    int kernelLevel = -1;
+    // Run the gather kernel microbenchmark and exit
+    bool benchKernels = false;
+
+    // Random brightness/gamma, noise, translation and blur of training windows
+    AugmentOptions augment;
+
+    // Also write a static int8 model (<output>_int8.onnx) calibrated on quantizeSamples
+    // training windows and checked on as many held-out ones, using quantize_model.py
+    bool quantize = false;
+    int quantizeSamples = 128;
+#ifdef _WIN32
+    std::string pythonExecutable = "python";
+#else
+    std::string pythonExecutable = "python3";
+#endif
+    
+    // Optimizer steps between parameter telemetry samples (0 = off)
+    int telemetryInterval = 10;
+
+    // JSON file for the per-phase timing histograms printed at exit
+    std::string profileReport;
+
+    // Resident set limit in MB; the run stops with a breakdown instead of swapping (0 = none)
+    int memoryBudgetMB = 0;
+
+    // Inherited pipe for structured progress records, set by the overlay
+    std::string progressFd;
+};
+
+// Parses argv into options. Prints usage and returns false on --help or a bad flag.
+bool parseTrainerOptions(int argc, char* argv[], TrainerOptions& options);
+
+#endif // TRAINER_OPTIONS_H
@@ -4,74 +4,99 @@
 #include <algorithm>
 #include <cmath>
 
-TrainerProgressParser::TrainerProgressParser() :
-    // Regex patterns based on trainer.cpp output
-    m_epochStartPattern("=== Epoch (\\d+)/(\\d+) ==="),
-    m_batchProgressPattern("Batch (\\d+)/(\\d+), Loss: ([0-9.]+)"),
-    m_epochCompletePattern("Epoch (\\d+)/(\\d+) completed in ([0-9.]+)s\\. Average loss: ([0-9.]+)"),
-    m_trainingCompletePattern("Training completed successfully!"),
-    m_errorPattern("Error|ERROR|Failed|FAILED")
-{
+TrainerProgressParser::TrainerProgressParser() {
     Reset();
 }
 
 void TrainerProgressParser::Reset() {
     m_progress = TrainerProgress();
     m_progress.startTime = std::chrono::steady_clock::now();
+    m_decoder.Reset();
+    m_lastErrorOutput.clear();
 }
 
-void TrainerProgressParser::ParseLine(const std::string& line) {
-    std::smatch match;
-    
-    // Check for epoch start
-    if (std::regex_search(line, match, m_epochStartPattern)) {
-        m_progress.currentEpoch = std::stoi(match[1]);
-        m_progress.totalEpochs = std::stoi(match[2]);
-        m_progress.epochStartTime = std::chrono::steady_clock::now();
-        m_progress.isTraining = true;
-        return;
-    }
+bool TrainerProgressParser::Feed(const char* data, size_t length) {
+    bool applied = false;
+    m_decoder.Feed(data, length, [this, &applied](const ProgressRecord& record) {
+        ApplyRecord(record);
+        applied = true;
+    });
+    return applied;
+}
+
+void TrainerProgressParser::ApplyRecord(const ProgressRecord& record) {
+    const ProgressEvent event = (ProgressEvent)record.event;
     
-    // Check for batch progress
-    if (std::regex_search(line, match, m_batchProgressPattern)) {
-        m_progress.currentBatch = std::stoi(match[1]);
-        m_progress.totalBatches = std::stoi(match[2]);
-        m_progress.currentLoss = std::stof(match[3]);
-        UpdateLossHistory(m_progress.currentLoss);
-        return;
+    // The final records carry no training position
+    if (event != ProgressEvent::Completed && event != ProgressEvent::Failed) {
+        m_progress.currentEpoch = record.epoch;
+        m_progress.totalEpochs = record.totalEpochs;
+        m_progress.totalBatches = record.totalBatches;
+        m_progress.samplesPerSecond = record.samplesPerSecond;
+        m_progress.etaSeconds = record.etaSeconds;
     }
     
-    // Check for epoch completion
-    if (std::regex_search(line, match, m_epochCompletePattern)) {
-        m_progress.epochDuration = std::stof(match[3]);
-        m_progress.epochAverageLoss = std::stof(match[4]);
-        UpdateLossHistory(m_progress.epochAverageLoss);
-        return;
+    switch (event) {
+        case ProgressEvent::Started:
+            m_progress.isTraining = true;
+            break;
+        case ProgressEvent::EpochStarted:
+            m_progress.currentBatch = 0;
+            m_progress.epochStartTime = std::chrono::steady_clock::now();
+            m_progress.isTraining = true;
+            break;
+        case ProgressEvent::Batch:
+            m_progress.currentBatch = record.batch;
+            m_progress.currentLoss = record.loss;
+            UpdateLossHistory(record.loss);
+            break;
+        case ProgressEvent::EpochFinished:
+            m_progress.currentBatch = record.batch;
+            m_progress.epochAverageLoss = record.loss;
+            m_progress.epochDuration = std::chrono::duration<float>(
+                std::chrono::steady_clock::now() - m_progress.epochStartTime).count();
+            UpdateLossHistory(record.loss);
+            break;
+        case ProgressEvent::Validation:
+            m_progress.validationLoss = record.loss;
+            break;
+        case ProgressEvent::Telemetry:
+            if (record.layer < 0) {
+                m_progress.parameterNorm = record.parameterNorm;
+                m_progress.updateRatio = record.updateRatio;
+            }
+            break;
+        case ProgressEvent::Completed:
+            m_progress.isComplete = true;
+            m_progress.isTraining = false;
+            break;
+        case ProgressEvent::Failed:
+            m_progress.hasError = true;
+            m_progress.isTraining = false;
+            m_progress.lastError = m_lastErrorOutput;
+            break;
+        default:
+            break;
     }
-    
-    // Check for training completion
-    if (std::regex_search(line, match, m_trainingCompletePattern)) {
-        m_progress.isComplete = true;
-        m_progress.isTraining = false;
+}
+
+void TrainerProgressParser::NoteErrorOutput(const std::string& output) {
+    // Keep the last non-empty line of the chunk
+    size_t end = output.find_last_not_of("\r\n");
+    if (end == std::string::npos) {
         return;
     }
-    
-    // Check for errors
-    if (std::regex_search(line, match, m_errorPattern)) {
+    size_t start = output.find_last_of('\n', end);
+    start = (start == std::string::npos) ? 0 : start + 1;
+    m_lastErrorOutput = output.substr(start, end - start + 1);
+}
+
+void TrainerProgressParser::ProcessExited(int exitCode) {
+    if (exitCode != 0 && !m_progress.isComplete && !m_progress.hasError) {
         m_progress.hasError = true;
-        m_progress.lastError = line;
-        return;
-    }
-    
-    // Parse training configuration if found
-    if (line.find("Starting training with") != std::string::npos) {
-        // Extract total epochs and batches if available
-        std::regex configPattern("(\\d+) epochs, batch size (\\d+)");
-        if (std::regex_search(line, match, configPattern)) {
-            m_progress.totalEpochs = std::stoi(match[1]);
-        }
-        m_progress.isTraining = true;
-        return;
+        m_progress.isTraining = false;
+        m_progress.lastError = m_lastErrorOutput.empty() ?
+            "Trainer exited with code " + std::to_string(exitCode) : m_lastErrorOutput;
     }
 }
 
@@ -225,6 +250,10 @@ std::string TrainerProgressParser::GenerateProgressBar(float progress, int width
 
 
 float TrainerProgressParser::CalculateETA() const {
+    if (m_progress.etaSeconds >= 0.0f) {
+        return m_progress.etaSeconds;
+    }
+    
     if (m_progress.totalEpochs == 0 || m_progress.currentEpoch == 0) {
         return 0.0f;
     }
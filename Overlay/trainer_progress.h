@@ -3,7 +3,8 @@
 #include <string>
 #include <vector>
 #include <chrono>
-#include <regex>
+
+#include "progress_channel.h"
 
 struct TrainerProgress {
     // Current state
@@ -15,12 +16,19 @@ struct TrainerProgress {
     // Loss tracking
     float currentLoss = 0.0f;
     float epochAverageLoss = 0.0f;
+    float validationLoss = 0.0f;
     std::vector<float> lossHistory;
     
+    // Whole-model parameter telemetry, 0 until the trainer reports it
+    float parameterNorm = 0.0f;
+    float updateRatio = 0.0f;
+    
     // Timing
     std::chrono::steady_clock::time_point startTime;
     std::chrono::steady_clock::time_point epochStartTime;
     float epochDuration = 0.0f;
+    float samplesPerSecond = 0.0f;
+    float etaSeconds = -1.0f;   // reported by the trainer, -1 when unknown
     
     // State flags
     bool isTraining = false;
@@ -33,8 +41,18 @@ class TrainerProgressParser {
 public:
     TrainerProgressParser();
     
-    // Parse a line of trainer output
-    void ParseLine(const std::string& line);
+    // Feed raw bytes from the trainer's progress channel. Returns true if at least one
+    // record was applied.
+    bool Feed(const char* data, size_t length);
+    
+    // Apply one decoded progress record
+    void ApplyRecord(const ProgressRecord& record);
+    
+    // Remember the last line the trainer wrote to stderr; shown if the run fails
+    void NoteErrorOutput(const std::string& output);
+    
+    // The trainer exited; a non-zero code without a completion record is a failure
+    void ProcessExited(int exitCode);
     
     // Get current progress
     const TrainerProgress& GetProgress() const { return m_progress; }
@@ -47,13 +65,8 @@ public:
 
 private:
     TrainerProgress m_progress;
-    
-    // Regex patterns for parsing
-    std::regex m_epochStartPattern;
-    std::regex m_batchProgressPattern;
-    std::regex m_epochCompletePattern;
-    std::regex m_trainingCompletePattern;
-    std::regex m_errorPattern;
+    ProgressRecordDecoder m_decoder;
+    std::string m_lastErrorOutput;
     
     // Helper methods
     std::string FormatTime(float seconds) const;
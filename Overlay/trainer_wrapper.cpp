@@ -1,7 +1,6 @@
 #include "trainer_wrapper.h"
 #include "subprocess.h"
 #include <iostream>
-#include <sstream>
 
 TrainerWrapper::TrainerWrapper(const std::string& trainerPath)
     : m_trainerPath(trainerPath)
@@ -14,7 +13,8 @@ bool TrainerWrapper::start(
     const std::string& outputFile,
     OutputCallback onOutput,
     ProgressCallback onProgress,
-    CompletionCallback onCompleted
+    CompletionCallback onCompleted,
+    const std::vector<std::string>& extraArgs
 ) {
     if (m_isRunning) {
         std::cerr << "Training process is already running" << std::endl;
@@ -26,39 +26,40 @@ bool TrainerWrapper::start(
 
     // Prepare arguments for the trainer
     std::vector<std::string> args = { datasetFile, outputFile };
+    args.insert(args.end(), extraArgs.begin(), extraArgs.end());
 
-    // Start the trainer process
-    bool success = spawnProcess(
+    // Start the trainer process. Its stdout/stderr are passed through as logs; progress
+    // arrives as fixed-size records on a dedicated channel.
+    bool success = spawnProcessWithChannel(
         m_trainerPath,
         args,
+        "--progress-fd=",
         // Redirect stdout to the output callback
-        [this, onOutput, onProgress](const std::string& output) {
+        [onOutput](const std::string& output) {
             onOutput(output);
-            // Parse each line for progress updates
-            std::istringstream iss(output);
-            std::string line;
-            while (std::getline(iss, line)) {
-                m_progressParser.ParseLine(line);
-                onProgress(m_progressParser.GetProgress());
-            }
         },
-        // Redirect stderr to the output callback as well
-        [this, onOutput, onProgress](const std::string& output) {
+        // Redirect stderr to the output callback as well, remembering it for error reports
+        [this, onOutput](const std::string& output) {
             onOutput(output);
-            // Parse stderr for errors too
-            std::istringstream iss(output);
-            std::string line;
-            while (std::getline(iss, line)) {
-                m_progressParser.ParseLine(line);
+            std::lock_guard<std::mutex> lock(m_progressMutex);
+            m_progressParser.NoteErrorOutput(output);
+        },
+        // Decode progress records
+        [this, onProgress](const std::string& data) {
+            std::lock_guard<std::mutex> lock(m_progressMutex);
+            if (m_progressParser.Feed(data.data(), data.size())) {
                 onProgress(m_progressParser.GetProgress());
             }
         },
         // Handle process completion
-        [this, onCompleted](int exitCode) {
+        [this, onProgress, onCompleted](int exitCode) {
             m_isRunning = false;
             
             if (exitCode != 0) {
                 std::cerr << "Trainer process exited with code: " << exitCode << std::endl;
+                std::lock_guard<std::mutex> lock(m_progressMutex);
+                m_progressParser.ProcessExited(exitCode);
+                onProgress(m_progressParser.GetProgress());
             }
             
             onCompleted();
@@ -3,6 +3,8 @@
 
 #include <string>
 #include <functional>
+#include <mutex>
+#include <vector>
 #include "trainer_progress.h"
 
 /**
@@ -31,6 +33,7 @@ public:
      * @param outputFile Path where the trained model will be saved
      * @param onOutput Callback function that receives output from the trainer
      * @param onCompleted Callback function that is called when training completes
+     * @param extraArgs Flags passed to the trainer after the two file names
      * @return true if the trainer was successfully started, false otherwise
      */
     bool start(
@@ -38,7 +41,8 @@ public:
         const std::string& outputFile,
         OutputCallback onOutput,
         ProgressCallback onProgress,
-        CompletionCallback onCompleted
+        CompletionCallback onCompleted,
+        const std::vector<std::string>& extraArgs = {}
     );
 
     /**
@@ -59,6 +63,7 @@ private:
     std::string m_trainerPath;
     bool m_isRunning;
     TrainerProgressParser m_progressParser;
+    std::mutex m_progressMutex;  // channel, stderr and exit callbacks run on separate threads
 };
 
 #endif // TRAINER_WRAPPER_H
\ No newline at end of file
@@ -0,0 +1,245 @@
+#include "training_telemetry.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+TrainingTelemetry::~TrainingTelemetry() {
+    if (m_bufferTensor != nullptr) {
+        m_api->ReleaseValue(m_bufferTensor);
+    }
+}
+
+bool TrainingTelemetry::Init(const OrtApi* api, const OrtTrainingApi* trainingApi, OrtTrainingSession* session,
+                             OrtCheckpointState* state, OrtMemoryInfo* memoryInfo, const std::string& namesFile,
+                             int interval, double budget) {
+    m_api = api;
+    m_trainingApi = trainingApi;
+    m_session = session;
+    m_state = state;
+    m_interval = interval;
+    m_budget = budget;
+    m_startTime = std::chrono::steady_clock::now();
+
+    if (interval <= 0) {
+        return false;
+    }
+
+    OrtStatus* status = api->GetAllocatorWithDefaultOptions(&m_allocator);
+    if (status != nullptr) {
+        fprintf(stderr, "Error getting allocator for telemetry: %s\n", api->GetErrorMessage(status));
+        api->ReleaseStatus(status);
+        return false;
+    }
+
+    std::ifstream names(namesFile);
+    std::string line;
+    while (std::getline(names, line)) {
+        line.erase(line.find_last_not_of(" \r\n\t") + 1);
+        if (!line.empty()) {
+            ParameterStats stats;
+            stats.name = line;
+            m_stats.push_back(stats);
+        }
+    }
+
+    if (m_stats.empty()) {
+        // Older artifacts without the name list: one entry for the whole trainable buffer
+        size_t size = 0;
+        status = trainingApi->GetParametersSize(session, &size, true);
+        if (status != nullptr) {
+            fprintf(stderr, "Error getting trainable parameters size: %s\n", api->GetErrorMessage(status));
+            api->ReleaseStatus(status);
+            return false;
+        }
+
+        m_buffer.resize(size);
+        const int64_t shape[] = {(int64_t)size};
+        status = api->CreateTensorWithDataAsOrtValue(memoryInfo, m_buffer.data(), size * sizeof(float),
+                                                     shape, 1, ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT, &m_bufferTensor);
+        if (status != nullptr) {
+            fprintf(stderr, "Error creating telemetry buffer: %s\n", api->GetErrorMessage(status));
+            api->ReleaseStatus(status);
+            return false;
+        }
+
+        ParameterStats stats;
+        stats.name = "(all trainable parameters)";
+        m_stats.push_back(stats);
+        m_wholeModel = true;
+        printf("Telemetry: %s not found, sampling the whole model at epoch ends\n", namesFile.c_str());
+    }
+
+    // Baseline visit of every tensor, so update estimates start after the first round
+    for (size_t i = 0; i < m_stats.size(); i++) {
+        if (!visit(i, 0)) {
+            m_stats.clear();
+            return false;
+        }
+    }
+
+    // The budget applies to the visits made while training
+    m_baselineSeconds = m_seconds;
+    m_startTime = std::chrono::steady_clock::now();
+    m_enabled = true;
+    return true;
+}
+
+bool TrainingTelemetry::fetch(size_t index, const float*& data, size_t& count, OrtValue*& owned) {
+    owned = nullptr;
+
+    if (m_wholeModel) {
+        OrtStatus* status = m_trainingApi->CopyParametersToBuffer(m_session, m_bufferTensor, true);
+        if (status != nullptr) {
+            fprintf(stderr, "Error copying parameters for telemetry: %s\n", m_api->GetErrorMessage(status));
+            m_api->ReleaseStatus(status);
+            return false;
+        }
+        data = m_buffer.data();
+        count = m_buffer.size();
+        return true;
+    }
+
+    OrtStatus* status = m_trainingApi->GetParameter(m_state, m_stats[index].name.c_str(), m_allocator, &owned);
+    if (status != nullptr) {
+        fprintf(stderr, "Error getting parameter %s: %s\n", m_stats[index].name.c_str(), m_api->GetErrorMessage(status));
+        m_api->ReleaseStatus(status);
+        return false;
+    }
+
+    OrtTensorTypeAndShapeInfo* info = nullptr;
+    void* raw = nullptr;
+    status = m_api->GetTensorTypeAndShape(owned, &info);
+    if (status == nullptr) {
+        status = m_api->GetTensorShapeElementCount(info, &count);
+        m_api->ReleaseTensorTypeAndShapeInfo(info);
+    }
+    if (status == nullptr) {
+        status = m_api->GetTensorMutableData(owned, &raw);
+    }
+    if (status != nullptr) {
+        fprintf(stderr, "Error reading parameter %s: %s\n", m_stats[index].name.c_str(), m_api->GetErrorMessage(status));
+        m_api->ReleaseStatus(status);
+        m_api->ReleaseValue(owned);
+        owned = nullptr;
+        return false;
+    }
+
+    data = static_cast<const float*>(raw);
+    return true;
+}
+
+void TrainingTelemetry::record(ParameterStats& stats, const float* data, size_t count, int64_t step) {
+    double sumSquares = 0.0;
+    for (size_t i = 0; i < count; i++) {
+        sumSquares += (double)data[i] * data[i];
+    }
+
+    const size_t stride = std::max<size_t>(1, (count + SAMPLE_LIMIT - 1) / SAMPLE_LIMIT);
+    const size_t sampled = (count + stride - 1) / stride;
+
+    // Change since the last visit, scaled from the subsample to the full tensor
+    if (stats.sample.size() == sampled && stats.elementCount == count && step > stats.lastStep && sampled > 0) {
+        double deltaSquares = 0.0;
+        for (size_t i = 0; i < sampled; i++) {
+            double delta = (double)data[i * stride] - stats.sample[i];
+            deltaSquares += delta * delta;
+        }
+        const double norm = std::sqrt(sumSquares);
+        stats.updateNorm = (float)std::sqrt(deltaSquares * count / sampled);
+        stats.updateRatio = norm > 0.0 ? (float)(stats.updateNorm / norm / (double)(step - stats.lastStep)) : 0.0f;
+    }
+
+    stats.sample.resize(sampled);
+    for (size_t i = 0; i < sampled; i++) {
+        stats.sample[i] = data[i * stride];
+    }
+    stats.elementCount = count;
+    stats.norm = (float)std::sqrt(sumSquares);
+    stats.lastStep = step;
+    stats.visits++;
+}
+
+bool TrainingTelemetry::visit(size_t index, int64_t step) {
+    auto start = std::chrono::steady_clock::now();
+
+    const float* data = nullptr;
+    size_t count = 0;
+    OrtValue* owned = nullptr;
+    bool ok = fetch(index, data, count, owned);
+    if (ok) {
+        record(m_stats[index], data, count, step);
+    }
+    if (owned != nullptr) {
+        m_api->ReleaseValue(owned);
+    }
+
+    m_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return ok;
+}
+
+int TrainingTelemetry::AfterStep(int64_t step) {
+    if (!m_enabled || m_wholeModel || step % m_interval != 0) {
+        return -1;
+    }
+
+    // Stay within the time budget; slow tensors just get visited less often
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_startTime).count();
+    if (m_seconds - m_baselineSeconds > m_budget * elapsed) {
+        return -1;
+    }
+
+    const size_t index = m_next;
+    m_next = (m_next + 1) % m_stats.size();
+    return visit(index, step) ? (int)index : -1;
+}
+
+int TrainingTelemetry::EndEpoch(int64_t step) {
+    if (!m_enabled || !m_wholeModel) {
+        return -1;
+    }
+    return visit(0, step) ? 0 : -1;
+}
+
+float TrainingTelemetry::ModelNorm() const {
+    double sumSquares = 0.0;
+    for (const ParameterStats& stats : m_stats) {
+        sumSquares += (double)stats.norm * stats.norm;
+    }
+    return (float)std::sqrt(sumSquares);
+}
+
+float TrainingTelemetry::ModelUpdateRatio() const {
+    double weighted = 0.0;
+    size_t elements = 0;
+    for (const ParameterStats& stats : m_stats) {
+        if (stats.visits >= 2) {
+            weighted += (double)stats.updateRatio * stats.elementCount;
+            elements += stats.elementCount;
+        }
+    }
+    return elements > 0 ? (float)(weighted / elements) : 0.0f;
+}
+
+void TrainingTelemetry::PrintSummary(double trainingSeconds) const {
+    if (!m_enabled) {
+        return;
+    }
+
+    printf("===== Parameter telemetry =====\n");
+    printf("%-40s %10s %12s %12s %8s\n", "Tensor", "Elements", "Norm", "Update/step", "Visits");
+    for (const ParameterStats& stats : m_stats) {
+        if (stats.visits >= 2) {
+            printf("%-40s %10zu %12.5g %12.3g %8d\n", stats.name.c_str(), stats.elementCount,
+                   stats.norm, stats.updateRatio, stats.visits);
+        } else {
+            printf("%-40s %10zu %12.5g %12s %8d\n", stats.name.c_str(), stats.elementCount,
+                   stats.norm, "-", stats.visits);
+        }
+    }
+    printf("Model norm: %g, mean update ratio per step: %g\n", ModelNorm(), ModelUpdateRatio());
+    printf("Telemetry time: %.3fs (%.3f%% of training)\n", m_seconds,
+           trainingSeconds > 0.0 ? m_seconds / trainingSeconds * 100.0 : 0.0);
+    printf("================================\n");
+}
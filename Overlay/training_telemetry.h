@@ -0,0 +1,98 @@
+// training_telemetry.h
+#ifndef TRAINING_TELEMETRY_H
+#define TRAINING_TELEMETRY_H
+
+#include <onnxruntime_cxx_api.h>
+#include <onnxruntime_training_c_api.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Latest statistics of one trainable parameter tensor
+struct ParameterStats {
+    std::string name;
+    size_t elementCount = 0;
+    float norm = 0.0f;          // L2 norm at the last visit
+    float updateNorm = 0.0f;    // estimated L2 norm of the change between the last two visits
+    float updateRatio = 0.0f;   // updateNorm / norm per optimizer step in between
+    int64_t lastStep = -1;      // optimizer step of the last visit
+    int visits = 0;
+
+    std::vector<float> sample;  // strided subsample of the last visit
+};
+
+/**
+ * @brief Cheap parameter statistics sampled during training
+ *
+ * Every interval optimizer steps one parameter tensor is fetched from the checkpoint
+ * state, round-robin, so the cost of a visit is bounded by the largest tensor rather
+ * than the whole model. Norms are exact; the update between visits is estimated from a
+ * strided subsample of at most SAMPLE_LIMIT elements. Visits are also skipped while the
+ * time spent here exceeds the budget share of the elapsed time.
+ *
+ * The tensor names come from trainable_params.txt written by mkmodel7.py. Without it
+ * the whole trainable buffer is treated as one tensor and visited only at epoch ends.
+ */
+class TrainingTelemetry {
+public:
+    static const size_t SAMPLE_LIMIT = 4096;
+
+    ~TrainingTelemetry();
+
+    // Visits every tensor once as the baseline. interval 0 disables sampling; returns
+    // false if telemetry is unavailable.
+    bool Init(const OrtApi* api, const OrtTrainingApi* trainingApi, OrtTrainingSession* session,
+              OrtCheckpointState* state, OrtMemoryInfo* memoryInfo, const std::string& namesFile,
+              int interval, double budget = 0.005);
+
+    // Call after optimizer step number step (1-based). Returns the index of the tensor
+    // visited, or -1.
+    int AfterStep(int64_t step);
+    // Call at the end of an epoch; visits the whole buffer in whole-model mode
+    int EndEpoch(int64_t step);
+
+    bool IsEnabled() const { return m_enabled; }
+    size_t GetCount() const { return m_stats.size(); }
+    const ParameterStats& GetStats(size_t index) const { return m_stats[index]; }
+
+    // Root of the summed squared norms of every tensor's latest visit
+    float ModelNorm() const;
+    // Element-weighted mean update ratio over tensors visited at least twice
+    float ModelUpdateRatio() const;
+
+    double GetSeconds() const { return m_seconds; }
+
+    // Per-tensor table plus the share of trainingSeconds spent here
+    void PrintSummary(double trainingSeconds) const;
+
+private:
+    bool visit(size_t index, int64_t step);
+    bool fetch(size_t index, const float*& data, size_t& count, OrtValue*& owned);
+    void record(ParameterStats& stats, const float* data, size_t count, int64_t step);
+
+    const OrtApi* m_api = nullptr;
+    const OrtTrainingApi* m_trainingApi = nullptr;
+    OrtTrainingSession* m_session = nullptr;
+    OrtCheckpointState* m_state = nullptr;
+    OrtAllocator* m_allocator = nullptr;
+
+    bool m_enabled = false;
+    bool m_wholeModel = false;
+    int m_interval = 0;
+    double m_budget = 0.0;
+    size_t m_next = 0;
+
+    // Whole-model mode: preallocated buffer bound to a tensor
+    std::vector<float> m_buffer;
+    OrtValue* m_bufferTensor = nullptr;
+
+    std::vector<ParameterStats> m_stats;
+    std::chrono::steady_clock::time_point m_startTime;
+    double m_seconds = 0.0;
+    double m_baselineSeconds = 0.0;
+};
+
+#endif // TRAINING_TELEMETRY_H